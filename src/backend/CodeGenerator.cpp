@@ -12,13 +12,368 @@
 #include <QDomDocument>
 #include <QDomElement>
 #include <QRegularExpression>
-#include <csignal>
+#include <QSet>
+#include <algorithm>
 
 #include "fsm.hpp"
 #include "state.hpp"
 #include "transition.hpp"
 #include "variable.hpp"
 
+/**
+ * @brief Quote a string as a C++ string literal.
+ *
+ * @param text Text to quote.
+ * @return The escaped literal including the surrounding quotes.
+ */
+static QString cppStringLiteral(const QString& text) {
+    QString escaped = text;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n").replace("\r", "");
+    return "\"" + escaped + "\"";
+}
+
+/**
+ * @brief Get the input names of an FSM in a stable (sorted) order.
+ *
+ * The order defines the dense input indices used by the generated tables.
+ *
+ * @param fsm Pointer to the FSM.
+ * @return Sorted list of trimmed input names.
+ */
+static QStringList sortedInputNames(FSM* fsm) {
+    QStringList names;
+    for (const QString& input : fsm->getInputs()) {
+        names.append(input.trimmed());
+    }
+    names.sort();
+    return names;
+}
+
+/**
+ * @brief Get the output names of an FSM in a stable (sorted) order.
+ *
+ * The order defines the dense output indices used by the generated stores.
+ *
+ * @param fsm Pointer to the FSM.
+ * @return Sorted list of trimmed output names.
+ */
+static QStringList sortedOutputNames(FSM* fsm) {
+    QStringList names;
+    for (const QString& output : fsm->getOutputs()) {
+        names.append(output.trimmed());
+    }
+    names.sort();
+    return names;
+}
+
+/**
+ * @brief Find the end of a comment or a string or character literal.
+ *
+ * @param code User code of a state action or transition condition.
+ * @param i Position in the code, not inside an identifier.
+ * @return Position after the comment or literal starting at i, or i if none starts there.
+ */
+static int skipCommentOrLiteral(const QString& code, int i) {
+    if (code.midRef(i, 2) == QLatin1String("//")) {
+        int end = code.indexOf('\n', i + 2);
+        return end < 0 ? code.size() : end;
+    }
+    if (code.midRef(i, 2) == QLatin1String("/*")) {
+        int end = code.indexOf("*/", i + 2);
+        return end < 0 ? code.size() : end + 2;
+    }
+    if (code.midRef(i, 2) == QLatin1String("R\"")) {
+        int open = code.indexOf('(', i + 2);
+        QString close = ")" + code.mid(i + 2, open - i - 2) + "\"";
+        int end = open < 0 ? -1 : code.indexOf(close, open + 1);
+        return end < 0 ? code.size() : end + close.size();
+    }
+    if (i < code.size() && (code[i] == '"' || code[i] == '\'')) {
+        const QChar quote = code[i];
+        for (++i; i < code.size() && code[i] != quote; ++i) {
+            if (code[i] == '\\') ++i;
+        }
+        return qMin(i + 1, code.size());
+    }
+    return i;
+}
+
+/**
+ * @brief Rewrite helper calls with literal names to their interned ID overloads.
+ *
+ * valueof("in"), defined("in"), called("in") and output("out", ...) are rewritten to IN_ and OUT_ identifiers
+ * when the name is a known input or output, so the generated program indexes arrays instead of hashing strings.
+ * Calls with other arguments are kept and resolved by name at runtime. debug() calls are rewritten to FSM_DEBUG(),
+ * which leaves the message unbuilt while debugging is off and drops it altogether from release builds. Comments and
+ * string and character literals are copied unchanged.
+ *
+ * @param code User code of a state action or transition condition.
+ * @param inputs Input names of the FSM.
+ * @param outputs Output names of the FSM.
+ * @return The rewritten code.
+ */
+static QString internNames(const QString& code, const QStringList& inputs, const QStringList& outputs) {
+    static const QRegularExpression call(
+        "\\b(?:(valueof|defined|called)\\s*\\(\\s*\"(\\w+)\"\\s*\\)|output\\s*\\(\\s*\"(\\w+)\"\\s*,|"
+        "(?<![.:>])(debug)\\s*\\()");
+    QString result;
+    int last = 0;
+    int i = 0;
+    while (i < code.size()) {
+        int end = skipCommentOrLiteral(code, i);
+        if (end > i) {
+            i = end;
+            continue;
+        }
+        if (!code[i].isLetterOrNumber() && code[i] != '_') {
+            ++i;
+            continue;
+        }
+        // Calls are only matched where an identifier starts, so the name literal is the only one they consume
+        QRegularExpressionMatch match =
+            call.match(code, i, QRegularExpression::NormalMatch, QRegularExpression::AnchoredMatchOption);
+        if (!match.hasMatch()) {
+            while (i < code.size() && (code[i].isLetterOrNumber() || code[i] == '_')) ++i;
+            continue;
+        }
+        QString replacement = match.captured(0);
+        if (!match.captured(1).isEmpty() && inputs.contains(match.captured(2))) {
+            replacement = match.captured(1) + "(IN_" + match.captured(2) + ")";
+        } else if (!match.captured(3).isEmpty() && outputs.contains(match.captured(3))) {
+            replacement = "output(OUT_" + match.captured(3) + ",";
+        } else if (!match.captured(4).isEmpty()) {
+            replacement = "FSM_DEBUG(";
+        }
+        result += code.mid(last, match.capturedStart() - last) + replacement;
+        i = last = match.capturedEnd();
+    }
+    return result + code.mid(last);
+}
+
+/**
+ * @brief Get the states of an FSM in a stable order (sorted by name).
+ *
+ * The order defines the dense state indices used by the generated tables.
+ *
+ * @param fsm Pointer to the FSM.
+ * @return States sorted by their names.
+ */
+static QList<State*> sortedStates(FSM* fsm) {
+    QList<State*> states = fsm->getStates().values();
+    std::sort(states.begin(), states.end(), [](State* a, State* b) { return a->getName() < b->getName(); });
+    return states;
+}
+
+/**
+ * @brief Get the outgoing transitions of a state in transition table order.
+ *
+ * Transitions without a target or listening to an unknown input are left out. The rest are ordered by the
+ * index of their input, eventless transitions last; the sort is stable so transitions of the same input keep
+ * their definition order.
+ *
+ * @param fsm Pointer to the FSM.
+ * @param state Source state.
+ * @param inputs Sorted input names of the FSM.
+ * @return Pairs of (bucket, transition), the bucket being the input index or inputs.size() if eventless.
+ */
+static QList<QPair<int, Transition*>> tableTransitions(FSM* fsm, State* state, const QStringList& inputs) {
+    QList<QPair<int, Transition*>> bucketed;
+    for (Transition* transition : fsm->getTransitionsFrom(state)) {
+        QString event = transition->getEvent().trimmed();
+        if (!transition->getTo() || (!event.isEmpty() && !inputs.contains(event))) {
+            continue;
+        }
+        bucketed.append(qMakePair(event.isEmpty() ? inputs.size() : inputs.indexOf(event), transition));
+    }
+    std::stable_sort(bucketed.begin(), bucketed.end(),
+                     [](const QPair<int, Transition*>& a, const QPair<int, Transition*>& b) {
+                         return a.first < b.first;
+                     });
+    return bucketed;
+}
+
+/**
+ * @brief Check whether a transition needs a generated guard function.
+ * @param transition Transition to check.
+ * @return True if the transition has a condition.
+ */
+static bool hasGuard(Transition* transition) { return !transition->getCondition().trimmed().isEmpty(); }
+
+/**
+ * @brief Check whether a transition needs a generated delay function.
+ * @param transition Transition to check.
+ * @return True if the transition is delayed by a constant or a variable.
+ */
+static bool hasDelay(Transition* transition) {
+    return transition->isDelayedTransition() &&
+           (transition->getDelay() > 0 || !transition->getDelayVariableName().isEmpty());
+}
+
+/**
+ * @brief Split user code into C++ tokens, leaving out comments and the contents of string and character literals.
+ *
+ * @param code User code of a state action or transition condition.
+ * @return Identifiers, numbers, literals (as "") and operators in source order.
+ */
+static QStringList cppTokens(const QString& code) {
+    static const char* const operators[] = {"<<=", ">>=", "->", "::", "++", "--", "+=", "-=", "*=", "/=", "%=",
+                                            "&=",  "|=",  "^=", "<<", ">>", "==", "!=", "<=", ">=", "&&", "||"};
+    QStringList tokens;
+    int i = 0;
+    while (i < code.size()) {
+        QChar c = code[i];
+        int end = skipCommentOrLiteral(code, i);
+        if (c.isSpace()) {
+            ++i;
+        } else if (end > i) {
+            if (c != '/') {
+                tokens << "\"\"";
+            }
+            i = end;
+        } else if (c.isLetterOrNumber() || c == '_') {
+            int start = i;
+            while (i < code.size() && (code[i].isLetterOrNumber() || code[i] == '_')) ++i;
+            tokens << code.mid(start, i - start);
+        } else {
+            QString token = c;
+            for (const char* op : operators) {
+                if (code.midRef(i, static_cast<int>(qstrlen(op))) == QLatin1String(op)) {
+                    token = op;
+                    break;
+                }
+            }
+            i += token.size();
+            tokens << token;
+        }
+    }
+    return tokens;
+}
+
+/**
+ * @brief Find the custom variables a piece of user code can write.
+ *
+ * The analysis is conservative: a variable counts as written when it is assigned, incremented, read from a
+ * stream, has its address taken, has a member or subscript accessed, or is passed to a function other than the
+ * read-only helpers. Code binding a reference to anything counts as writing every variable it names.
+ *
+ * @param code User code of a state action or transition condition.
+ * @param variables Names of the custom variables.
+ * @return The written variables, in the order of variables.
+ */
+static QStringList writtenVariables(const QString& code, const QStringList& variables) {
+    static const QStringList assignments = {"=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>="};
+    static const QStringList accesses = {"++", "--", ".", "->", "["};
+    // Functions and keywords followed by a parenthesis that never modify what is passed to them
+    static const QStringList readOnly = {"if", "while", "for", "switch", "return", "sizeof", "valueof", "defined",
+                                         "called", "output", "log", "debug", "Qtoi", "atoi", "number", "arg",
+                                         "QString", "QVariant", "qMin", "qMax", "qAbs", "abs", "to_string",
+                                         "static_cast"};
+    QStringList tokens = cppTokens(code);
+    QSet<QString> written;
+    QSet<QString> named;
+    bool bindsReference = false;
+    QStringList calls;  // Function owning every open parenthesis, empty for grouping and brackets
+    for (int i = 0; i < tokens.size(); ++i) {
+        const QString& token = tokens[i];
+        QString before = i > 0 ? tokens[i - 1] : QString();
+        QString after = i + 1 < tokens.size() ? tokens[i + 1] : QString();
+        if (token == "(" || token == "[" || token == "{") {
+            bool call = token == "(" && !before.isEmpty() && (before[0].isLetter() || before[0] == '_');
+            calls << (call ? before : QString(token == "(" ? "" : token));
+            continue;
+        }
+        if ((token == ")" || token == "]" || token == "}") && !calls.isEmpty()) {
+            calls.removeLast();
+            continue;
+        }
+        if (token == "&" && (after.isEmpty() || after[0].isLetter() || after[0] == '_') && i + 2 < tokens.size() &&
+            (tokens[i + 2] == "=" || tokens[i + 2] == "{" || tokens[i + 2] == "(")) {
+            bindsReference = true;
+        }
+        if (!variables.contains(token)) {
+            continue;
+        }
+        // this->name is the variable, other.name and Scope::name are not
+        if (before == "->" && i > 1 && tokens[i - 2] == "this") {
+            before = i > 2 ? tokens[i - 3] : QString();
+        } else if (before == "." || before == "->" || before == "::") {
+            continue;
+        }
+        named.insert(token);
+        bool argument = (before == "(" || before == ",") && !calls.isEmpty() && !calls.last().isEmpty() &&
+                        calls.last() != "{" && calls.last() != "[" && !readOnly.contains(calls.last());
+        if (assignments.contains(after) || accesses.contains(after) || before == "++" || before == "--" ||
+            before == "&" || before == ">>" || argument) {
+            written.insert(token);
+        }
+    }
+    QStringList result;
+    for (const QString& variable : variables) {
+        if (written.contains(variable) || (bindsReference && named.contains(variable))) {
+            result << variable;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Get the names of the custom variables of an FSM, in declaration order.
+ * @param fsm Pointer to the FSM.
+ * @return Variable names.
+ */
+static QStringList variableNames(FSM* fsm) {
+    QStringList names;
+    for (Variable* var : fsm->getVariables()) {
+        names << var->getName();
+    }
+    return names;
+}
+
+/**
+ * @brief Get the variables any state action or transition condition of an FSM can write.
+ *
+ * Only these get a shadow copy and change checks, the others keep their initial value.
+ *
+ * @param fsm Pointer to the FSM.
+ * @return Written variable names, in declaration order.
+ */
+static QStringList trackedVariables(FSM* fsm) {
+    QStringList variables = variableNames(fsm);
+    QSet<QString> written;
+    for (State* state : fsm->getStates()) {
+        for (const QString& name : writtenVariables(state->getCode(), variables)) {
+            written.insert(name);
+        }
+        for (Transition* transition : fsm->getTransitionsFrom(state)) {
+            for (const QString& name : writtenVariables(transition->getCondition(), variables)) {
+                written.insert(name);
+            }
+        }
+    }
+    QStringList tracked;
+    for (const QString& variable : variables) {
+        if (written.contains(variable)) {
+            tracked << variable;
+        }
+    }
+    return tracked;
+}
+
+/**
+ * @brief Emit the change checks run after a guard or state action.
+ *
+ * @param written Variables the guard or action can write.
+ * @param indent Indentation of the emitted lines.
+ * @return One trackChange() call per variable.
+ */
+static QString changeChecks(const QStringList& written, const QString& indent) {
+    QString code;
+    for (const QString& name : written) {
+        code += indent + "trackChange(VAR_" + name + ", " + name + ", shadow_" + name + ");\n";
+    }
+    return code;
+}
+
 CodeGenerator::CodeGenerator(QObject* parent) : QObject(parent) {}
 
 QString CodeGenerator::generateCode(FSM* fsm) {
@@ -36,13 +391,20 @@ QString CodeGenerator::generateCode(FSM* fsm) {
         * This file was automatically generated by the code generator 
         *
         * compile (for example) with: 
-        * g++ -std=c++17 -fPIC mycpp.cpp -o myfsm $(pkg-config --cflags --libs Qt5Core Qt5Network Qt5Xml)
+        * g++ -std=c++17 -fPIC -rdynamic mycpp.cpp -I src/runtime build/libfsm-runtime.a -ldl -pthread -o myfsm $(pkg-config --cflags --libs Qt5Core Qt5Network Qt5Xml)
+        *
+        * or as a module a running myfsm can load with /reload mycpp.so:
+        * g++ -std=c++17 -fPIC -shared -fvisibility=hidden -DFSM_MODULE mycpp.cpp -I src/runtime -o mycpp.so $(pkg-config --cflags --libs Qt5Core)
+        *
+        * without debug logging (-DFSM_RELEASE, linked against the release runtime):
+        * g++ -std=c++17 -O2 -DFSM_RELEASE -fPIC -rdynamic mycpp.cpp -I src/runtime build/libfsm-runtime-release.a -ldl -pthread -o myfsm $(pkg-config --cflags --libs Qt5Core Qt5Network Qt5Xml)
+        *
+        * several machines build into one program with make gen UNITY=1, make gen RELEASE=1 builds them without debug logging
         * 
         * */)cpp";
     code += generateHeaders();
+    code += generateMachineIds(fsm);
     code += generateVariableDeclarations(fsm);
-    code += generateRuntimeMonitoring();
-    code += generateHelperFunctions(fsm);
     code += generateMainFunction(fsm);
 
     return code;
@@ -50,345 +412,83 @@ QString CodeGenerator::generateCode(FSM* fsm) {
 
 QString CodeGenerator::generateHeaders() {
     return R"cpp(
-#include <QtCore/QDebug>
-#include <QtCore/QString>
-#include <QtCore/QMap>
-#include <QtCore/QDateTime>
-#include <QtCore/QCoreApplication>
-#include <QtCore/QTimer>
-#include <QtCore/QSocketNotifier>
-#include <QtCore/QStateMachine>
-#include <QtCore/QState>
-#include <QtCore/QEvent>
-#include <QtCore/QAbstractTransition>
-#include <QtCore/QRegularExpression>
-#include <QtNetwork/QTcpServer>
-#include <QtNetwork/QTcpSocket>
-#include <QtXml/QDomDocument>
-#include <QtXml/QDomElement>
-#include <QtCore/QFile>
-#include <QtCore/QDir>
-#include <stdio.h>
-#include <unistd.h>
-#include <csignal>
-#include <functional>
+#include "FsmRuntime.hpp"
+
+// A unity build includes several machines in one file, each in a namespace of its own
+#ifndef FSM_NAMESPACE
+#define FSM_NAMESPACE fsm_machine
+#endif
+
+namespace FSM_NAMESPACE {
     )cpp";
 }
 
-QString CodeGenerator::generateHelperFunctions(FSM* fsm) {
-    QString code;
-
-    code +=
+QString CodeGenerator::generateMachineIds(FSM* fsm) {
+    QString code =
         R"cpp(
         /******************************************************************************
-         * Utility functions for input/output and value handling
+         * Machine identifiers
          ******************************************************************************/
 
-        /**
-         * @brief Builds a QByteArray needed for the TCP communication.
-         * @param eventString The event as a QString (XML or plain text).
-         * @return QByteArray ready to send via TCP.
-         */
-        QByteArray buildEvent(const QString& eventString) { return (eventString + "\n").toUtf8(); }
-
-        /**
-         * @brief Gets the value of an input.
-         * @param input Input name.
-         * @return Current value of the input as a string, or empty if not
-         * found.
-         */
-        QString valueof(const QString& input) {
-            if (inputs.contains(input)) {
-                return inputs[input];
-            }
-            return QString();
-        }
-
-        /**
-         * @brief Converts a QString to an integer.
-         * @param str String to convert.
-         * @return Integer value, or 0 if conversion fails.
-         */
-        int Qtoi(const QString& str) {
-            bool ok = false;
-            int value = str.toInt(&ok);
-            return ok ? value : 0;
-        }
-
-        /**
-         * @brief Checks if an input is defined and has a non-empty value.
-         * @param input Input name to check.
-         * @return True if the input exists and has a value.
-         */
-        bool defined(const QString& input) { return inputs.contains(input) && !inputs[input].isEmpty(); }
-
-        /**
-         * @brief Sends an output value.
-         * @param port Output destination.
-         * @param value Value to send (any type supported by QVariant).
-         */
-        void output(const QString& port, const QVariant& value) {
-            QString valueStr = value.toString();
-            debug(QString("output('%1', %2)").arg(port).arg(valueStr));
-            outputs[port] = valueStr;
-            logOutputEvent(port, outputs[port]);
-
-            extern QSet<QTcpSocket*> clientSockets;
-            for (QTcpSocket* clientSocket : clientSockets) {
-                if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                    QDomDocument doc;
-                    QDomElement element = doc.createElement("event");
-                    element.setAttribute("type", "output");
-
-                    QDomElement name = doc.createElement("name");
-                    name.appendChild(doc.createTextNode(port));
-                    QDomElement valueElem = doc.createElement("value");
-                    valueElem.appendChild(doc.createTextNode(valueStr));
-                    element.appendChild(name);
-                    element.appendChild(valueElem);
-
-                    doc.appendChild(element);
-                    clientSocket->write(buildEvent(doc.toString(-1)));
-                    clientSocket->flush();
-                    debug(QString("output(): sent event to client: %1").arg(doc.toString(-1)));
-                }
-            }
-        }
-
-        /**
-         * @brief Returns time elapsed since state entry in milliseconds.
-         * @return Milliseconds elapsed since entering the current state.
-         */
-        int elapsed() {
-            if (fsm.configuration().isEmpty()) {
-                return 0;
-            }
-            QState* currentState = static_cast<QState*>(*fsm.configuration().begin());
-            QVariant entryTimeVar = currentState->property("entryTime");
-            if (!entryTimeVar.isValid() || !entryTimeVar.canConvert<qint64>()) {
-                debug(
-                    "elapsed(): entryTime property is invalid or not a "
-                    "qint64");
-                return 0;
-            }
-            qint64 entryTime = entryTimeVar.toLongLong();
-            qint64 now = QDateTime::currentDateTime().toMSecsSinceEpoch();
-            int diff = static_cast<int>(now - entryTime);
-            debug(QString("elapsed(): entryTime=%1, now=%2, diff=%3").arg(entryTime).arg(now).arg(diff));
-            return diff;
-        }
-
-        // Shared event flags for tracking input calls
-        QMap<QString, bool>& getEventFlags() {
-            static QMap<QString, bool> flags;
-            return flags;
-        }
-
-        /**
-         * @brief Checks if an input was called as an event (regardless of
-         * value).
-         * @param input Input name to check.
-         * @return True if the input was triggered as an event.
-         */
-        bool called(const QString& input) {
-            QMap<QString, bool>& eventFlags = getEventFlags();
-            bool result = eventFlags.value(input, false);
-            debug(QString("called('%1') returning %2").arg(input).arg(result ? "true" : "false"));
-            eventFlags[input] = false;
-            return result;
-        }
-
-        /**
-         * @brief Sets the trigger flag for an input.
-         * @param input Input name to mark as called.
-         */
-        void setInputCalled(const QString& input) {
-            QMap<QString, bool>& eventFlags = getEventFlags();
-            eventFlags[input] = true;
-        }
-
-        /**
-         * @brief Sends a timer event to the client.
-         * @param type 'timerStart' or 'timerExpired'.
-         * @param from Source state name.
-         * @param to Target state name.
-         * @param ms Optional ms value for timerStart.
-         */
-        void sendTimerEvent(const QString& type, const QString& from, const QString& to, int ms = -1) {
-            extern QSet<QTcpSocket*> clientSockets;
-            for (QTcpSocket* clientSocket : clientSockets) {
-                if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                    if (type == "timerStart") {
-                        clientSocket->write(buildEvent(QString("<event "
-                                                               "type=\"timerStart\"><from>%1</from><to>%2</"
-                                                               "to><ms>%3</ms></event>")
-                                                           .arg(from)
-                                                           .arg(to)
-                                                           .arg(ms)));
-                    } else if (type == "timerExpired") {
-                        clientSocket->write(buildEvent(QString("<event "
-                                                               "type=\"timerExpired\"><from>%1</"
-                                                               "from><to>%2</to></event>")
-                                                           .arg(from)
-                                                           .arg(to)));
-                    }
-                    clientSocket->flush();
-                }
-            }
-            QPair<QString, QString> timerKey = qMakePair(from, to);
-            timers[timerKey] = qMakePair(QDateTime::currentMSecsSinceEpoch(), ms);
-        }
-
-        /**
-         * @brief Broadcasts a shutdown event to all connected clients.
-         * @param message Optional shutdown message.
-         */
-        void broadcastShutdownEvent(const QString& message =
-                                        "Server is shutting down. All client connections will be "
-                                        "closed. Please "
-                                        "save your work and reconnect later.") {
-            for (QTcpSocket* clientSocket : clientSockets) {
-                if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                    QString shutdownMsg = QString(
-                                              "<event "
-                                              "type=\"shutdown\"><message>%1</message></event>")
-                                              .arg(message);
-                    clientSocket->write(buildEvent(shutdownMsg));
-                    clientSocket->flush();
-                }
-            }
-        }
-
-        void cleanupSocket(QTcpSocket* socket) {
-            if (!socket) {
-                return;
-            }
-            debug(QString("cleanupSocket: removing and deleting socket %1").arg(reinterpret_cast<quintptr>(socket)));
-            if (clientSockets.contains(socket)) {
-                clientSockets.remove(socket);
-            }
-            if (awaitingPong.contains(socket)) {
-                awaitingPong.remove(socket);
-            }
-            if (pingTimers.contains(socket)) {
-                QTimer* t = pingTimers.take(socket);
-                if (t) {
-                    t->stop();
-                    t->deleteLater();
-                }
-            }
-            socket->deleteLater();
-        }
-
-        void closeAndCleanupAllSockets() {
-            auto socketsCopy = clientSockets;
-            for (QTcpSocket* socket : socketsCopy) {
-                cleanupSocket(socket);
-            }
-            clientSockets.clear();
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
-        }
         )cpp";
 
-    code += R"cpp(
-        QString generateStatusXml(const QString& state) {
-            QDomDocument doc;
-            QDomElement eventElem = doc.createElement("event");
-            eventElem.setAttribute("type", "status");
-            QDomElement root = doc.createElement("status");
-            eventElem.appendChild(root);
-            doc.appendChild(eventElem);
-
-            QDomElement stateElem = doc.createElement("state");
-            stateElem.appendChild(doc.createTextNode(state));
-            root.appendChild(stateElem);
+    QList<State*> states = sortedStates(fsm);
+    code += "// Dense state indices used by the dispatch tables\n";
+    code += "enum StateId {\n";
+    for (State* state : states) {
+        code += "    S_" + state->getName() + ",\n";
+    }
+    code += "    STATE_COUNT\n};\n";
+    code += "const char* const kStateNames[STATE_COUNT + 1] = {";
+    for (State* state : states) {
+        code += cppStringLiteral(state->getName()) + ", ";
+    }
+    code += "nullptr};\n\n";
 
-            QDomElement inputsElem = doc.createElement("inputs");
-            for (auto it = inputs.constBegin(); it != inputs.constEnd(); ++it) {
-                QDomElement inputElem = doc.createElement("input");
-                inputElem.setAttribute("name", it.key());
-                inputElem.appendChild(doc.createTextNode(it.value()));
-                inputsElem.appendChild(inputElem);
-            }
-            root.appendChild(inputsElem);
+    QStringList inputs = sortedInputNames(fsm);
+    code += "// Dense input indices, input events are dispatched by index\n";
+    code += "enum InputId {\n";
+    for (const QString& input : inputs) {
+        code += "    IN_" + input + ",\n";
+    }
+    code += "    INPUT_COUNT,\n    NO_EVENT = -1\n};\n";
+    code += "const char* const kInputNames[INPUT_COUNT + 1] = {";
+    for (const QString& input : inputs) {
+        code += cppStringLiteral(input) + ", ";
+    }
+    code += "nullptr};\n\n";
 
-            QDomElement outputsElem = doc.createElement("outputs");
-            for (auto it = outputs.constBegin(); it != outputs.constEnd(); ++it) {
-                QDomElement outputElem = doc.createElement("output");
-                outputElem.setAttribute("name", it.key());
-                outputElem.appendChild(doc.createTextNode(it.value()));
-                outputsElem.appendChild(outputElem);
-            }
-            root.appendChild(outputsElem);
+    QStringList outputs = sortedOutputNames(fsm);
+    code += "// Dense output indices\n";
+    code += "enum OutputId {\n";
+    for (const QString& output : outputs) {
+        code += "    OUT_" + output + ",\n";
+    }
+    code += "    OUTPUT_COUNT,\n    NO_OUTPUT = -1\n};\n";
+    code += "const char* const kOutputNames[OUTPUT_COUNT + 1] = {";
+    for (const QString& output : outputs) {
+        code += cppStringLiteral(output) + ", ";
+    }
+    code += "nullptr};\n\n";
 
-            QDomElement varsElem = doc.createElement("variables");
-    )cpp";
     QMap<QString, Variable*> variables = fsm->getVariables();
-    for (auto it = variables.constBegin(); it != variables.constEnd(); ++it) {
-        Variable* var = it.value();
-        QString varName = var->getName();
-        QString varType = var->getType();
-        code += "  { QDomElement varElem = doc.createElement(\"var\");\n";
-        code += "    varElem.setAttribute(\"name\", \"" + varName + "\");\n";
-        code += "    varElem.setAttribute(\"type\", \"" + varType + "\");\n";
-        code += "    varElem.appendChild(doc.createTextNode(QVariant::fromValue(" + varName + ").toString()));\n";
-        code += "    varsElem.appendChild(varElem);\n";
-        code += "  }\n";
+    code += "// Dense variable indices\n";
+    code += "enum VariableId {\n";
+    for (Variable* var : variables) {
+        code += "    VAR_" + var->getName() + ",\n";
     }
-    code += R"cpp(
-        root.appendChild(varsElem);
-        QDomElement timersElem = doc.createElement("timers");
-        extern QMap<QPair<QString, QString>, QPair<qint64, int>> timers;
-        for (auto it = timers.constBegin(); it != timers.constEnd(); ++it) {
-            int ms = it.value().second;
-            if (ms < 0) {
-                continue;
-            }
-            QString from = it.key().first;
-            QString to = it.key().second;
-            QDomElement timerElem = doc.createElement("timer");
-            QDomElement fromElem = doc.createElement("from");
-            fromElem.appendChild(doc.createTextNode(from));
-            QDomElement toElem = doc.createElement("to");
-            toElem.appendChild(doc.createTextNode(to));
-            QDomElement msElem = doc.createElement("ms");
-            msElem.appendChild(doc.createTextNode(QString::number(ms)));
-            timerElem.appendChild(fromElem);
-            timerElem.appendChild(toElem);
-            timerElem.appendChild(msElem);
-            timersElem.appendChild(timerElem);
-        }
-        root.appendChild(timersElem);
-
-        return doc.toString(-1);
-        }
-
-        /**
-         * @brief Sends an error response to the client.
-         * @param code Error code.
-         * @param msg Error message.
-         * @param socket Client socket to send the error to.
-         */
-        void sendError(int code, const QString& msg, QTcpSocket* socket) {
-            if (!socket) return;
-            QString error = QString(
-                                "<event "
-                                "type=\"error\"><code>%1</"
-                                "code><message>%2</message></event>")
-                                .arg(code)
-                                .arg(msg.toHtmlEscaped());
-            socket->write(buildEvent(error));
-            socket->flush();
-        }
+    code += "    VARIABLE_COUNT\n};\n";
+    code += "const char* const kVariableNames[VARIABLE_COUNT + 1] = {";
+    for (Variable* var : variables) {
+        code += cppStringLiteral(var->getName()) + ", ";
+    }
+    code += "nullptr};\n\n";
 
-        // Error codes for TCP XML protocol
-        enum FsmErrorCode {
-            ERR_UNKNOWN_INPUT = 21,
-            ERR_UNKNOWN_COMMAND = 10,
-            ERR_MALFORMED_XML = 11,
-            ERR_INTERNAL = 99,
-        };
-    )cpp";
+    int transitionCount = 0;
+    for (State* state : states) {
+        transitionCount += tableTransitions(fsm, state, inputs).size();
+    }
+    code += "constexpr int TRANSITION_COUNT = " + QString::number(transitionCount) + ";\n";
 
     return code;
 }
@@ -397,19 +497,16 @@ QString CodeGenerator::generateVariableDeclarations(FSM* fsm) {
     QString code =
         R"cpp(
         /******************************************************************************
-         * Variable declarations
+         * Machine context
          ******************************************************************************/
 
-        QStateMachine fsm;               // Global state machine instance
-        QMap<QString, QString> inputs;   // Map of input names to values
-        QMap<QString, QString> outputs;  // Map of output names to values
-        bool debugEnabled = false;
-        QSet<QTcpSocket*> clientSockets;
-        QMap<QString, QVariant> variables;
-        QMap<QPair<QString, QString>, QPair<qint64, int>> timers;  // [(from,to),(startime,duration)]
-        QMap<QTcpSocket*, QTimer*> pingTimers;                     // Tracks pingpong keepalive timers per client
-        QSet<QTcpSocket*> awaitingPong;                            // Tracks clients waiting for pong
-        QMap<QString, QVariant> internalVariables;  // Remembers variable values to send events in case they change
+        /**
+         * @brief Custom variables and code of one hosted copy of the machine.
+         *
+         * Guards, delays and state actions are member functions, so user code keeps referring to its variables
+         * by name. The runtime library reaches them through the MachineContext overrides.
+         */
+        struct Machine final : MachineContext {
         )cpp";
 
     QMap<QString, Variable*> variables = fsm->getVariables();
@@ -421,941 +518,257 @@ QString CodeGenerator::generateVariableDeclarations(FSM* fsm) {
         }
         code += "\n";
     }
-    return code;
-}
-
-QString CodeGenerator::generateRuntimeMonitoring() {
-    return R"cpp(
-        /******************************************************************************
-         * Runtime monitoring and debugging
-         ******************************************************************************/
-
-        const QString ANSI_RESET = "\033[0m";
-        const QString ANSI_BOLD = "\033[1m";
-
-        // Semantic Color Mappings
-        const QString COLOR_STATE = "\033[38;5;93m";       // Purple
-        const QString COLOR_TRANSITION = "\033[38;5;39m";  // Blueish
-        const QString COLOR_SOURCE = "\033[38;5;102m";     // Gray
-        const QString COLOR_TARGET = "\033[38;5;84m";      // Green
-        const QString COLOR_COMMAND = "\033[38;5;231m";    // Whitish
-        const QString COLOR_INPUT = "\033[38;5;75m";       // Cyan
-        const QString COLOR_VALUE = "\033[38;5;153m";      // Light Blue
-        const QString COLOR_HEADER = "\033[38;5;141m";     // Dark Purple
-
-        // Status & Logging Colors
-        const QString COLOR_INFO = "\033[38;5;39m";      // Blue
-        const QString COLOR_NOTICE = "\033[38;5;102m";   // Grayish
-        const QString COLOR_WARNING = "\033[38;5;220m";  // Yellow
-        const QString COLOR_ERROR = "\033[38;5;196m";    // Red
-        const QString COLOR_SUCCESS = "\033[38;5;84m";   // Greener
-
-        // Timeout Specific Colors
-        const QString TIMEOUT_STARTED = "\033[38;5;177m";  // Pinkish
-        const QString TIMEOUT_EXPIRED = "\033[38;5;213m";  // Magenta
-
-        const QString STATE_HEADER = ANSI_BOLD + COLOR_STATE + "════════ STATE: " + ANSI_RESET;
-        const QString COMMAND_HEADER = ANSI_BOLD + COLOR_COMMAND + "⟫ COMMAND: " + ANSI_RESET;
-        const QString SECTION_SEPARATOR = COLOR_NOTICE + "───────────────────────────────────────────────────" + ANSI_RESET;
-        const QString DOUBLE_SEPARATOR = COLOR_TRANSITION + "═══════════════════════════════════════════════════" + ANSI_RESET;
-
-        /**
-         * @brief Prints a log message.
-         * @param message Log message to display.
-         */
-        void log(const QString& message) {
-            QString timeStr = QDateTime::currentDateTime().toString(
-                "HH:mm:"
-                "ss.zzz");
-            qDebug().noquote() << "[" << timeStr << "]" << message;
-        }
-
-        /**
-         * @brief Logs input values for monitoring.
-         * @param input Input name.
-         * @param value Input value.
-         */
-        void logInputEvent(const QString& input, const QString& value) {
-            log("Input value: " + ANSI_BOLD + input + ANSI_RESET + " = " + COLOR_VALUE + value + ANSI_RESET);
-        }
-
-        /**
-         * @brief Logs output values for monitoring.
-         * @param output Output name.
-         * @param value Output value.
-         */
-        void logOutputEvent(const QString& output, const QString& value) {
-            log("Output value: " + ANSI_BOLD + output + ANSI_RESET + " = " + COLOR_VALUE + value + ANSI_RESET);
+    QStringList tracked = trackedVariables(fsm);
+    if (!tracked.isEmpty()) {
+        code += "// Last reported values of the variables the guards and state actions write\n";
+        for (const QString& name : tracked) {
+            code += "decltype(" + name + ") shadow_" + name + " = " + name + ";\n";
         }
+        code += "\n";
+    }
 
-        /**
-         * @brief Prints a debug message if debugEnabled is true.
-         * @param message Debug message to display.
-         */
-        void debug(const QString& message) {
-            if (!debugEnabled) return;
-            QString timeStr = QDateTime::currentDateTime().toString(
-                "HH:mm:"
-                "ss.zzz");
-            QString prefix = COLOR_INFO + "• DEBUG" + ANSI_RESET + ": ";
-            qDebug().noquote() << "[" << timeStr << "]" << prefix << message;
+    QStringList inputs = sortedInputNames(fsm);
+    code += "// State actions and transition functions, defined with the transition table\n";
+    int index = 0;
+    for (State* state : sortedStates(fsm)) {
+        if (!state->getCode().isEmpty()) {
+            code += "void onEntry_" + state->getName() + "();\n";
         }
-
-        /**
-         * @brief Displays all available commands and valid inputs.
-         * @param fsmName Name of the FSM.
-         * @param fsmDescription Description of the FSM.
-         * @param validInputs Set of valid input names.
-         * @param helpLines List of command descriptions to display.
-         */
-        void showHelp(const QString& fsmName, const QString& fsmDescription, const QSet<QString>& validInputs,
-                      const QStringList& helpLines) {
-            log(DOUBLE_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "Machine: " + ANSI_RESET + COLOR_STATE + fsmName + ANSI_RESET);
-            if (!fsmDescription.isEmpty()) {
-                log(fsmDescription);
-            }
-            log(DOUBLE_SEPARATOR);
-            log(ANSI_BOLD + COLOR_COMMAND + "AVAILABLE COMMANDS:" + ANSI_RESET);
-            for (const QString& line : helpLines) {
-                log(line);
+        for (const QPair<int, Transition*>& entry : tableTransitions(fsm, state, inputs)) {
+            if (hasGuard(entry.second)) {
+                code += "bool guard_" + QString::number(index) + "();\n";
             }
-            log(SECTION_SEPARATOR);
-            if (!validInputs.isEmpty()) {
-                log(ANSI_BOLD + COLOR_INPUT + "VALID INPUTS:" + ANSI_RESET);
-                QStringList sortedInputs = validInputs.values();
-                sortedInputs.sort();
-                for (const QString& input : sortedInputs) {
-                    log("  " + COLOR_INPUT + input + ANSI_RESET);
-                }
+            if (hasDelay(entry.second)) {
+                code += "int delay_" + QString::number(index) + "();\n";
             }
-            log(SECTION_SEPARATOR);
-        }
-    )cpp";
-}
-
-QString CodeGenerator::generateTransitionCode(Transition* transition, const State* sourceState,
-                                              const State* targetState) {
-    QString code;
-    QString sourceName = const_cast<State*>(sourceState)->getName();
-    QString targetName = const_cast<State*>(targetState)->getName();
-
-    QString condition = transition->getCondition();
-    QString event = transition->getEvent();
-
-    int delay = transition->isDelayedTransition() ? transition->getDelay() : 0;
-    bool hasCondition = !condition.isEmpty();
-    bool hasEvent = !event.isEmpty();
-    bool hasDelay = delay > 0 || (!transition->getDelayVariableName().isEmpty() && transition->isDelayedTransition());
-
-    static int transitionCounter = 0;
-    QString transName = sourceName + "_to_" + targetName + "_transition" + QString::number(++transitionCounter);
-
-    code += " // Create transition: " + sourceName + " → " + targetName;
-    if (hasEvent || hasCondition || hasDelay) {
-        code += " (";
-        if (hasEvent) {
-            code += "event: " + event;
+            ++index;
         }
-        if (hasCondition) {
-            if (hasEvent) code += ", ";
-            code += "[ " + condition + " ]";
-        }
-        if (hasDelay) {
-            if (hasEvent || hasCondition) code += " ";
-            if (!transition->getDelayVariableName().isEmpty())
-                code += "@ " + transition->getDelayVariableName();
-            else
-                code += "@ " + QString::number(delay) + "ms";
-        }
-        code += ")";
-    }
-    code += "\n";
-
-    QString delayProvider;
-    if (transition->isDelayedTransition() && !transition->getDelayVariableName().isEmpty()) {
-        const QString varName = transition->getDelayVariableName();
-        delayProvider = "[]() -> int { return " + varName + "; }";
-    } else if (hasDelay) {
-        delayProvider = "[]() -> int { return " + QString::number(delay) + "; }";
-    } else {
-        delayProvider = "[]() -> int { return 0; }";
-    }
-
-    code += "    GeneratedTransition* " + transName + " = new GeneratedTransition(";
-    if (hasEvent && hasCondition) {
-        code += "[]() -> bool {\n";
-        code += "        return called(\"" + event + "\") && (" + condition + ");\n";
-        code += "    }";
-    } else if (hasEvent) {
-        code += "[]() -> bool {\n";
-        code += "        return called(\"" + event + "\");\n";
-        code += "    }";
-    } else if (hasCondition) {
-        code += "[]() -> bool {\n";
-        code += "        return " + condition + ";\n";
-        code += "    }";
-    } else {
-        code += "[]() { return true; }";
     }
-    code += ", " + delayProvider;
-    code += ", \"" + sourceName + "\", \"" + targetName + "\"";
-    code += ");\n";
-    code += "    " + sourceName + "State->addTransition(" + transName + ");\n";
-    code += "    " + transName + "->setTargetState(" + targetName + "State);\n\n";
+    code += R"cpp(
+            bool guard(int transition) override;
+            int delay(int transition) override;
+            void onEntry(int state) override;
+            QVariant variable(int variable) const override;
+            void setVariable(int variable, const QVariant& value) override;
+        };
+        )cpp";
     return code;
 }
 
-QString CodeGenerator::generateMainFunction(FSM* fsm) {
-    QString code;
-
-    code += R"cpp(
-        /************************************************************************
-         * Classes and Main function
-         ***********************************************************************/
-    )cpp";
-
-    code += generateInputEventClass();
-    code += generateGeneratedTransitionClass();
-
-    code +=
+QString CodeGenerator::generateStateActions(FSM* fsm) {
+    QString code =
         R"cpp(
-        void clearOutgoingTimers(const QString& stateName) {
-            debug(QString("clearOutgoingTimers('%1')").arg(stateName));
-            // Iterate all transitions and reset timers for outgoing
-            // transitions from the given state.
-            for (QAbstractTransition* t : fsm.findChildren<QAbstractTransition*>()) {
-                auto ut = dynamic_cast<GeneratedTransition*>(t);
-                if (!ut) continue;
-                const QString& from = ut->fromStateName();
-                const QString& to = ut->toStateName();
-                if (from == stateName && from != to) {
-                    ut->resetTimerArmed();
-                    ut->stopTimer();
-                    debug(QString("Stopped timer and reset for transition %1 → %2").arg(from, to));
-                }
-            }
-        }
+        /******************************************************************************
+         * State actions
+         ******************************************************************************/
         )cpp";
 
-    State* initial = fsm->getInitialState();
-    QMap<QString, State*> allStates = fsm->getStates();
-
-    QString initialStateName = initial ? initial->getName() : "UNKNOWN";
-
-    code +=
-        QString(
-            R"cpp(
-                /**
-                 * @brief Main function that uses QStateMachine for state management.
-                 */
-                int main(int argc, char* argv[]) {
-                    QCoreApplication app(argc, argv);
-                    QTcpServer server;
-                    const char* FSM_XML = R"xml(%1)xml";
-
-                    // --host and --port arguments
-                    QString hostStr = "127.0.0.1";
-                    quint16 port = 54323;
-                    for (int i = 1; i < argc; ++i) {
-                        QString arg = argv[i];
-                        if (arg == "--host" && i + 1 < argc) {
-                            hostStr = argv[++i];
-                        } else if (arg == "--port" && i + 1 < argc) {
-                            bool ok = false;
-                            int p = QString(argv[++i]).toInt(&ok);
-                            if (ok && p > 1024 && p < 65536) {
-                                port = static_cast<quint16>(p);
-                            }
-                        }
-                    }
-                    QHostAddress hostAddr;
-                    if (!hostAddr.setAddress(hostStr)) {
-                        log("Invalid host address specified, defaulting to 127.0.0.1");
-                        hostAddr = QHostAddress::LocalHost;
-                    }
-
-                    qDebug().noquote() << "\n" + DOUBLE_SEPARATOR;
-                    qDebug().noquote() << ANSI_BOLD + COLOR_HEADER + "✧ ✧ ✧  OBLIVION STATE MACHINE  ✧ ✧ ✧" + ANSI_RESET;
-                    qDebug().noquote() << COLOR_TRANSITION + "     we looove finite state machines (｡◕‿‿◕｡)" + ANSI_RESET;
-                    qDebug().noquote() << DOUBLE_SEPARATOR + "\n";
-
-                    debug("Starting FSM application with QStateMachine");
-                    debug("State machine name: " + ANSI_BOLD + COLOR_STATE + "%2" + ANSI_RESET);
-
-                    std::signal(SIGINT, [](int) {
-                        log(DOUBLE_SEPARATOR);
-                        log(ANSI_BOLD + COLOR_WARNING + "SIGINT (Ctrl+C) recieved. Exiting application." + ANSI_RESET);
-                        log(DOUBLE_SEPARATOR);
-                        broadcastShutdownEvent(
-                            "Server is shutting down due to SIGINT (Ctrl+C). All clients will be disconnected.");
-                        closeAndCleanupAllSockets();
-                        QCoreApplication::quit();
-                    });
-            )cpp")
-            .arg(fsm->getInitialFSMXML(), fsm->getName());
-
-    QSet<QString> inputNames = fsm->getInputs();
-    QSet<QString> outputNames = fsm->getOutputs();
-
-    code += " // Initialize inputs and outputs\n";
-    for (const QString& input : inputNames) {
-        code += " inputs[QStringLiteral(\"" + input.trimmed() + "\")] = QString();\n";
-        code += " getEventFlags()[QStringLiteral(\"" + input.trimmed() + "\")] = false;\n";
-    }
-
-    for (const QString& output : outputNames) {
-        code += " outputs[QStringLiteral(\"" + output.trimmed() + "\")] = QString();\n";
-    }
-
-    QMap<QString, Variable*> variables = fsm->getVariables();
-    for (auto it = variables.constBegin(); it != variables.constEnd(); ++it) {
-        QString varName = it.value()->getName();
-        code += " internalVariables[QStringLiteral(\"" + varName + "\")] = QVariant(" + varName + ");\n";
-        code += " log(\"Internal variable: " + varName + " = \" + internalVariables[QStringLiteral(\"" + varName +
-                "\")].toString());\n";
-    }
-    code += "\n";
-
-    code += " QSet<QString> validInputNames;\n";
-    for (const QString& input : inputNames) {
-        code += " validInputNames.insert(QStringLiteral(\"" + input.trimmed() + "\"));\n";
-    }
-    code += "\n";
-
-    code += " fsm.setObjectName(\"" + fsm->getName() + "\");\n\n";
-    code += " fsm.setProperty(\"description\", \"" + fsm->getComment() + "\");\n\n";
-
-    code += " debug(\"Creating states...\");\n";
-
-    code += " static QString globalPrevStateName;\n";
-    for (auto it = allStates.begin(); it != allStates.end(); ++it) {
-        State* state = it.value();
+    QStringList inputs = sortedInputNames(fsm);
+    QStringList outputs = sortedOutputNames(fsm);
+    for (State* state : sortedStates(fsm)) {
         QString stateName = state->getName();
-        // clang-format off
-        code += QString(R"cpp(
-          QState* %1State = new QState(&fsm);
-          %1State->setObjectName("%1");
-                    // QState::entered lambda: handles state entry logic, including logging, updating state, and running
-                    // onEntry actions.
-          QObject::connect(%1State, &QState::entered, [=]() {
-              QString prevStateName = globalPrevStateName;
-              QString currentStateName = "%1";
-              if (prevStateName != currentStateName) {
-                  qint64 now = QDateTime::currentDateTime().toMSecsSinceEpoch();
-                  %1State->setProperty("entryTime", QVariant::fromValue(now));
-                  clearOutgoingTimers("%1");
-              }
-              globalPrevStateName = currentStateName;
-              log(DOUBLE_SEPARATOR);
-              log(STATE_HEADER + ANSI_BOLD + COLOR_STATE + currentStateName + ANSI_RESET + " ENTERED");
-              log(SECTION_SEPARATOR);
-              for (QTcpSocket* clientSocket : clientSockets) {
-                  if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                      QString stateMsg = QString("<event type=\"stateChange\"><name>%1</name></event>");
-                      clientSocket->write(buildEvent(stateMsg));
-                      clientSocket->flush();
-                  }
-              }
-                )cpp").arg(stateName);
-
         QString onEntry = state->getCode();
-        if (!onEntry.isEmpty()) {
-            code += " log(\"Executing onEntry action for state: \" + ANSI_BOLD + \"" + stateName + "\" + ANSI_RESET);\n";
-            code += onEntry + "\n";
-            
-            QMap<QString, Variable*> variables = fsm->getVariables();
-            for (auto varIt = variables.constBegin(); varIt != variables.constEnd(); ++varIt) {
-                QString varName = varIt.value()->getName();
-                code += " QVariant newValue_" + varName + " = QVariant(" + varName + ");\n";
-                code += " if (internalVariables[\"" + varName + "\"] != newValue_" + varName + ") {\n";
-                code += "     debug(\"Variable changed: " + varName + " = \" + newValue_" + varName + ".toString());\n";
-                code += "     internalVariables[\"" + varName + "\"] = newValue_" + varName + ";\n";
-                code += "     for (QTcpSocket* clientSocket : clientSockets) {\n";
-                code += "         if (clientSocket->state() == QAbstractSocket::ConnectedState) {\n";
-                code += "             QDomDocument doc;\n";
-                code += "             QDomElement element = doc.createElement(\"event\");\n";
-                code += "             element.setAttribute(\"type\", \"variable\");\n";
-                code += "             QDomElement nameElem = doc.createElement(\"name\");\n";
-                code += "             nameElem.appendChild(doc.createTextNode(\"" + varName + "\"));\n";
-                code += "             QDomElement valueElem = doc.createElement(\"value\");\n";
-                code += "             valueElem.appendChild(doc.createTextNode(newValue_" + varName + ".toString()));\n";
-                code += "             element.appendChild(nameElem);\n";
-                code += "             element.appendChild(valueElem);\n";
-                code += "             doc.appendChild(element);\n";
-                code += "             clientSocket->write(buildEvent(doc.toString(-1)));\n";
-                code += "             clientSocket->flush();\n";
-                code += "             debug(\"Variable change broadcasted to client: \" + doc.toString(-1));\n";
-                code += "         }\n";
-                code += "     }\n";
-                code += " }\n";
-            }
+        if (onEntry.isEmpty()) {
+            continue;
         }
-        code += "   log(SECTION_SEPARATOR);\n";
-        code += "   log(\" \");\n";
-        code += " });\n\n";
+        code += "\n// onEntry action of state " + stateName + "\n";
+        code += "void Machine::onEntry_" + stateName + "() {\n";
+        code += internNames(onEntry, inputs, outputs) + "\n";
+        code += "}\n";
     }
-    code += " fsm.setInitialState(" + initialStateName + "State);\n";
-    code += " debug(\"Initial state set to \" + ANSI_BOLD + COLOR_TARGET + \"" + initialStateName + "\" + ANSI_RESET);\n\n";
-    code += " debug(\"Setting up transitions...\");\n";
-    // clang-format on  
-
-    for (auto stateIt = allStates.begin(); stateIt != allStates.end(); ++stateIt) {
-        State* sourceState = stateIt.value();
-        QString sourceName = sourceState->getName();
-        QList<Transition*> transitions = fsm->getTransitionsFrom(sourceState);
-        for (Transition* transition : transitions) {
-            State* targetState = transition->getTo();
-            if (!targetState) {
-                continue;
-            }
-            QString targetName = targetState->getName();
-            code += generateTransitionCode(transition, sourceState, targetState);
-        }
-    }
-
-    code += R"cpp(
-        const QStringList helpLines = {
-            "• " + ANSI_BOLD + QString("input_name=value").leftJustified(26) + ANSI_RESET + "- Set an input value",
-            "• " + ANSI_BOLD + QString("input_name").leftJustified(26) + ANSI_RESET + "- Call an input",
-            "• " + ANSI_BOLD + QString("/status").leftJustified(26) + ANSI_RESET + "- Show the current system state",
-            "• " + ANSI_BOLD + QString("/help").leftJustified(26) + ANSI_RESET + "- Show this help message",
-            "• " + ANSI_BOLD + QString("/exit").leftJustified(26) + ANSI_RESET + "- Exit the application",
-            "• " + ANSI_BOLD + QString("/debugon /debugoff").leftJustified(26) + ANSI_RESET + "- Turn debug statements on/off"};
-    )cpp";
-
-    code += "showHelp(fsm.objectName(), fsm.property(\"description\").toString(), validInputNames, helpLines);\n ";
-
-    code += generateTerminalInputHandler(fsm);
-
-    code += generateTcpXmlProtocolServer(fsm);
-
-    code += R"cpp(
-        debug(ANSI_BOLD + COLOR_HEADER + "INITIALIZING STATE MACHINE" + ANSI_RESET);
-        fsm.start();
-        debug(COLOR_SUCCESS + "FSM activated successfully\n\n" + ANSI_RESET);
-        int result = app.exec();
-        debug("Application terminated with code " + QString::number(result));
-        return result;
-        }
-    )cpp";
     return code;
 }
 
-QString CodeGenerator::generateTcpXmlProtocolServer(FSM* fsm) {
+QString CodeGenerator::generateTransitionTable(FSM* fsm) {
     QString code =
         R"cpp(
-        server.listen(hostAddr, port);
-        log(QString("Listening for TCP connections on %1:%2").arg(hostAddr.toString()).arg(port));
-        // QTcpServer::newConnection lambda
-        QObject::connect(&server, &QTcpServer::newConnection, [&]() {
-            while (server.hasPendingConnections()) {
-                QTcpSocket* socket = server.nextPendingConnection();
-                clientSockets.insert(socket);
-                log("Client connected from " + socket->peerAddress().toString());
-                // QTcpSocket::readyRead lambda: reads data from the socket.
-                QObject::connect(socket, &QTcpSocket::readyRead, [socket, FSM_XML](void) {
-                    while (socket->canReadLine()) {
-                        QString line = QString::fromUtf8(socket->readLine()).trimmed();
-                        debug("TCP: Received line: " + line);
-                        if (line.isEmpty()) {
-                            continue;
-                        }
-                        if (!line.startsWith("<")) {
-                            debug("TCP: Non-XML command received: " + line);
-                            sendError(ERR_MALFORMED_XML, "Malformed XML", socket);
-                            continue;
-                        }
-                        QDomDocument doc;
-                        if (!doc.setContent(line)) {
-                            debug("TCP: Malformed XML received: " + line);
-                            sendError(ERR_MALFORMED_XML, "Malformed XML", socket);
-                            continue;
-                        }
-                        QDomElement root = doc.documentElement();
-                        QString type = root.attribute("type");
-                        if (type == "set") {
-                            QString name = root.firstChildElement("name").text();
-                            QString value = root.firstChildElement("value").text();
-                            if (inputs.contains(name)) {
-                                bool changed = (inputs[name] != value);
-                                inputs[name] = value;
-                                setInputCalled(name);
-                                fsm.postEvent(new InputEvent(name, value));
-                                log("Input '" + name + "' set to '" + value + "' via TCP");
-                                if (changed) {
-                                    for (QTcpSocket* clientSocket : clientSockets) {
-                                        if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                                            QDomDocument doc;
-                                            QDomElement element = doc.createElement("event");
-                                            element.setAttribute("type", "input");
-                                            QDomElement nameElem = doc.createElement("name");
-                                            nameElem.appendChild(doc.createTextNode(name));
-                                            QDomElement valueElem = doc.createElement("value");
-                                            valueElem.appendChild(doc.createTextNode(value));
-                                            element.appendChild(nameElem);
-                                            element.appendChild(valueElem);
-                                            doc.appendChild(element);
-                                            clientSocket->write(buildEvent(doc.toString(-1)));
-                                            clientSocket->flush();
-                                            debug("Input change broadcasted to client: " + doc.toString(-1));
-                                        }
-                                    }
-                                }
-                            } else {
-                                debug("TCP: Unknown input '" + name + "' in set command");
-                                sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
-                            }
-                            continue;
-                        } else if (type == "call") {
-                            QString name = root.firstChildElement("name").text();
-                            if (inputs.contains(name)) {
-                                setInputCalled(name);
-                                fsm.postEvent(new InputEvent(name, inputs[name]));
-                                log("Input '" + name + "' called via TCP");
-                            } else {
-                                debug("TCP: Unknown input '" + name + "' in call command");
-                                sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
-                            }
-                            continue;
-                        } else if (type == "status") {
-                            QString state = fsm.configuration().isEmpty()
-                                                ? "UNKNOWN"
-                                                : (*fsm.configuration().begin())->objectName();
-                            QString statusXml = generateStatusXml(state);
-                            QByteArray msg = buildEvent(statusXml);
-                            socket->write(msg);
-                            socket->flush();
-                            debug("TCP: Sent status XML");
-                            continue;
-                        } else if (type == "help") {
-                            QString helpMsg =
-                                "<event type=\"log\"><message>Supported "
-                                "commands: set, call, status, reqFSM, help, "
-                                "disconnect, shutdown</message></event>";
-                            socket->write(buildEvent(helpMsg));
-                            socket->flush();
-                            debug("TCP: Sent help message");
-                            continue;
-                        } else if (type == "reqFSM") {
-                            QString fsmMsgLine = QString::fromUtf8(FSM_XML).replace('\n', ' ').replace('\r', ' ');
-                            QString fsmMsg = QString(
-                                                 "<event "
-                                                 "type=\"fsm\"><model>%1</model></event>")
-                                                 .arg(fsmMsgLine);
-                            socket->write(buildEvent(fsmMsg));
-                            socket->flush();
-                            debug("TCP: FSM model XML sent to client");
-                            continue;
-                        } else if (type == "disconnect") {
-                            QString disconnectMsg =
-                                "<event "
-                                "type=\"disconnect\"><message>Disconnecting "
-                                "client</message></event>";
-                            socket->write(buildEvent(disconnectMsg));
-                            socket->flush();
-                            socket->disconnectFromHost();
-                            debug(
-                                "TCP: Client requested disconnect via socket "
-                                "communication");
-                            continue;
-                        } else if (type == "shutdown") {
-                            broadcastShutdownEvent(
-                                "Server is shutting down due to a TCP shutdown "
-                                "command. All clients will be disconnected.");
-                            log("Shutdown command received via socket "
-                                "communication. Shutting down server.");
-                            closeAndCleanupAllSockets();
-                            QCoreApplication::quit();
-                            continue;
-                        } else if (type == "pong") {
-                            if (awaitingPong.contains(socket)) {
-                                awaitingPong.remove(socket);
-                                if (pingTimers.contains(socket)) {
-                                    QTimer* t = pingTimers.take(socket);
-                                    if (t) {
-                                        t->stop();
-                                        t->deleteLater();
-                                    }
-                                }
-                                debug("Received pong from a client.");
-                            }
-                            continue;
-                        } else {
-                            debug("TCP: Unknown XML command received: " + type);
-                            sendError(ERR_UNKNOWN_COMMAND, "Unknown command", socket);
-                            continue;
-                        }
-                    }
-                });
-
-                // QTcpSocket::disconnected lambda
-                QObject::connect(socket, &QTcpSocket::disconnected, [socket]() {
-                    log("Client disconnected");
-                    cleanupSocket(socket);
-                });
-
-                // QTcpSocket::error lambda
-                // Done this way to avoid ambiguity because in Qt5.9 there are multiple overloaded error signals
-                QObject::connect(socket,
-                                 // Explicitly choosing the right signal overload
-                                 static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error),
-                                 [socket](QAbstractSocket::SocketError socketError) {
-                                     log(QString("Socket error occurred: %1").arg(socket->errorString()));
-                                     cleanupSocket(socket);
-                                 });
-            }
-        });
+        /******************************************************************************
+         * Transition table
+         ******************************************************************************/
+        )cpp";
 
-        QTimer* pingIntervalTimer = new QTimer(&app);
-        pingIntervalTimer->setInterval(20000);  // 20s
-        // QTimer::timeout (pingIntervalTimer lambda: Periodically sends ping messages to all clients for keepalive mechanism.
-        QObject::connect(pingIntervalTimer, &QTimer::timeout, [&]() {
-            for (QTcpSocket* clientSocket : clientSockets) {
-                if (!awaitingPong.contains(clientSocket)) {
-                    // Send ping
-                    QString pingMsg = "<event type=\"ping\"/>";
-                    clientSocket->write(buildEvent(pingMsg));
-                    clientSocket->flush();
-                    awaitingPong.insert(clientSocket);
-                    debug("Sent ping to a client.\n");
+    QStringList inputs = sortedInputNames(fsm);
+    QStringList outputs = sortedOutputNames(fsm);
+    QStringList variables = variableNames(fsm);
+    QString rows;
+    QString buckets;
+    QString actions;
+    QString guardCases;
+    QString delayCases;
+    QString actionCases;
+    int index = 0;
+
+    for (State* sourceState : sortedStates(fsm)) {
+        QString sourceName = sourceState->getName();
+        if (sourceState->getCode().isEmpty()) {
+            actions += "false, ";
+        } else {
+            actions += "true, ";
+            // Checked after the call, the action may return early
+            QString checks = changeChecks(writtenVariables(sourceState->getCode(), variables), "            ");
+            if (checks.isEmpty()) {
+                actionCases += "        case S_" + sourceName + ": onEntry_" + sourceName + "(); break;\n";
+            } else {
+                actionCases += "        case S_" + sourceName + ":\n            onEntry_" + sourceName + "();\n" +
+                               checks + "            break;\n";
+            }
+        }
+
+        for (Transition* transition : fsm->getTransitionsFrom(sourceState)) {
+            QString event = transition->getEvent().trimmed();
+            if (transition->getTo() && !event.isEmpty() && !inputs.contains(event)) {
+                qWarning() << "CodeGenerator: transition" << sourceName << "->" << transition->getTo()->getName()
+                           << "listens to unknown input" << event << ", skipping it";
+            }
+        }
+        // Bucket of a transition is the index of its input, eventless transitions go to the last bucket
+        QList<QPair<int, Transition*>> bucketed = tableTransitions(fsm, sourceState, inputs);
+
+        int next = 0;
+        for (int bucket = 0; bucket <= inputs.size(); ++bucket) {
+            buckets += QString::number(index) + ", ";
+            for (; next < bucketed.size() && bucketed[next].first == bucket; ++next) {
+                Transition* transition = bucketed[next].second;
+                QString targetName = transition->getTo()->getName();
+                QString event = transition->getEvent().trimmed();
+                QString condition = transition->getCondition();
+                QString delayVariable = transition->getDelayVariableName();
+                int delay = transition->isDelayedTransition() ? transition->getDelay() : 0;
+                bool hasEvent = !event.isEmpty();
+                bool hasCondition = hasGuard(transition);
+                bool delayed = hasDelay(transition);
+
+                QString description = sourceName + " → " + targetName;
+                if (hasEvent || hasCondition || delayed) {
+                    QStringList parts;
+                    if (hasEvent) parts << "event: " + event;
+                    if (hasCondition) parts << "[ " + condition.simplified() + " ]";
+                    if (delayed) {
+                        parts << "@ " + (delayVariable.isEmpty() ? QString::number(delay) + "ms" : delayVariable);
+                    }
+                    description += " (" + parts.join(" ") + ")";
+                }
 
-                    // Expect pong
-                    QTimer* pongTimer = new QTimer(clientSocket);
-                    pongTimer->setSingleShot(true);
-                    // QTimer::timeout (pongTimer): Handles keepalive timeout for individual clients.
-                    QObject::connect(pongTimer, &QTimer::timeout, [clientSocket]() {
-                        debug("A client timed out.");
-                        QString shutdownMsg =
-                            "<event type=\"shutdown\"><message>Keepalive "
-                            "timeout</message></event>";
-                        clientSocket->write(buildEvent(shutdownMsg));
-                        clientSocket->flush();
-                        cleanupSocket(clientSocket);
-                    });
-                    pingTimers[clientSocket] = pongTimer;
-                    pongTimer->start(10000); // 10 s
+                QString id = QString::number(index);
+                code += "\n// T" + id + ": " + description + "\n";
+                if (hasCondition) {
+                    QString checks = changeChecks(writtenVariables(condition, variables), "    ");
+                    if (checks.isEmpty()) {
+                        code += "bool Machine::guard_" + id + "() {\n    return (" +
+                                internNames(condition, inputs, outputs) + ");\n}\n";
+                    } else {
+                        code += "bool Machine::guard_" + id + "() {\n    const bool result = (" +
+                                internNames(condition, inputs, outputs) + ");\n" + checks +
+                                "    return result;\n}\n";
+                    }
+                    guardCases += "        case " + id + ": return guard_" + id + "();\n";
                 }
+                if (delayed) {
+                    code += "int Machine::delay_" + id + "() { return " +
+                            (delayVariable.isEmpty() ? QString::number(delay) : delayVariable) + "; }\n";
+                    delayCases += "        case " + id + ": return delay_" + id + "();\n";
+                }
+
+                rows += "    {S_" + sourceName + ", S_" + targetName + ", " +
+                        (hasEvent ? "IN_" + event : "NO_EVENT") + ", " + (hasCondition ? "true" : "false") + ", " +
+                        (delayed ? "true" : "false") + "},\n";
+                ++index;
             }
-        });
-        pingIntervalTimer->start();
-        )cpp";
+        }
+    }
+    buckets += QString::number(index);
+
+    code += "\n// Transitions grouped by source state (StateId order), then by input (InputId order, eventless last)\n";
+    code += "const TransitionEntry kTransitions[TRANSITION_COUNT + 1] = {\n" + rows +
+            "    {-1, -1, NO_EVENT, false, false}};\n\n";
+    code += "// Bucket b = s * EVENT_BUCKETS + e holds the transitions leaving state s that listen to input e,\n";
+    code += "// e = INPUT_COUNT is the bucket of eventless transitions. The bucket spans kTransitions[kEventBuckets[b]] ..\n";
+    code += "// kTransitions[kEventBuckets[b + 1] - 1]\n";
+    code += "constexpr int EVENT_BUCKETS = INPUT_COUNT + 1;\n";
+    code += "const int kEventBuckets[STATE_COUNT * EVENT_BUCKETS + 1] = {" + buckets + "};\n\n";
+    code += "// Whether a state has an onEntry action\n";
+    code += "const bool kStateActions[STATE_COUNT + 1] = {" + actions + "false};\n\n";
+
+    // The runtime only calls the dispatchers for transitions and states flagged in the tables
+    code += "bool Machine::guard(int transition) {\n    switch (transition) {\n" + guardCases +
+            "        default: return true;\n    }\n}\n\n";
+    code += "int Machine::delay(int transition) {\n    switch (transition) {\n" + delayCases +
+            "        default: return 0;\n    }\n}\n\n";
+    code += "void Machine::onEntry(int state) {\n    switch (state) {\n" + actionCases +
+            "        default: break;\n    }\n}\n\n";
+
+    QString variableCases;
+    QString setVariableCases;
+    QStringList tracked = trackedVariables(fsm);
+    for (Variable* var : fsm->getVariables()) {
+        QString member = "this->" + var->getName();
+        variableCases += "        case VAR_" + var->getName() + ": return QVariant::fromValue(" + member + ");\n";
+        setVariableCases += "        case VAR_" + var->getName() + ": " + member + " = value.value<decltype(" +
+                            member + ")>(); ";
+        if (tracked.contains(var->getName())) {
+            setVariableCases += "this->shadow_" + var->getName() + " = " + member + "; ";
+        }
+        setVariableCases += "break;\n";
+    }
+    code += "QVariant Machine::variable(int variable) const {\n    switch (variable) {\n" + variableCases +
+            "        default: return QVariant();\n    }\n}\n\n";
+    code += "void Machine::setVariable(int variable, const QVariant& value) {\n    switch (variable) {\n" +
+            setVariableCases + "        default: break;\n    }\n}\n";
     return code;
 }
 
-QString CodeGenerator::generateTerminalInputHandler(FSM* fsm) {
-    QString code = R"cpp(
-    FILE* terminalInput = fdopen(dup(STDIN_FILENO), "r");
-    if (!terminalInput) {
-        debug("Error: Could not open terminal input");
-        return 1;
-    }
-
-    int terminalFd = fileno(terminalInput);
-    QSocketNotifier* inputNotifier = new QSocketNotifier(terminalFd, QSocketNotifier::Read);
-
-    // QSocketNotifier::activated lambda: terminal input processing
-    QObject::connect(inputNotifier, &QSocketNotifier::activated, [&]() {
-    char buffer[256];
-    if (fgets(buffer, sizeof(buffer), terminalInput)) {
-        QString inputLine = QString::fromLocal8Bit(buffer).trimmed();
-
-        if (inputLine.isEmpty()) {
-            return;
-        }
-
-        if (inputLine == "/exit") {
-            log("Quit command received. Terminating application.");
-            broadcastShutdownEvent(
-                "Server is shutting down due to /exit command. All clients will be "
-                "disconnected.");
-            closeAndCleanupAllSockets();
-            QCoreApplication::quit();
-            return;
-        }
-
-        if (inputLine == "/help") {
-            showHelp(fsm.objectName(), fsm.property("description").toString(), validInputNames, helpLines);
-            return;
-        }
+QString CodeGenerator::generateMainFunction(FSM* fsm) {
+    QString code;
 
-        if (inputLine == "/status") {
-            QString currentState =
-                fsm.configuration().isEmpty() ? "UNKNOWN" : (*fsm.configuration().begin())->objectName();
-            log("Current state: " + ANSI_BOLD + COLOR_STATE + currentState + ANSI_RESET);
-            // Show debug state
-            log(SECTION_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "DEBUG STATE:" + ANSI_RESET);
-            log(QString("  Debug output is ") +
-                (debugEnabled ? (COLOR_SUCCESS + "ENABLED" + ANSI_RESET) : (COLOR_WARNING + "DISABLED" + ANSI_RESET)));
-            // Show client connection status
-            log(SECTION_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "CLIENT CONNECTIONS:" + ANSI_RESET);
-            for (QTcpSocket* clientSocket : clientSockets) {
-                if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                    log("  " + COLOR_SUCCESS + "Client connected" + ANSI_RESET + " (" +
-                        clientSocket->peerAddress().toString() + ")");
-                } else {
-                    log("  " + COLOR_WARNING + "Client disconnected" + ANSI_RESET);
-                }
-            }
-            // Show inputs
-            log(SECTION_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "INPUTS:" + ANSI_RESET);
-            for (auto it = inputs.constBegin(); it != inputs.constEnd(); ++it) {
-                log("  " + COLOR_COMMAND + it.key() + ANSI_RESET + " = " + COLOR_VALUE + it.value() + ANSI_RESET);
-            }
-            // Show outputs
-            log(SECTION_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "OUTPUTS:" + ANSI_RESET);
-            for (auto it = outputs.constBegin(); it != outputs.constEnd(); ++it) {
-                log("  " + COLOR_COMMAND + it.key() + ANSI_RESET + " = " + COLOR_VALUE + it.value() + ANSI_RESET);
-            }
-            // Show internal variables
-            log(SECTION_SEPARATOR);
-            log(ANSI_BOLD + COLOR_HEADER + "INTERNAL VARIABLES:" + ANSI_RESET);
+    code += R"cpp(
+        /************************************************************************
+         * Machine definition and Main function
+         ***********************************************************************/
     )cpp";
 
-    QMap<QString, Variable*> variables = fsm->getVariables();
-    for (auto it = variables.constBegin(); it != variables.constEnd(); ++it) {
-        Variable* var = it.value();
-        QString varName = var->getName();
-        code += " log(\"  \" + COLOR_COMMAND + \"" + varName +
-                "\" + ANSI_RESET + \" = \" + COLOR_VALUE + QVariant::fromValue(" 
-                + varName + ").toString() + ANSI_RESET);\n";
-    }
+    code += generateStateActions(fsm);
+    code += generateTransitionTable(fsm);
 
-    code +=
-        R"cpp(
-        log(SECTION_SEPARATOR);
-        return;
-        }
-
-        if (inputLine == "/debugon") {
-            debugEnabled = true;
-            log("Debug output enabled.");
-            return;
-        }
-        if (inputLine == "/debugoff") {
-            debugEnabled = false;
-            log("Debug output disabled.");
-            return;
-        }
-
-        QRegularExpression inputRegex("^(\\w+)(?:=(.*))?$");
-        QRegularExpressionMatch match = inputRegex.match(inputLine);
-
-        if (match.hasMatch()) {
-            QString name = match.captured(1);
-            QString value = match.captured(2);
+    code += "\nconst char* const kVariableTypes[VARIABLE_COUNT + 1] = {";
+    for (Variable* var : fsm->getVariables()) {
+        code += cppStringLiteral(var->getType()) + ", ";
+    }
+    code += "nullptr};\n\n";
 
-            if (!validInputNames.contains(name)) {
-                log("Invalid input name: " + ANSI_BOLD + COLOR_ERROR + name + ANSI_RESET);
-                return;
-            }
+    State* initial = fsm->getInitialState();
+    QString initialStateId = initial ? "S_" + initial->getName() : "-1";
+
+    code += "const MachineDefinition kMachine = {\n";
+    code += "    " + cppStringLiteral(fsm->getName()) + ",\n";
+    code += "    " + cppStringLiteral(fsm->getComment()) + ",\n";
+    code += "    R\"xml(" + fsm->getInitialFSMXML() + ")xml\",\n";
+    code += "    STATE_COUNT, kStateNames,\n";
+    code += "    INPUT_COUNT, kInputNames,\n";
+    code += "    OUTPUT_COUNT, kOutputNames,\n";
+    code += "    VARIABLE_COUNT, kVariableNames, kVariableTypes,\n";
+    code += "    TRANSITION_COUNT, kTransitions, kEventBuckets,\n";
+    code += "    kStateActions,\n";
+    code += "    " + initialStateId + ",\n";
+    code += "    []() -> MachineContext* { return new Machine; }};\n";
 
-            if (!value.isEmpty()) {
-                // SET mode: store the new value and trigger event
-                debug("SET MODE for '" + name + "' with value '" + value + "'");
-                bool changed = (inputs[name] != value);
-                inputs[name] = value;
-                logInputEvent(name, value);
-                setInputCalled(name);
-                fsm.postEvent(new InputEvent(name, value));
-                if (changed) {
-                    for (QTcpSocket* clientSocket : clientSockets) {
-                        if (clientSocket->state() == QAbstractSocket::ConnectedState) {
-                            QDomDocument doc;
-                            QDomElement element = doc.createElement("event");
-                            element.setAttribute("type", "input");
-                            QDomElement nameElem = doc.createElement("name");
-                            nameElem.appendChild(doc.createTextNode(name));
-                            QDomElement valueElem = doc.createElement("value");
-                            valueElem.appendChild(doc.createTextNode(value));
-                            element.appendChild(nameElem);
-                            element.appendChild(valueElem);
-                            doc.appendChild(element);
-                            clientSocket->write(buildEvent(doc.toString(-1)));
-                            clientSocket->flush();
-                            debug("Input change broadcasted to client: " + doc.toString(-1));
-                        }
-                    }
-                }
-            } else {
-                // CALL mode: treat as pure event without changing stored value
-                debug("CALL MODE for '" + name + "'");
-                QString lastValue = inputs.contains(name) ? inputs[name] : QString();
-                logInputEvent(name, lastValue);
-                setInputCalled(name);
-                fsm.postEvent(new InputEvent(name, lastValue));
-            }
-        } else {
-            log("Unrecognized command: " + ANSI_BOLD + COLOR_ERROR + inputLine + ANSI_RESET);
-        }
-        }
-        else {
-            log(DOUBLE_SEPARATOR);
-            log(ANSI_BOLD + COLOR_WARNING + "EOF (Ctrl+D) received. Exiting application." + ANSI_RESET);
-            log(DOUBLE_SEPARATOR);
-            if (terminalInput) {
-                fclose(terminalInput);
-                terminalInput = nullptr;
-            }
-            broadcastShutdownEvent(
-                "Server is shutting down due to EOF (Ctrl+D) on terminal. "
-                "All clients will be "
-                "disconnected.");
-            closeAndCleanupAllSockets();
-            QCoreApplication::quit();
-        }
-    });
-)cpp";
-    return code;
-}
+    code += R"cpp(
+        }  // namespace FSM_NAMESPACE
 
-QString CodeGenerator::generateInputEventClass() {
-    return R"cpp(
+        #ifndef FSM_UNITY_BUILD
         /**
-         * @brief Custom event for input changes.
+         * @brief Entry point of the machine when it is built as a module for /reload.
          */
-        class InputEvent : public QEvent {
-           public:
-            static const QEvent::Type InputChangedType =
-                static_cast<QEvent::Type>(QEvent::User + 2);  // Custom event type for input changes
-            InputEvent(const QString& name, const QString& value) : QEvent(InputChangedType), m_name(name), m_value(value) {}
-            QString name() const { return m_name; }
-            QString value() const { return m_value; }
-
-           private:
-            QString m_name;
-            QString m_value;
-        };
-    )cpp";
-}
+        extern "C" __attribute__((visibility("default"))) const MachineDefinition* FSM_MODULE_ENTRY() {
+            return &FSM_NAMESPACE::kMachine;
+        }
+        #endif
 
-QString CodeGenerator::generateGeneratedTransitionClass() {
-    return R"cpp(
+        #if !defined(FSM_MODULE) && !defined(FSM_UNITY_BUILD)
         /**
-         * @brief Transition class handling both conditions and delays, generated
-         * for runtime.
+         * @brief Main function that runs the machine on the FSM runtime library.
          */
-        class GeneratedTransition : public QAbstractTransition {
-           public:
-            explicit GeneratedTransition(
-                std::function<bool()> condition = []() { return true; },
-                std::function<int()> delayFn = []() { return 0; }, const QString& fromState = QString(),
-                const QString& toState = QString())
-                : m_condition(std::move(condition)),
-                  m_delayFn(std::move(delayFn)),
-                  m_fromState(fromState),
-                  m_toState(toState),
-                  m_timer(new QTimer(this)),
-                  m_conditionMet(false),
-                  m_timerArmed(false),
-                  m_timerExpired(false),
-                  m_initialDelay(-1) {
-                m_timer->setSingleShot(true);
-                connect(m_timer, &QTimer::timeout, this, &GeneratedTransition::triggerTransition);
-            }
-            void resetTimerArmed() {
-                m_timerArmed = false;
-                m_initialDelay = -1;
-            }
-            void stopTimer() {
-                if (m_timer && m_timer->isActive()) m_timer->stop();
-            }
-            QString fromStateName() const { return m_fromState; }
-            QString toStateName() const { return m_toState; }
-
-           protected:
-            bool eventTest(QEvent* event) override {
-                if (event->type() == QEvent::User + 1 && m_timerExpired) {
-                    m_timerExpired = false;
-                    return true;
-                }
-                try {
-                    m_conditionMet = m_condition();
-                    debug("Evaluating transition from " + m_fromState + " to " + m_toState + ": " +
-                          (m_conditionMet ? "true" : "false"));
-                    if (m_timerArmed) {
-                        debug("Timer already armed for transition " + m_fromState + " → " + m_toState);
-                        return false;
-                    }
-                    if (!m_conditionMet) {
-                        debug("Condition is no longer met for transition " + m_fromState + " → " + m_toState);
-                        return false;
-                    }
-                    if (m_initialDelay == -1) {
-                        m_initialDelay = m_delayFn();
-                        debug("Initial delay for transition " + m_fromState + " → " + m_toState + ": " +
-                              QString::number(m_initialDelay) + " ms");
-                    }
-                    const int effDelay = m_initialDelay;
-                    if (effDelay > 0) {
-                        if (!m_timerArmed && m_initialDelay == effDelay) {
-                            logTransitionStart(effDelay);
-                            sendTimerEvent("timerStart", m_fromState, m_toState, effDelay);
-                            m_timer->start(effDelay);
-                            m_timerArmed = true;
-                        }
-                        return false;
-                    }
-                    return m_conditionMet;
-                } catch (const std::exception& e) {
-                    log("Error evaluating transition condition: " + QString::fromStdString(e.what()));
-                    return false;
-                } catch (...) {
-                    log("Unknown error evaluating transition condition");
-                    return false;
-                }
-            }
-            void onTransition(QEvent* event) override {
-                Q_UNUSED(event);
-                m_conditionMet = false;
-                m_timerArmed = false;
-                m_timerExpired = false;
-                m_initialDelay = -1;
-            }
-           private slots:
-            void triggerTransition() {
-                m_timerExpired = true;
-                log(TIMEOUT_EXPIRED + ANSI_BOLD + "▶ Timeout expired" + ANSI_RESET + " for transition " + COLOR_SOURCE +
-                    m_fromState + ANSI_RESET + COLOR_TRANSITION + " → " + COLOR_TARGET + m_toState + ANSI_RESET + ANSI_RESET +
-                    " (delay: " + ANSI_BOLD + QString::number(m_initialDelay) + " ms)" + ANSI_RESET);
-                sendTimerEvent("timerExpired", m_fromState, m_toState);
-                QEvent* customEvent = new QEvent(static_cast<QEvent::Type>(QEvent::User + 1));
-                machine()->postEvent(customEvent);
-            }
-           private:
-            void cancelTimerIfActive(const QString& reason = QString()) {
-                if (m_timer && m_timer->isActive()) {
-                    QString msg = "Cancelling timer for transition " + m_fromState + " → " + m_toState;
-                    if (!reason.isEmpty()) {
-                        msg += ": " + reason;
-                    }
-                    log(msg);
-                    m_timer->stop();
-                    m_timerArmed = false;
-                    m_initialDelay = -1;
-                }
-            }
-            void logTransitionStart(int effDelay) {
-                log(TIMEOUT_STARTED + ANSI_BOLD + "▶ Timeout started" + ANSI_RESET + " for transition " + COLOR_SOURCE +
-                    m_fromState + ANSI_RESET + COLOR_TRANSITION + " → " + COLOR_TARGET + m_toState + ANSI_RESET + ANSI_RESET +
-                    " (delay: " + ANSI_BOLD + QString::number(effDelay) + " ms)" + ANSI_RESET);
-                debug("Condition met for transition " + COLOR_SOURCE + m_fromState + ANSI_RESET + " → " + COLOR_TARGET +
-                      m_toState + ANSI_RESET + ", starting " + COLOR_VALUE + QString::number(effDelay) + "ms" + ANSI_RESET +
-                      " delay timer");
-            }
-            std::function<bool()> m_condition;
-            std::function<int()> m_delayFn;
-            QString m_fromState;
-            QString m_toState;
-            QTimer* m_timer;
-            bool m_conditionMet;
-            bool m_timerArmed = false;
-            bool m_timerExpired = false;
-            int m_initialDelay = -1;
-        };
+        int main(int argc, char* argv[]) { return runMachine(argc, argv, FSM_NAMESPACE::kMachine); }
+        #endif
     )cpp";
-}
\ No newline at end of file
+    return code;
+}
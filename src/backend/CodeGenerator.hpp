@@ -40,25 +40,20 @@ class CodeGenerator : public QObject {
 
    private:
     /**
-     * @brief Generate standard C++ header includes for the generated file.
+     * @brief Generate the header includes for the generated file.
+     *
+     * Everything but the machine itself lives in the FSM runtime library, so its public header is all the
+     * generated program includes.
      *
      * @return C++ code section with all required #include directives as a QString.
      */
     QString generateHeaders();
 
     /**
-     * @brief Generate helper and utility functions for the generated FSM code.
-     *
-     * Includes helpers for input/output, value access, conversion, event flagging,
-     * timer management, and status reporting.
+     * @brief Generate the Machine context struct of the generated FSM code.
      *
-     * @param fsm Pointer to the FSM object for which helpers are generated.
-     * @return C++ code section with helper functions as a QString.
-     */
-    QString generateHelperFunctions(FSM *fsm);
-
-    /**
-     * @brief Generate global declarations for standard and custom variables required for the generated FSM code.
+     * The struct derives from the MachineContext of the runtime library and holds the custom variables as members,
+     * the runtime creates one per hosted instance and keeps the inputs, outputs, timers and current state itself.
      *
      * @param fsm Pointer to the FSM object containing variable definitions.
      * @return C++ code section with variable declarations as a QString.
@@ -66,68 +61,44 @@ class CodeGenerator : public QObject {
     QString generateVariableDeclarations(FSM *fsm);
 
     /**
-     * @brief Generate runtime monitoring functions for the FSM.
-     *
-     * Also provides logging, debug, and help display utilities for state transitions,
-     * events, and debugging.
-     *
-     * @return C++ code section with runtime monitoring functions as a QString.
-     */
-    QString generateRuntimeMonitoring();
-
-    /**
-     * @brief Generate C++ code for a single FSM transition.
-     *
-     * @param transition Pointer to the transition object.
-     * @param sourceState Pointer to the source state.
-     * @param targetState Pointer to the target state.
-     * @return C++ code for the transition as a QString.
-     */
-    QString generateTransitionCode(Transition *transition, const State *sourceState, const State *targetState);
-
-    /**
-     * @brief Generate the main function and core classes for the FSM application.
-     *
-     * Additionally state setup, transitions, and event an loop.
+     * @brief Generate the dense state, input, output and variable identifiers of the FSM.
      *
-     * @param fsm Pointer to the FSM object containing states and transitions.
-     * @return C++ code section with the main function and related classes as a
-     * QString.
-     */
-    QString generateMainFunction(FSM *fsm);
-
-    /**
-     * @brief Generate the TCP XML protocol server logic for the FSM.
+     * States, inputs and outputs are numbered in sorted name order, the indices are used by the transition table,
+     * the dispatch engine and the value stores, so the hot path never hashes a name.
      *
      * @param fsm Pointer to the FSM object.
-     * @return C++ code section with TCP server logic as a QString.
+     * @return C++ code section with the identifier enums and name tables as a QString.
      */
-    QString generateTcpXmlProtocolServer(FSM *fsm);
+    QString generateMachineIds(FSM *fsm);
 
     /**
-     * @brief Generate the terminal input handler logic for the FSM.
+     * @brief Generate the onEntry action functions of all states.
      *
-     * @param fsm Pointer to the FSM object.
-     * @return C++ code section with terminal input handler as a QString.
+     * @param fsm Pointer to the FSM object containing the states.
+     * @return C++ code section with one function per state that has code as a QString.
      */
-    QString generateTerminalInputHandler(FSM *fsm);
+    QString generateStateActions(FSM *fsm);
 
     /**
-     * @brief Generate the InputEvent class for FSM input events.
+     * @brief Generate the flat transition table of the FSM.
      *
-     * Defines a custom QEvent subclass for input changes.
+     * Emits guard and delay functions for every transition, a table with the transitions grouped by source
+     * state and input, so the dispatcher only walks the transitions listening to the dispatched input, and the
+     * MachineContext overrides through which the runtime library reaches the generated functions.
      *
-     * @return C++ code section with the InputEvent class as a QString.
+     * @param fsm Pointer to the FSM object containing states and transitions.
+     * @return C++ code section with the transition table as a QString.
      */
-    QString generateInputEventClass();
+    QString generateTransitionTable(FSM *fsm);
 
     /**
-     * @brief Generate the GeneratedTransition class for FSM transitions.
+     * @brief Generate the machine definition and the main function for the FSM application.
      *
-     * Defines a custom QAbstractTransition subclass for runtime transitions in the
-     * generated FSM code.
+     * Additionally the state actions and the transition table. The main function hands the definition to
+     * runMachine() of the runtime library, which runs the dispatch engine and the event loop.
      *
-     * @return C++ code section with the GeneratedTransition class as a QString.
+     * @param fsm Pointer to the FSM object containing states and transitions.
+     * @return C++ code section with the machine definition and the main function as a QString.
      */
-    QString generateGeneratedTransitionClass();
+    QString generateMainFunction(FSM *fsm);
 };
@@ -0,0 +1,90 @@
+/**
+ * @file CompileCache.cpp
+ * @brief Implementation of the CompileCache class storing compiled FSM programs by the hash of their inputs.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "CompileCache.hpp"
+
+#include <utime.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+CompileCache::CompileCache(const QString& directory, int maxEntries)
+    : m_directory(directory.isEmpty() ? defaultDirectory() : directory), m_maxEntries(qMax(1, maxEntries)) {}
+
+QString CompileCache::defaultDirectory() {
+    QString base = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (base.isEmpty()) {
+        base = QDir::home().filePath(".cache");
+    }
+    return QDir(base).filePath("icp-proj/builds");
+}
+
+QString CompileCache::key(const QByteArray& source, const QStringList& flags, const QString& compilerId) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(compilerId.toUtf8());
+    hash.addData("\0", 1);
+    for (const QString& flag : flags) {
+        hash.addData(flag.toUtf8());
+        hash.addData("\0", 1);
+    }
+    hash.addData(source);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString CompileCache::binaryPath(const QString& key) const { return QDir(m_directory).filePath("fsm-" + key); }
+
+QString CompileCache::sourcePath(const QString& key) const { return binaryPath(key) + ".cpp"; }
+
+QString CompileCache::buildPath(const QString& key) const {
+    return binaryPath(key) + QString(".build-%1").arg(QCoreApplication::applicationPid());
+}
+
+QString CompileCache::lookup(const QString& key) const {
+    const QString path = binaryPath(key);
+    QFileInfo info(path);
+    if (!info.isFile() || !info.isExecutable()) {
+        return QString();
+    }
+    // The modification time orders the entries for pruning
+    utime(QFile::encodeName(path).constData(), nullptr);
+    return path;
+}
+
+QString CompileCache::store(const QString& key, const QString& builtPath) {
+    const QString path = binaryPath(key);
+    // Another editor may have stored the same program in the meantime, both are identical
+    QFile::remove(path);
+    if (!QFile::rename(builtPath, path)) {
+        qWarning().noquote() << "Could not store" << builtPath << "in the compile cache";
+        QFile::remove(builtPath);
+        return QString();
+    }
+    prune();
+    return path;
+}
+
+void CompileCache::prune() {
+    QDir dir(m_directory);
+    const QFileInfoList entries = dir.entryInfoList(QStringList{"fsm-*"}, QDir::Files, QDir::Time);
+    int kept = 0;
+    for (const QFileInfo& entry : entries) {
+        if (entry.suffix() == "cpp" || entry.fileName().contains(".build-")) {
+            continue;
+        }
+        if (++kept <= m_maxEntries) {
+            continue;
+        }
+        QFile::remove(entry.absoluteFilePath());
+        QFile::remove(entry.absoluteFilePath() + ".cpp");
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file CompileCache.hpp
+ * @brief Header file for the CompileCache class storing compiled FSM programs by the hash of their inputs.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief Content-addressed store of compiled FSM programs.
+ *
+ * A program is identified by a key hashed from the generated source, the compiler flags and the compiler
+ * version, so an unchanged machine is started again without running the compiler. Entries live in a per-user
+ * cache directory and the least recently used ones are pruned once the cache grows past its entry limit.
+ */
+class CompileCache {
+   public:
+    /**
+     * @brief Construct a cache stored in the given directory.
+     *
+     * @param directory Cache directory, created on first use. Empty for defaultDirectory().
+     * @param maxEntries Number of compiled programs kept.
+     */
+    explicit CompileCache(const QString &directory = QString(), int maxEntries = 16);
+
+    /**
+     * @brief Get the per-user cache directory used when none is given.
+     *
+     * @return The icp-proj/builds directory inside the generic cache location (usually ~/.cache).
+     */
+    static QString defaultDirectory();
+
+    /**
+     * @brief Compute the key of a program.
+     *
+     * @param source Generated C++ source.
+     * @param flags Compiler arguments other than the input and output files.
+     * @param compilerId Compiler version string, so a compiler upgrade invalidates the entries.
+     * @return Hex encoded SHA-256 of all inputs.
+     */
+    static QString key(const QByteArray &source, const QStringList &flags, const QString &compilerId);
+
+    /**
+     * @brief Look up a compiled program and mark it as recently used.
+     *
+     * @param key Key from key().
+     * @return Path of the executable, or an empty string on a miss.
+     */
+    QString lookup(const QString &key) const;
+
+    /**
+     * @brief Get the path where the generated source of a key is written before compiling.
+     *
+     * @param key Key from key().
+     * @return Path of the source file inside the cache directory.
+     */
+    QString sourcePath(const QString &key) const;
+
+    /**
+     * @brief Get a private path for the compiler output of a key.
+     *
+     * Compiling to a temporary name and renaming it in store() keeps half-written programs out of the cache, also
+     * when several editors build the same machine at once.
+     *
+     * @param key Key from key().
+     * @return Path unique to this process.
+     */
+    QString buildPath(const QString &key) const;
+
+    /**
+     * @brief Move a freshly compiled program into the cache and prune old entries.
+     *
+     * @param key Key from key().
+     * @param builtPath Executable written to buildPath().
+     * @return Path of the cached executable, or an empty string if it could not be stored.
+     */
+    QString store(const QString &key, const QString &builtPath);
+
+    /**
+     * @brief Get the cache directory.
+     * @return Absolute path of the directory.
+     */
+    QString directory() const { return m_directory; }
+
+   private:
+    /**
+     * @brief Get the path of the cached executable of a key.
+     *
+     * @param key Key from key().
+     * @return Path inside the cache directory.
+     */
+    QString binaryPath(const QString &key) const;
+
+    /**
+     * @brief Remove the least recently used entries above the entry limit.
+     */
+    void prune();
+
+    /**
+     * @brief Directory holding the sources and executables.
+     */
+    QString m_directory;
+
+    /**
+     * @brief Number of compiled programs kept.
+     */
+    int m_maxEntries;
+};
@@ -0,0 +1,279 @@
+/**
+ * @file FsmInterpreter.cpp
+ * @brief Implementation of the FsmInterpreter class running an FSM inside the editor without compiling it.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "FsmInterpreter.hpp"
+
+#include <QStringList>
+#include <algorithm>
+#include <exception>
+
+#include "fsm.hpp"
+#include "state.hpp"
+#include "transition.hpp"
+#include "variable.hpp"
+
+// Interpreter whose machine the runtime creates contexts for, createContext cannot capture it
+static FsmInterpreter* activeInterpreter = nullptr;
+
+/**
+ * @brief Context of an interpreted machine instance, runs the scripts of the interpreter on its own variables.
+ */
+class InterpretedMachine final : public MachineContext {
+   public:
+    explicit InterpretedMachine(const FsmInterpreter& interpreter)
+        : m_interpreter(interpreter), m_values(interpreter.m_initialValues), m_reported(m_values) {}
+
+    bool guard(int transition) override {
+        const Script& guard = m_interpreter.m_guards[transition];
+        bool result = false;
+        try {
+            result = Script::truth(guard.run(m_values));
+        } catch (const std::exception& e) {
+            log(QString("Condition of transition %1 failed: %2").arg(transition).arg(e.what()));
+        }
+        trackChanges(guard);
+        return result;
+    }
+
+    int delay(int transition) override {
+        try {
+            return m_interpreter.m_delays[transition].run(m_values).toInt();
+        } catch (const std::exception& e) {
+            log(QString("Delay of transition %1 failed: %2").arg(transition).arg(e.what()));
+            return 0;
+        }
+    }
+
+    void onEntry(int state) override {
+        const Script& action = m_interpreter.m_actions[state];
+        try {
+            action.run(m_values);
+        } catch (const std::exception& e) {
+            log(QString("Action of state %1 failed: %2").arg(m_interpreter.m_stateNames[state]).arg(e.what()));
+        }
+        trackChanges(action);
+    }
+
+    QVariant variable(int variable) const override { return m_values[variable]; }
+
+    void setVariable(int variable, const QVariant& value) override {
+        m_values[variable] = Script::coerce(value, m_values[variable].userType());
+        m_reported[variable] = m_values[variable];
+    }
+
+   private:
+    /**
+     * @brief Note the variables a script wrote with a value other than the reported one.
+     * @param script Guard or action that ran.
+     */
+    void trackChanges(const Script& script) {
+        for (int v : script.writtenVariables()) {
+            trackChange(v, m_values[v], m_reported[v]);
+        }
+    }
+
+    const FsmInterpreter& m_interpreter;
+    QVector<QVariant> m_values;    // Custom variables of the instance
+    QVector<QVariant> m_reported;  // Values of the variables last reported to the clients
+};
+
+/**
+ * @brief Get the names of a set in a stable (sorted) order, the order the code generator indexes them in.
+ *
+ * @param names Input or output names of an FSM.
+ * @return Sorted list of trimmed names.
+ */
+static QStringList sortedNames(const QSet<QString>& names) {
+    QStringList sorted;
+    for (const QString& name : names) {
+        sorted.append(name.trimmed());
+    }
+    sorted.sort();
+    return sorted;
+}
+
+FsmInterpreter::FsmInterpreter(QObject* parent) : QObject(parent) {}
+
+FsmInterpreter::~FsmInterpreter() { stop(); }
+
+bool FsmInterpreter::load(FSM* fsm, QString& error) {
+    stop();
+    m_loaded = false;
+    m_strings.clear();
+    m_transitions.clear();
+    m_eventBuckets.clear();
+    m_guards.clear();
+    m_delays.clear();
+    m_actions.clear();
+    m_initialValues.clear();
+
+    QList<State *> states = fsm->getStates().values();
+    std::sort(states.begin(), states.end(), [](State* a, State* b) { return a->getName() < b->getName(); });
+    QStringList stateNames;
+    for (State* state : states) {
+        stateNames << state->getName();
+    }
+    QStringList inputs = sortedNames(fsm->getInputs());
+    QStringList outputs = sortedNames(fsm->getOutputs());
+    QStringList variables;
+    QStringList variableTypes;
+    for (Variable* var : fsm->getVariables()) {
+        variables << var->getName();
+        variableTypes << var->getType();
+        // The value is the C++ initializer the generated code declares the variable with, evaluate it the same way
+        Script initializer;
+        QString problem;
+        if (!initializer.compile(var->getValue().toString(), {}, Script::Expression, problem)) {
+            error = "Initial value of variable " + var->getName() + ": " + problem;
+            return false;
+        }
+        QVector<QVariant> none;
+        try {
+            m_initialValues << Script::coerce(initializer.run(none), Script::typeOf(var->getType()));
+        } catch (const std::exception& e) {
+            error = "Initial value of variable " + var->getName() + ": " + e.what();
+            return false;
+        }
+    }
+
+    m_stateActions.reset(new bool[states.size() + 1]());
+    for (int s = 0; s < states.size(); ++s) {
+        State* state = states[s];
+        Script action;
+        if (!state->getCode().trimmed().isEmpty()) {
+            QString problem;
+            if (!action.compile(state->getCode(), variables, Script::Statements, problem)) {
+                error = "Action of state " + state->getName() + ": " + problem;
+                return false;
+            }
+            m_stateActions[s] = true;
+        }
+        m_actions.push_back(std::move(action));
+
+        // Same order as the generated table, by input index with eventless transitions last
+        QList<QPair<int, Transition*>> bucketed;
+        for (Transition* transition : fsm->getTransitionsFrom(state)) {
+            QString event = transition->getEvent().trimmed();
+            if (!transition->getTo() || (!event.isEmpty() && !inputs.contains(event))) {
+                continue;
+            }
+            bucketed.append(qMakePair(event.isEmpty() ? inputs.size() : inputs.indexOf(event), transition));
+        }
+        std::stable_sort(bucketed.begin(), bucketed.end(),
+                         [](const QPair<int, Transition*>& a, const QPair<int, Transition*>& b) {
+                             return a.first < b.first;
+                         });
+
+        int next = 0;
+        for (int bucket = 0; bucket <= inputs.size(); ++bucket) {
+            m_eventBuckets.push_back(static_cast<int>(m_transitions.size()));
+            for (; next < bucketed.size() && bucketed[next].first == bucket; ++next) {
+                Transition* transition = bucketed[next].second;
+                QString description = state->getName() + " -> " + transition->getTo()->getName();
+                QString problem;
+
+                Script guard;
+                QString condition = transition->getCondition().trimmed();
+                if (!condition.isEmpty() && !guard.compile(condition, variables, Script::Expression, problem)) {
+                    error = "Condition of transition " + description + ": " + problem;
+                    return false;
+                }
+
+                Script delay;
+                QString delayVariable = transition->getDelayVariableName();
+                bool delayed = transition->isDelayedTransition() &&
+                               (transition->getDelay() > 0 || !delayVariable.isEmpty());
+                if (delayed) {
+                    QString source = delayVariable.isEmpty() ? QString::number(transition->getDelay()) : delayVariable;
+                    if (!delay.compile(source, variables, Script::Expression, problem)) {
+                        error = "Delay of transition " + description + ": " + problem;
+                        return false;
+                    }
+                }
+
+                int to = stateNames.indexOf(transition->getTo()->getName());
+                m_transitions.push_back(
+                    {s, to, bucket == inputs.size() ? -1 : bucket, guard.isCompiled(), delay.isCompiled()});
+                m_guards.push_back(std::move(guard));
+                m_delays.push_back(std::move(delay));
+            }
+        }
+    }
+    m_eventBuckets.push_back(static_cast<int>(m_transitions.size()));
+    m_transitions.push_back({-1, -1, -1, false, false});
+
+    // The definition points into the strings, they are all stored before taking the pointers
+    QStringList strings = stateNames + inputs + outputs + variables + variableTypes;
+    for (const QString& text : strings) {
+        m_strings.push_back(text.toUtf8());
+    }
+    auto names = [this](int first, int count) {
+        std::vector<const char *> pointers;
+        for (int i = first; i < first + count; ++i) {
+            pointers.push_back(m_strings[i].constData());
+        }
+        pointers.push_back(nullptr);
+        return pointers;
+    };
+    int offset = 0;
+    m_stateNames = names(offset, stateNames.size());
+    m_inputNames = names(offset += stateNames.size(), inputs.size());
+    m_outputNames = names(offset += inputs.size(), outputs.size());
+    m_variableNames = names(offset += outputs.size(), variables.size());
+    m_variableTypes = names(offset += variables.size(), variableTypes.size());
+    m_name = fsm->getName().toUtf8();
+    m_description = fsm->getComment().toUtf8();
+    m_xml = fsm->getInitialFSMXML().toUtf8();
+
+    State* initial = fsm->getInitialState();
+    m_definition.name = m_name.constData();
+    m_definition.description = m_description.constData();
+    m_definition.xml = m_xml.constData();
+    m_definition.stateCount = stateNames.size();
+    m_definition.stateNames = m_stateNames.data();
+    m_definition.inputCount = inputs.size();
+    m_definition.inputNames = m_inputNames.data();
+    m_definition.outputCount = outputs.size();
+    m_definition.outputNames = m_outputNames.data();
+    m_definition.variableCount = variables.size();
+    m_definition.variableNames = m_variableNames.data();
+    m_definition.variableTypes = m_variableTypes.data();
+    m_definition.transitionCount = static_cast<int>(m_transitions.size()) - 1;
+    m_definition.transitions = m_transitions.data();
+    m_definition.eventBuckets = m_eventBuckets.data();
+    m_definition.stateActions = m_stateActions.get();
+    m_definition.initialState = initial ? stateNames.indexOf(initial->getName()) : -1;
+    m_definition.createContext = []() -> MachineContext * { return new InterpretedMachine(*activeInterpreter); };
+    m_loaded = true;
+    return true;
+}
+
+bool FsmInterpreter::start(const QString& host, quint16 port, const QString& localName, QString& error) {
+    if (!m_loaded) {
+        error = "No machine loaded";
+        return false;
+    }
+    stop();
+    activeInterpreter = this;
+    if (!startEmbeddedMachine(m_definition, host, port, localName, [this]() { m_running = false; })) {
+        error = QString("Cannot listen on %1:%2").arg(host).arg(port);
+        return false;
+    }
+    m_running = true;
+    return true;
+}
+
+void FsmInterpreter::stop() {
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    stopEmbeddedMachine();
+}
+
+bool FsmInterpreter::isRunning() const { return m_running; }
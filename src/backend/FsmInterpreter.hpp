@@ -0,0 +1,100 @@
+/**
+ * @file FsmInterpreter.hpp
+ * @brief Header file for the FsmInterpreter class running an FSM inside the editor without compiling it.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include "Script.hpp"
+#include "runtime/FsmRuntime.hpp"
+
+class FSM;
+
+/**
+ * @brief Runs an FSM from its in-memory model on the FSM runtime library.
+ *
+ * The model is turned into the same tables the code generator emits, guards, delays and state actions are
+ * parsed by Script instead of being compiled. The machine runs on a worker thread of the runtime and serves the
+ * usual client protocol, so GuiClient and other clients connect to it like to a generated program.
+ */
+class FsmInterpreter : public QObject {
+    Q_OBJECT
+
+   public:
+    /**
+     * @brief Constructor for FsmInterpreter.
+     *
+     * @param parent Optional parent QObject.
+     */
+    explicit FsmInterpreter(QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor, stops a running machine.
+     */
+    ~FsmInterpreter() override;
+
+    /**
+     * @brief Prepare an FSM for running, stopping a machine that is already running.
+     *
+     * @param fsm FSM to run, only read during the call.
+     * @param error Set to a description of the first guard, delay or action that cannot be interpreted.
+     * @return True if the machine can be started.
+     */
+    bool load(FSM *fsm, QString &error);
+
+    /**
+     * @brief Start the loaded machine.
+     *
+     * @param host Address the TCP server listens on.
+     * @param port Port of the TCP server.
+     * @param localName Name of the local socket server, empty for none.
+     * @param error Set to a description of the problem if the machine cannot be started.
+     * @return True if the machine runs.
+     */
+    bool start(const QString &host, quint16 port, const QString &localName, QString &error);
+
+    /**
+     * @brief Stop the running machine, clients are sent a shutdown event.
+     */
+    void stop();
+
+    /**
+     * @brief Check whether a machine runs.
+     *
+     * @return True between a successful start() and stop() or a shutdown command of a client.
+     */
+    bool isRunning() const;
+
+   private:
+    friend class InterpretedMachine;
+
+    MachineDefinition m_definition = {};  // Tables handed to the runtime
+    bool m_loaded = false;                // Whether m_definition describes a loaded machine
+    bool m_running = false;               // Whether the runtime hosts the machine
+    QByteArray m_name;                    // Storage of the strings m_definition points to
+    QByteArray m_description;
+    QByteArray m_xml;
+    std::vector<QByteArray> m_strings;    // Storage of the names and variable types
+    std::vector<const char *> m_stateNames;
+    std::vector<const char *> m_inputNames;
+    std::vector<const char *> m_outputNames;
+    std::vector<const char *> m_variableNames;
+    std::vector<const char *> m_variableTypes;
+    std::vector<TransitionEntry> m_transitions;
+    std::vector<int> m_eventBuckets;
+    std::unique_ptr<bool[]> m_stateActions;
+    std::vector<Script> m_guards;         // Condition of each transition, empty if unguarded
+    std::vector<Script> m_delays;         // Delay of each transition, empty if immediate
+    std::vector<Script> m_actions;        // onEntry action of each state, empty if none
+    QVector<QVariant> m_initialValues;    // Values the variables of a new instance start with
+};
@@ -10,42 +10,149 @@
 
 #include <qobjectdefs.h>
 
+#include <QDataStream>
+#include <QtEndian>
+#include <atomic>
+#include <cstring>
+
 #include "logger.hpp"
+#include "runtime/WireFormat.hpp"
+
+/**
+ * @brief Interval in milliseconds at which the shared-memory event stream is polled.
+ */
+static constexpr int SHARED_POLL_INTERVAL = 5;
 
 GuiClient::GuiClient(const QString& host, quint16 port, QObject* parent) : QObject(parent), m_host(host), m_port(port) {
-    socket = new QTcpSocket(this);
-    connect(socket, &QTcpSocket::readyRead, this, &GuiClient::onReadyRead);
+    m_tcpSocket = new QTcpSocket(this);
+    m_localSocket = new QLocalSocket(this);
+    socket = m_tcpSocket;
+    connect(m_tcpSocket, &QTcpSocket::readyRead, this, &GuiClient::onReadyRead);
+    connect(m_localSocket, &QLocalSocket::readyRead, this, &GuiClient::onReadyRead);
+    m_sharedPoll = new QTimer(this);
+    m_sharedPoll->setInterval(SHARED_POLL_INTERVAL);
+    m_sharedPoll->setTimerType(Qt::PreciseTimer);
+    connect(m_sharedPoll, &QTimer::timeout, this, &GuiClient::readSharedEvents);
 }
 
 void GuiClient::connectToServer() {
-    socket->connectToHost(m_host, m_port);
-    if (socket->waitForConnected(3000)) {
-        Logger::messageHandler(QtInfoMsg, {}, QString("Connected to %1:%2").arg(m_host).arg(m_port));
+    m_binary = false;
+    m_localSocket->abort();
+    socket = m_tcpSocket;
+    m_tcpSocket->connectToHost(m_host, m_port);
+    if (m_tcpSocket->waitForConnected(3000)) {
+        qCInfo(lcClient).noquote() << QString("Connected to %1:%2").arg(m_host).arg(m_port);
+    } else {
+        qCCritical(lcClient).noquote() << "Failed to connect: " + m_tcpSocket->errorString();
+    }
+}
+
+void GuiClient::connectToLocalServer(const QString& name) {
+    m_binary = false;
+    m_tcpSocket->abort();
+    m_localSocket->abort();
+    socket = m_localSocket;
+    m_localSocket->connectToServer(name);
+    if (m_localSocket->waitForConnected(3000)) {
+        qCInfo(lcClient).noquote() << "Connected to local server " + name;
+    } else {
+        qCCritical(lcClient).noquote() << "Failed to connect: " + m_localSocket->errorString();
+    }
+}
+
+bool GuiClient::isConnected() const {
+    if (socket == m_localSocket) {
+        return m_localSocket->state() == QLocalSocket::ConnectedState;
+    }
+    return m_tcpSocket->state() == QAbstractSocket::ConnectedState;
+}
+
+void GuiClient::flushSocket() {
+    if (socket == m_localSocket) {
+        m_localSocket->flush();
     } else {
-        Logger::messageHandler(QtCriticalMsg, {}, "Failed to connect: " + socket->errorString());
+        m_tcpSocket->flush();
     }
 }
 
 void GuiClient::sendCommand(const QString& xml) {
-    QByteArray msg = (xml + "\n").toUtf8();
-    socket->write(msg);
-    socket->flush();
-    Logger::messageHandler(QtDebugMsg, {}, QString("Sent command: %1").arg(xml));
+    if (m_binary) {
+        writeFrame(FRAME_XML, xml.toUtf8());
+    } else {
+        socket->write((xml + "\n").toUtf8());
+        flushSocket();
+    }
+    qCDebug(lcClient).noquote() << QString("Sent command: %1").arg(xml);
+}
+
+/**
+ * @brief Build the instance selector attribute of a command.
+ *
+ * @param instance Machine instance, -1 to leave the selection to the server.
+ * @return The attribute with a leading space, or an empty string.
+ */
+static QString instanceAttribute(int instance) {
+    return instance < 0 ? QString() : QString(" instance=\"%1\"").arg(instance);
+}
+
+void GuiClient::writeFrame(quint8 type, const QByteArray& payload) {
+    QByteArray header(5, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size() + 1), reinterpret_cast<uchar*>(header.data()));
+    header[4] = static_cast<char>(type);
+    socket->write(header + payload);
+    flushSocket();
 }
 
-void GuiClient::sendSet(const QString& name, const QString& value) {
-    QString xml = QString("<command type=\"set\"><name>%1</name><value>%2</value></command>")
-                      .arg(name.toHtmlEscaped(), value.toHtmlEscaped());
+void GuiClient::sendSet(const QString& name, const QString& value, int instance) {
+    const int input = m_inputNames.indexOf(name);
+    if (m_binary && input >= 0) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << static_cast<quint32>(qMax(instance, 0)) << static_cast<quint16>(input) << value.toUtf8();
+        writeFrame(FRAME_SET, payload);
+        return;
+    }
+    QString xml = QString("<command type=\"set\"%1><name>%2</name><value>%3</value></command>")
+                      .arg(instanceAttribute(instance), name.toHtmlEscaped(), value.toHtmlEscaped());
+    sendCommand(xml);
+}
+
+void GuiClient::sendCall(const QString& name, int instance) {
+    const int input = m_inputNames.indexOf(name);
+    if (m_binary && input >= 0) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << static_cast<quint32>(qMax(instance, 0)) << static_cast<quint16>(input);
+        writeFrame(FRAME_CALL, payload);
+        return;
+    }
+    QString xml = QString("<command type=\"call\"%1><name>%2</name></command>")
+                      .arg(instanceAttribute(instance), name.toHtmlEscaped());
     sendCommand(xml);
 }
 
-void GuiClient::sendCall(const QString& name) {
-    QString xml = QString("<command type=\"call\"><name>%1</name></command>").arg(name.toHtmlEscaped());
+void GuiClient::sendBatch(const QList<BatchItem>& items, bool atomic, int instance) {
+    QString xml = QString("<command type=\"batch\" mode=\"%1\"%2>")
+                      .arg(atomic ? "atomic" : "each", instanceAttribute(instance));
+    for (const BatchItem& item : items) {
+        if (item.call) {
+            xml += QString("<call name=\"%1\"/>").arg(item.name.toHtmlEscaped());
+        } else {
+            xml += QString("<set name=\"%1\">%2</set>").arg(item.name.toHtmlEscaped(), item.value.toHtmlEscaped());
+        }
+    }
+    sendCommand(xml + "</command>");
+}
+
+void GuiClient::sendStatus(int instance) {
+    QString xml = QString("<command type=\"status\"%1></command>").arg(instanceAttribute(instance));
     sendCommand(xml);
 }
 
-void GuiClient::sendStatus() {
-    QString xml = "<command type=\"status\"></command>";
+void GuiClient::sendSubscribe(const QStringList& events, const QStringList& names, int instance) {
+    QString xml = QString("<command type=\"subscribe\"%1><events>%2</events><names>%3</names></command>")
+                      .arg(instanceAttribute(instance), events.join(' ').toHtmlEscaped(),
+                           names.join(' ').toHtmlEscaped());
     sendCommand(xml);
 }
 
@@ -74,124 +181,345 @@ void GuiClient::sendPong() {
     sendCommand(pongXml);
 }
 
+void GuiClient::requestBinaryProtocol() {
+    sendCommand("<command type=\"binary\"/>");
+}
+
 void GuiClient::onReadyRead() {
-    while (socket->canReadLine()) {
-        QString line = QString::fromUtf8(socket->readLine()).trimmed();
-        if (line.isEmpty()) continue;
-        QDomDocument prettyDoc;
-        QString prettyXml = line;
-        if (prettyDoc.setContent(line)) {
-            prettyXml = prettyDoc.toString(2);
-        }
-        Logger::messageHandler(QtDebugMsg, {}, QString("Recieved event:\n%1").arg(prettyXml));
-        QDomDocument doc;
-        if (!doc.setContent(line)) {
-            qWarning() << "Received malformed XML:" << line;
+    while (isConnected()) {
+        if (!m_binary) {
+            if (!m_lineReader.readLine(socket)) break;
+            handleXmlEvent(m_lineReader.data(), m_lineReader.size());
             continue;
         }
-        QDomElement root = doc.documentElement();
-        if (root.tagName() == "event") {
-            QString type = root.attribute("type");
-            if (type == "stateChange") {
-                QString state = root.firstChildElement("name").text();
-                qDebug() << "[STATE]" << state;
-                emit stateChange(state);
-            } else if (type == "output") {
-                QString name = root.firstChildElement("name").text();
-                QString value = root.firstChildElement("value").text();
-                emit printoutput(name, value);
-                qDebug() << "[OUTPUT]" << name << "=" << value;
-            } else if (type == "input") {
-                QString name = root.firstChildElement("name").text();
-                QString value = root.firstChildElement("value").text();
-                emit printinput(name, value);
-                qDebug() << "[INPUT]" << name << "=" << value;
-            } else if (type == "variable") {
-                QString name = root.firstChildElement("name").text();
-                QString value = root.firstChildElement("value").text();
-                emit printvariable(name, value);
-                qDebug() << "[VARIABLE]" << name << "=" << value;
-            } else if (type == "timerStart") {
-                QString from = root.firstChildElement("from").text();
-                QString to = root.firstChildElement("to").text();
-                QString ms = root.firstChildElement("ms").text();
-                emit timerstart(from, to, ms);
-                qDebug() << "[TIMER START] from" << from << "to" << to << ms << "ms";
-            } else if (type == "timerExpired") {
-                QString from = root.firstChildElement("from").text();
-                QString to = root.firstChildElement("to").text();
-                emit timerend(from, to);
-                qDebug() << "[TIMER EXPIRED] from" << from << "to" << to;
-            } else if (type == "fsm") {
-                QDomElement modelElem = root.firstChildElement("model");
-                QString modelXml;
-                QTextStream stream(&modelXml);
-                modelElem.save(stream, 0);
-                qDebug() << "[FSM XML RECEIVED]";
-                qDebug().noquote() << modelXml;
-                emit requestedFSM(modelXml);
-            } else if (type == "log" || type == "disconnect") {
-                QString msg = root.firstChildElement("message").text();
-                emit printmsg(msg);
-                qDebug() << "[SERVER]" << msg;
-            } else if (type == "error") {
-                QString code = root.firstChildElement("code").text();
-                QString msg = root.firstChildElement("message").text();
-                emit printerr(msg, code);
-                qWarning() << "[ERROR] code:" << code << ", message:" << msg;
-            } else if (type == "ping") {
-                sendPong();
-                qDebug() << "[PING] Received ping, sent pong.";
-            } else if (type == "status") {
-                FsmStatus status;
-                QDomElement statusElem = root.firstChildElement("status");
-                QString state = statusElem.firstChildElement("state").text();
-                qDebug() << "[STATUS] State:" << state;
-                status.state = state;
-
-                QDomElement inputs = statusElem.firstChildElement("inputs");
-                for (QDomElement input = inputs.firstChildElement("input"); !input.isNull();
-                     input = input.nextSiblingElement("input")) {
-                    qDebug() << "  [INPUT]" << input.attribute("name") << "=" << input.text();
-                    status.inputs.insert(input.attribute("name"), input.text());
-                }
-
-                QDomElement outputs = statusElem.firstChildElement("outputs");
-                for (QDomElement output = outputs.firstChildElement("output"); !output.isNull();
-                     output = output.nextSiblingElement("output")) {
-                    qDebug() << "  [OUTPUT]" << output.attribute("name") << "=" << output.text();
-                    status.outputs.insert(output.attribute("name"), output.text());
-                }
-
-                QDomElement vars = statusElem.firstChildElement("variables");
-                for (QDomElement var = vars.firstChildElement("var"); !var.isNull();
-                     var = var.nextSiblingElement("var")) {
-                    QString varName = var.attribute("name");
-                    QString varType = var.attribute("type");
-                    QString varValue = var.text();
-                    qDebug() << "  [VAR]" << varName << "(" << varType << ") =" << varValue;
-                    status.variables.append({varName, varType, varValue});
-                }
-
-                QDomElement timers = statusElem.firstChildElement("timers");
-                for (QDomElement timer = timers.firstChildElement("timer"); !timer.isNull();
-                     timer = timer.nextSiblingElement("timer")) {
-                    QString from = timer.firstChildElement("from").text();
-                    QString to = timer.firstChildElement("to").text();
-                    QString ms = timer.firstChildElement("ms").text();
-                    qDebug() << "  [TIMER] from" << from << "to" << to << "remaining:" << ms << "ms";
-                    status.timers.append({from, to, ms});
-                }
-                emit fsmStatus(status);
-            } else if (type == "shutdown") {
-                QString shutdownMsg = root.firstChildElement("message").text();
-                qDebug() << "[SHUTDOWN] Server FSM shutting down:" << shutdownMsg;
-                emit sendshutdown(shutdownMsg);
+        uchar header[5];
+        if (socket->peek(reinterpret_cast<char*>(header), 5) < 5) break;
+        const quint32 length = qFromBigEndian<quint32>(header);
+        if (length == 0 || length > MAX_FRAME_LENGTH) {
+            qCCritical(lcClient).noquote() << "Received malformed frame, disconnecting";
+            if (socket == m_localSocket) {
+                m_localSocket->abort();
             } else {
-                qDebug() << "[EVENT] type=" << type << line;
+                m_tcpSocket->abort();
             }
-        } else {
-            qDebug() << "[UNKNOWN XML]" << line;
+            break;
+        }
+        if (socket->bytesAvailable() < static_cast<qint64>(length) + 4) break;
+        socket->read(5);
+        handleFrame(header[4], socket->read(length - 1));
+    }
+}
+
+bool GuiClient::attachSharedEvents(const QString& key) {
+    detachSharedEvents();
+    m_sharedEvents = new QSharedMemory(key, this);
+    if (!m_sharedEvents->attach(QSharedMemory::ReadOnly)) {
+        qCCritical(lcClient).noquote() << "Failed to attach shared events: " + m_sharedEvents->errorString();
+        detachSharedEvents();
+        return false;
+    }
+    const char* base = static_cast<const char*>(m_sharedEvents->constData());
+    const SharedRingHeader* header = reinterpret_cast<const SharedRingHeader*>(base);
+    const bool valid = m_sharedEvents->size() >= static_cast<int>(sizeof(SharedRingHeader)) &&
+                       header->magic == SHARED_RING_MAGIC && header->version == SHARED_RING_VERSION;
+    const qint64 ringOffset = valid ? (static_cast<qint64>(sizeof(SharedRingHeader)) + header->namesSize + 7) & ~7 : 0;
+    if (!valid || header->capacity == 0 || m_sharedEvents->size() < ringOffset + header->capacity) {
+        qCCritical(lcClient).noquote() << "Shared memory " + key + " is not an FSM event stream";
+        detachSharedEvents();
+        return false;
+    }
+    if (header->namesSize > 5) {
+        handleFrame(FRAME_NAMES, QByteArray(base + sizeof(SharedRingHeader) + 5, header->namesSize - 5));
+    }
+    m_sharedRing = base + ringOffset;
+    m_sharedReadPos = header->writePos.load(std::memory_order_acquire);
+    m_sharedPoll->start();
+    if (isConnected()) {
+        sendSubscribe({"none"});
+    }
+    qCInfo(lcClient).noquote() << "Reading events from shared memory " + key;
+    return true;
+}
+
+void GuiClient::detachSharedEvents() {
+    m_sharedPoll->stop();
+    m_sharedRing = nullptr;
+    if (m_sharedEvents) {
+        m_sharedEvents->detach();
+        m_sharedEvents->deleteLater();
+        m_sharedEvents = nullptr;
+    }
+}
+
+void GuiClient::readSharedEvents() {
+    const SharedRingHeader* header = static_cast<const SharedRingHeader*>(m_sharedEvents->constData());
+    const quint64 end = header->writePos.load(std::memory_order_acquire);
+    const quint32 capacity = header->capacity;
+    if (end == m_sharedReadPos) return;
+    if (end - m_sharedReadPos > capacity) {
+        qCWarning(lcClient).noquote() << "Shared event stream overran, events were lost";
+        m_sharedReadPos = end;
+        return;
+    }
+    const int size = static_cast<int>(end - m_sharedReadPos);
+    const quint32 start = static_cast<quint32>(m_sharedReadPos % capacity);
+    const int first = static_cast<int>(qMin<quint64>(size, capacity - start));
+    QByteArray data(size, Qt::Uninitialized);
+    std::memcpy(data.data(), m_sharedRing + start, first);
+    std::memcpy(data.data() + first, m_sharedRing, size - first);
+    // The server may have wrapped around onto the copied bytes in the meantime, including with a frame it is
+    // still copying, which reservePos already covers
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 reserved = header->reservePos.load(std::memory_order_relaxed);
+    if (reserved - m_sharedReadPos > capacity) {
+        qCWarning(lcClient).noquote() << "Shared event stream overran, events were lost";
+        m_sharedReadPos = header->writePos.load(std::memory_order_acquire);
+        return;
+    }
+    m_sharedReadPos = end;
+    const uchar* frames = reinterpret_cast<const uchar*>(data.constData());
+    for (int offset = 0; offset + 5 <= size;) {
+        const quint32 length = qFromBigEndian<quint32>(frames + offset);
+        if (length == 0 || static_cast<qint64>(offset) + 4 + length > size) break;
+        handleFrame(frames[offset + 4], data.mid(offset + 5, static_cast<int>(length) - 1));
+        offset += 4 + static_cast<int>(length);
+    }
+}
+
+/**
+ * @brief Look up a name received in a binary frame.
+ *
+ * @param names Name table sent by the server.
+ * @param id Index from the frame.
+ * @return The name, or the index as text if the table does not contain it.
+ */
+static QString nameOf(const QStringList& names, quint16 id) {
+    return id < names.size() ? names.at(id) : QString::number(id);
+}
+
+void GuiClient::handleFrame(quint8 type, const QByteArray& payload) {
+    QDataStream in(payload);
+    if (type == FRAME_XML) {
+        handleXmlEvent(payload.constData(), payload.size());
+        return;
+    }
+    if (type == FRAME_NAMES) {
+        for (QStringList* names : {&m_stateNames, &m_inputNames, &m_outputNames, &m_variableNames}) {
+            quint16 count = 0;
+            in >> count;
+            names->clear();
+            for (quint16 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+                QByteArray name;
+                in >> name;
+                names->append(QString::fromUtf8(name));
+            }
+        }
+        qCDebug(lcClient) << "[NAMES]" << m_stateNames.size() << "states," << m_inputNames.size() << "inputs,"
+                 << m_outputNames.size() << "outputs," << m_variableNames.size() << "variables";
+        return;
+    }
+    if (type == FRAME_ERROR) {
+        quint16 code = 0;
+        QByteArray msg;
+        in >> code >> msg;
+        emit printerr(QString::fromUtf8(msg), QString::number(code));
+        qCWarning(lcClient) << "[ERROR] code:" << code << ", message:" << msg;
+        return;
+    }
+    quint32 instance = 0;
+    quint16 id = 0;
+    in >> instance >> id;
+    switch (type) {
+        case FRAME_STATE_CHANGE: {
+            QString state = nameOf(m_stateNames, id);
+            qCDebug(lcClient) << "[STATE]" << state;
+            emit stateChange(state);
+            break;
+        }
+        case FRAME_OUTPUT:
+        case FRAME_INPUT:
+        case FRAME_VARIABLE: {
+            QByteArray raw;
+            in >> raw;
+            QString value = QString::fromUtf8(raw);
+            if (type == FRAME_OUTPUT) {
+                emit printoutput(nameOf(m_outputNames, id), value);
+            } else if (type == FRAME_INPUT) {
+                emit printinput(nameOf(m_inputNames, id), value);
+            } else {
+                emit printvariable(nameOf(m_variableNames, id), value);
+            }
+            break;
+        }
+        case FRAME_TIMER_START: {
+            quint16 to = 0;
+            quint32 ms = 0;
+            in >> to >> ms;
+            emit timerstart(nameOf(m_stateNames, id), nameOf(m_stateNames, to), QString::number(ms));
+            break;
+        }
+        case FRAME_TIMER_EXPIRED: {
+            quint16 to = 0;
+            in >> to;
+            emit timerend(nameOf(m_stateNames, id), nameOf(m_stateNames, to));
+            break;
         }
+        default:
+            qCDebug(lcClient) << "[FRAME] unknown type" << type << "of" << payload.size() << "bytes";
+            break;
     }
-}
\ No newline at end of file
+}
+
+void GuiClient::handleXmlEvent(const char* data, int size) {
+    const XmlSlice line = XmlSlice{data, size}.trimmed();
+    if (line.size == 0) return;
+    qCDebug(lcClient).noquote() << QString("Recieved event: %1").arg(line.toString());
+    XmlMessage message;
+    if (!message.parse(line.data, line.size)) {
+        qCWarning(lcClient) << "Received malformed XML:" << line.toRawData();
+        return;
+    }
+    if (message.tag() != "event") {
+        qCDebug(lcClient) << "[UNKNOWN XML]" << line.toRawData();
+        return;
+    }
+    if (!message.isFlat()) {
+        // Only status reports and the FSM model nest elements, they are rare enough for a DOM
+        QDomDocument doc;
+        if (!doc.setContent(line.toRawData())) {
+            qCWarning(lcClient) << "Received malformed XML:" << line.toRawData();
+            return;
+        }
+        handleDomEvent(doc.documentElement());
+        return;
+    }
+    const XmlSlice type = message.attribute("type");
+    if (type == "stateChange") {
+        QString state = message.child("name").toString();
+        qCDebug(lcClient) << "[STATE]" << state;
+        emit stateChange(state);
+    } else if (type == "output") {
+        QString name = message.child("name").toString();
+        QString value = message.child("value").toString();
+        emit printoutput(name, value);
+        qCDebug(lcClient) << "[OUTPUT]" << name << "=" << value;
+    } else if (type == "input") {
+        QString name = message.child("name").toString();
+        QString value = message.child("value").toString();
+        emit printinput(name, value);
+        qCDebug(lcClient) << "[INPUT]" << name << "=" << value;
+    } else if (type == "variable") {
+        QString name = message.child("name").toString();
+        QString value = message.child("value").toString();
+        emit printvariable(name, value);
+        qCDebug(lcClient) << "[VARIABLE]" << name << "=" << value;
+    } else if (type == "timerStart") {
+        QString from = message.child("from").toString();
+        QString to = message.child("to").toString();
+        QString ms = message.child("ms").toString();
+        emit timerstart(from, to, ms);
+        qCDebug(lcClient) << "[TIMER START] from" << from << "to" << to << ms << "ms";
+    } else if (type == "timerExpired") {
+        QString from = message.child("from").toString();
+        QString to = message.child("to").toString();
+        emit timerend(from, to);
+        qCDebug(lcClient) << "[TIMER EXPIRED] from" << from << "to" << to;
+    } else if (type == "log" || type == "disconnect") {
+        QString msg = message.child("message").toString();
+        emit printmsg(msg);
+        qCDebug(lcClient) << "[SERVER]" << msg;
+    } else if (type == "error") {
+        QString code = message.child("code").toString();
+        QString msg = message.child("message").toString();
+        emit printerr(msg, code);
+        qCWarning(lcClient) << "[ERROR] code:" << code << ", message:" << msg;
+    } else if (type == "ping") {
+        sendPong();
+        qCDebug(lcClient) << "[PING] Received ping, sent pong.";
+    } else if (type == "binary") {
+        m_binary = true;
+        qCDebug(lcClient) << "[BINARY] Server switched to binary framing, version"
+                          << message.attribute("version").toRawData();
+    } else if (type == "shutdown") {
+        QString shutdownMsg = message.child("message").toString();
+        qCDebug(lcClient) << "[SHUTDOWN] Server FSM shutting down:" << shutdownMsg;
+        emit sendshutdown(shutdownMsg);
+    } else {
+        qCDebug(lcClient) << "[EVENT] type=" << type.toRawData() << line.toRawData();
+    }
+}
+
+void GuiClient::handleDomEvent(const QDomElement& root) {
+    QString type = root.attribute("type");
+    if (type == "fsm") {
+        QDomElement modelElem = root.firstChildElement("model");
+        QString modelXml;
+        QTextStream stream(&modelXml);
+        modelElem.save(stream, 0);
+        qCDebug(lcClient) << "[FSM XML RECEIVED]";
+        qCDebug(lcClient).noquote() << modelXml;
+        emit requestedFSM(modelXml);
+    } else if (type == "status") {
+        FsmStatus status;
+        QDomElement statusElem = root.firstChildElement("status");
+        QString state = statusElem.firstChildElement("state").text();
+        qCDebug(lcClient) << "[STATUS] State:" << state;
+        status.state = state;
+
+        QDomElement inputs = statusElem.firstChildElement("inputs");
+        for (QDomElement input = inputs.firstChildElement("input"); !input.isNull();
+             input = input.nextSiblingElement("input")) {
+            qCDebug(lcClient) << "  [INPUT]" << input.attribute("name") << "=" << input.text();
+            status.inputs.insert(input.attribute("name"), input.text());
+        }
+
+        QDomElement outputs = statusElem.firstChildElement("outputs");
+        for (QDomElement output = outputs.firstChildElement("output"); !output.isNull();
+             output = output.nextSiblingElement("output")) {
+            qCDebug(lcClient) << "  [OUTPUT]" << output.attribute("name") << "=" << output.text();
+            status.outputs.insert(output.attribute("name"), output.text());
+        }
+
+        QDomElement vars = statusElem.firstChildElement("variables");
+        for (QDomElement var = vars.firstChildElement("var"); !var.isNull();
+             var = var.nextSiblingElement("var")) {
+            QString varName = var.attribute("name");
+            QString varType = var.attribute("type");
+            QString varValue = var.text();
+            qCDebug(lcClient) << "  [VAR]" << varName << "(" << varType << ") =" << varValue;
+            status.variables.append({varName, varType, varValue});
+        }
+
+        QDomElement timers = statusElem.firstChildElement("timers");
+        for (QDomElement timer = timers.firstChildElement("timer"); !timer.isNull();
+             timer = timer.nextSiblingElement("timer")) {
+            QString from = timer.firstChildElement("from").text();
+            QString to = timer.firstChildElement("to").text();
+            QString ms = timer.firstChildElement("ms").text();
+            qCDebug(lcClient) << "  [TIMER] from" << from << "to" << to << "remaining:" << ms << "ms";
+            status.timers.append({from, to, ms});
+        }
+
+        QDomElement clients = statusElem.firstChildElement("clients");
+        status.slowClientPolicy = clients.attribute("policy");
+        status.slowClientsDisconnected = clients.attribute("disconnected").toULongLong();
+        status.conflationWindow = clients.attribute("conflate").toInt();
+        status.conflated = clients.attribute("conflated").toULongLong();
+        for (QDomElement client = clients.firstChildElement("client"); !client.isNull();
+             client = client.nextSiblingElement("client")) {
+            FsmStatus::Client stats;
+            stats.address = client.attribute("address");
+            stats.framing = client.attribute("framing");
+            stats.queued = client.attribute("queued").toLongLong();
+            stats.sent = client.attribute("sent").toULongLong();
+            stats.dropped = client.attribute("dropped").toULongLong();
+            stats.coalesced = client.attribute("coalesced").toULongLong();
+            qCDebug(lcClient) << "  [CLIENT]" << stats.address << stats.framing << "queued:" << stats.queued
+                     << "sent:" << stats.sent << "dropped:" << stats.dropped << "coalesced:" << stats.coalesced;
+            status.clients.append(stats);
+        }
+        emit fsmStatus(status);
+    } else {
+        qCDebug(lcClient) << "[EVENT] type=" << type;
+    }
+}
@@ -9,8 +9,13 @@
 #pragma once
 
 #include <QDomDocument>
+#include <QLocalSocket>
 #include <QObject>
+#include <QSharedMemory>
 #include <QTcpSocket>
+#include <QTimer>
+
+#include "runtime/XmlMessageReader.hpp"
 
 struct FsmStatus {
     QString state;
@@ -24,12 +29,31 @@ struct FsmStatus {
         QString from, to, ms;
     };
     QList<Timer> timers;
+    struct Client {
+        QString address, framing;
+        qint64 queued = 0;
+        quint64 sent = 0, dropped = 0, coalesced = 0;
+    };
+    QList<Client> clients;
+    QString slowClientPolicy;
+    quint64 slowClientsDisconnected = 0;
+    int conflationWindow = 0;
+    quint64 conflated = 0;
 };
 Q_DECLARE_METATYPE(FsmStatus)
 
 class GuiClient : public QObject {
     Q_OBJECT
    public:
+    /**
+     * @brief One operation of a batch command.
+     */
+    struct BatchItem {
+        QString name;       // Name of the input.
+        QString value;      // New value, ignored for calls.
+        bool call = false;  // Dispatch the input with its last value instead of setting it.
+    };
+
     /**
      * @brief Construct a new GuiClient object for TCP communication.
      *
@@ -47,6 +71,31 @@ class GuiClient : public QObject {
      */
     void connectToServer();
 
+    /**
+     * @brief Connect to an FSM server on the same machine over its local socket.
+     *
+     * The server has to be started with --local and the same name. Commands and events are the same as over TCP.
+     *
+     * @param name Name of the local socket.
+     */
+    void connectToLocalServer(const QString &name);
+
+    /**
+     * @brief Read the machine events from the shared-memory stream of a server started with --shm.
+     *
+     * Events are polled from the shared memory instead of being sent over the connection, which then only
+     * carries commands and their replies; if connected, the client unsubscribes from socket events.
+     *
+     * @param key Key of the shared-memory segment.
+     * @return True if the segment was found and is a compatible event stream.
+     */
+    bool attachSharedEvents(const QString &key);
+
+    /**
+     * @brief Stop reading the shared-memory event stream.
+     */
+    void detachSharedEvents();
+
     /**
      * @brief Send a raw XML command to the FSM server.
      *
@@ -60,20 +109,45 @@ class GuiClient : public QObject {
      *
      * @param name Name of the input.
      * @param value Value to set.
+     * @param instance Machine instance to address, -1 for the server default.
      */
-    void sendSet(const QString &name, const QString &value);
+    void sendSet(const QString &name, const QString &value, int instance = -1);
 
     /**
      * @brief Send a 'call' command to the FSM server.
      *
      * @param name Name of the input to call.
+     * @param instance Machine instance to address, -1 for the server default.
      */
-    void sendCall(const QString &name);
+    void sendCall(const QString &name, int instance = -1);
+
+    /**
+     * @brief Send several set/call operations in one 'batch' command.
+     *
+     * @param items Operations in the order they are applied.
+     * @param atomic Store all values before a single dispatch pass (true) or dispatch item by item (false).
+     * @param instance Machine instance to address, -1 for the server default.
+     */
+    void sendBatch(const QList<BatchItem> &items, bool atomic = true, int instance = -1);
 
     /**
      * @brief Request the current status from the FSM server.
+     *
+     * @param instance Machine instance to report, -1 for the server default.
+     */
+    void sendStatus(int instance = -1);
+
+    /**
+     * @brief Choose which events the FSM server sends to this client.
+     *
+     * Calling it with empty lists restores the default of receiving every event.
+     *
+     * @param events Event types: stateChange, input, output, variable, timer, timerStart or timerExpired. Empty for
+     * all types.
+     * @param names Input, output and variable names to receive value events for. Empty for all names.
+     * @param instance Only receive events of this machine instance, -1 for all instances.
      */
-    void sendStatus();
+    void sendSubscribe(const QStringList &events, const QStringList &names = {}, int instance = -1);
 
     /**
      * @brief Request help information from the FSM server.
@@ -100,6 +174,20 @@ class GuiClient : public QObject {
      */
     void sendPong();
 
+    /**
+     * @brief Ask the FSM server to switch this connection to binary framing.
+     *
+     * Once the server acknowledges, events arrive as length-prefixed frames and set/call commands are sent as
+     * frames too. The emitted signals are the same as with the XML protocol.
+     */
+    void requestBinaryProtocol();
+
+    /**
+     * @brief Check if the connection uses binary framing.
+     * @return True after the server acknowledged the binary protocol.
+     */
+    bool isBinary() const { return m_binary; }
+
     /**
      * @brief Set the host address for the FSM server.
      * @param host Hostname or IP address.
@@ -128,13 +216,14 @@ class GuiClient : public QObject {
      * @brief Check if the client is currently connected to the FSM server.
      * @return True if connected, false otherwise.
      */
-    bool isConnected() const { return socket && socket->state() == QAbstractSocket::ConnectedState; }
+    bool isConnected() const;
 
    public slots:
     /**
      * @brief Handle incoming data from the FSM server.
      *
-     * Processes all received XML events and commands.
+     * Processes all received XML events and commands, or binary frames once the
+     * connection switched to binary framing.
      */
     void onReadyRead();
 
@@ -209,9 +298,60 @@ class GuiClient : public QObject {
 
    private:
     /**
-     * @brief TCP socket used for communication with the FSM server.
+     * @brief Handle one XML event received from the FSM server.
+     *
+     * Flat events are read with XmlMessage without building a DOM.
+     *
+     * @param data The event, a line without terminator or the payload of an XML frame.
+     * @param size Length of the event in bytes.
      */
-    QTcpSocket *socket;
+    void handleXmlEvent(const char *data, int size);
+
+    /**
+     * @brief Handle an event with nested elements (status report, FSM model).
+     *
+     * @param root The event element.
+     */
+    void handleDomEvent(const QDomElement &root);
+
+    /**
+     * @brief Handle one binary frame received from the FSM server.
+     *
+     * @param type Frame type.
+     * @param payload Frame payload without the length and type header.
+     */
+    void handleFrame(quint8 type, const QByteArray &payload);
+
+    /**
+     * @brief Write a binary frame to the FSM server.
+     *
+     * @param type Frame type.
+     * @param payload Frame payload.
+     */
+    void writeFrame(quint8 type, const QByteArray &payload);
+
+    /**
+     * @brief Write the buffered data of the active socket without waiting for the event loop.
+     */
+    void flushSocket();
+
+    /**
+     * @brief Handle the events published to the shared-memory stream since the last poll.
+     */
+    void readSharedEvents();
+
+    /**
+     * @brief Socket of the active connection, m_tcpSocket or m_localSocket.
+     */
+    QIODevice *socket;
+    /**
+     * @brief TCP socket used for communication with a (possibly remote) FSM server.
+     */
+    QTcpSocket *m_tcpSocket;
+    /**
+     * @brief Local socket used for communication with an FSM server on the same machine.
+     */
+    QLocalSocket *m_localSocket;
     /**
      * @brief Hostname or IP address of the FSM server.
      */
@@ -220,4 +360,32 @@ class GuiClient : public QObject {
      * @brief TCP port number of the FSM server.
      */
     quint16 m_port;
+    /**
+     * @brief Reused buffer for the XML lines received from the FSM server.
+     */
+    XmlLineReader m_lineReader;
+    /**
+     * @brief True once the server switched the connection to binary framing.
+     */
+    bool m_binary = false;
+    /**
+     * @brief Name tables received from the server, indexed by the IDs used in binary frames.
+     */
+    QStringList m_stateNames, m_inputNames, m_outputNames, m_variableNames;
+    /**
+     * @brief Attached shared-memory event stream, null if events arrive over the connection.
+     */
+    QSharedMemory *m_sharedEvents = nullptr;
+    /**
+     * @brief First byte of the ring inside the shared-memory segment.
+     */
+    const char *m_sharedRing = nullptr;
+    /**
+     * @brief Stream position up to which the shared events were handled.
+     */
+    quint64 m_sharedReadPos = 0;
+    /**
+     * @brief Polls the shared-memory event stream.
+     */
+    QTimer *m_sharedPoll;
 };
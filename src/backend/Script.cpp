@@ -0,0 +1,1060 @@
+/**
+ * @file Script.cpp
+ * @brief Implementation of the Script class evaluating guards, delays and state actions without compiling them.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "Script.hpp"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "runtime/FsmRuntime.hpp"
+
+/**
+ * @brief Operators of the script language.
+ */
+enum ScriptOp {
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_EQ,
+    OP_NE,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_AND,
+    OP_OR,
+    OP_NOT,
+    OP_NEG,
+    OP_PLUS,
+    OP_ASSIGN
+};
+
+/**
+ * @brief Functions of the helper API available to scripts.
+ */
+enum ScriptFunction {
+    FN_VALUEOF,
+    FN_DEFINED,
+    FN_CALLED,
+    FN_OUTPUT,
+    FN_ELAPSED,
+    FN_ELAPSED_MICROS,
+    FN_QTOI,
+    FN_LOG,
+    FN_DEBUG,
+    FN_NUMBER
+};
+
+/**
+ * @brief Node of a parsed script.
+ */
+struct ScriptNode {
+    enum Kind {
+        LITERAL,      // value
+        VARIABLE,     // Machine variable index
+        LOCAL,        // Local variable index and type
+        CALL,         // Helper function index, arguments as children
+        METHOD,       // QString method name, object as the only child
+        CAST,         // Conversion to type
+        UNARY,        // op applied to the child
+        INCREMENT,    // ++/-- (op OP_ADD/OP_SUB) of the target child, postfix or prefix
+        BINARY,       // op applied to both children
+        CONDITIONAL,  // condition ? children[1] : children[2]
+        ASSIGN,       // Target child op= value child, op OP_ASSIGN for a plain assignment
+        BLOCK,        // Statements
+        IF,           // Condition, then and optional else statement
+        DECLARE,      // Local variable index and type, optional initializer child
+        RETURN        // Optional value child
+    };
+
+    Kind kind;
+    QVariant value;
+    int index = -1;
+    int type = 0;
+    int op = OP_ASSIGN;
+    bool postfix = false;
+    QString name;
+    std::vector<std::unique_ptr<ScriptNode>> children;
+
+    explicit ScriptNode(Kind nodeKind) : kind(nodeKind) {}
+};
+
+namespace {
+
+typedef std::unique_ptr<ScriptNode> NodePtr;
+
+/**
+ * @brief Parse error, carries the message shown to the user.
+ */
+struct ScriptError {
+    QString message;
+};
+
+/**
+ * @brief Helper function a script may call.
+ */
+struct FunctionInfo {
+    const char* name;
+    int arity;
+    ScriptFunction id;
+};
+
+const FunctionInfo kFunctions[] = {
+    {"valueof", 1, FN_VALUEOF}, {"defined", 1, FN_DEFINED}, {"called", 1, FN_CALLED},
+    {"output", 2, FN_OUTPUT},   {"elapsed", 0, FN_ELAPSED}, {"Qtoi", 1, FN_QTOI},
+    {"atoi", 1, FN_QTOI},       {"log", 1, FN_LOG},         {"debug", 1, FN_DEBUG},
+    {"QString::number", 1, FN_NUMBER}, {"elapsedMicros", 0, FN_ELAPSED_MICROS},
+};
+
+// Longest operators first, so "<=" is not read as "<" followed by "="
+const char* const kOperators[] = {"::", "==", "!=", "<=", ">=", "&&", "||", "++", "--", "+=", "-=", "*=", "/=", "%=",
+                                  "+",  "-",  "*",  "/",  "%",  "<",  ">",  "=",  "!",  "?",  ":",  ";",  ",",  "(",
+                                  ")",  "{",  "}",  "."};
+
+const char* const kTypeNames[] = {"int",    "long",  "short",   "unsigned", "signed", "float", "double",
+                                  "bool",   "char",  "QString", "auto",     "qint64", "size_t"};
+
+/**
+ * @brief Lexical token of a script.
+ */
+struct Token {
+    enum Kind { END, NUMBER, STRING, IDENT, OP };
+    Kind kind = END;
+    QString text;
+    QVariant value;
+};
+
+/**
+ * @brief Recursive descent parser building the node tree of a script.
+ */
+class Parser {
+   public:
+    Parser(const QString& source, const QStringList& variables) : m_source(source), m_variables(variables) {
+        m_scopes.append(QHash<QString, QPair<int, int>>());
+        next();
+    }
+
+    NodePtr parseExpressionScript() {
+        NodePtr node = parseAssignment();
+        expectEnd();
+        return node;
+    }
+
+    NodePtr parseStatementsScript() {
+        NodePtr block(new ScriptNode(ScriptNode::BLOCK));
+        while (m_token.kind != Token::END) {
+            if (NodePtr statement = parseStatement()) {
+                block->children.push_back(std::move(statement));
+            }
+        }
+        return block;
+    }
+
+    int localCount() const { return m_localCount; }
+
+   private:
+    [[noreturn]] void fail(const QString& message) {
+        QString near = m_token.kind == Token::END ? QStringLiteral("end of code") : "'" + m_token.text + "'";
+        throw ScriptError{message + " near " + near};
+    }
+
+    bool isOp(const char* op) const { return m_token.kind == Token::OP && m_token.text == QLatin1String(op); }
+
+    bool isIdent(const char* ident) const {
+        return m_token.kind == Token::IDENT && m_token.text == QLatin1String(ident);
+    }
+
+    void expect(const char* op) {
+        if (!isOp(op)) {
+            fail(QString("Expected '%1'").arg(op));
+        }
+        next();
+    }
+
+    void expectEnd() {
+        if (m_token.kind != Token::END) {
+            fail("Unexpected code");
+        }
+    }
+
+    bool isTypeName() const {
+        if (m_token.kind != Token::IDENT) {
+            return false;
+        }
+        for (const char* type : kTypeNames) {
+            if (m_token.text == QLatin1String(type)) {
+                return true;
+            }
+        }
+        return m_token.text == QLatin1String("const") || isStdString();
+    }
+
+    /**
+     * @brief Check whether the current token starts std::string, which the lexer splits into std, :: and string.
+     * @return True if the current token is std followed by ::string.
+     */
+    bool isStdString() const {
+        static const QRegularExpression rest("^\\s*::\\s*string\\b");
+        return isIdent("std") && rest.match(m_source.mid(m_pos)).hasMatch();
+    }
+
+    /**
+     * @brief Reads a type made of one or more type keywords (unsigned long, const QString, ...).
+     * @return QMetaType id of the type.
+     */
+    int parseType() {
+        QStringList words;
+        while (isTypeName()) {
+            if (isStdString()) {
+                next();
+                next();
+                words << "std::string";
+            } else if (m_token.text != QLatin1String("const")) {
+                words << m_token.text;
+            }
+            next();
+        }
+        if (words.isEmpty()) {
+            fail("Expected a type");
+        }
+        return Script::typeOf(words.join(' '));
+    }
+
+    // Lexer
+
+    void skipSpaceAndComments() {
+        while (m_pos < m_source.size()) {
+            if (m_source[m_pos].isSpace()) {
+                ++m_pos;
+            } else if (m_source.mid(m_pos, 2) == QLatin1String("//")) {
+                int end = m_source.indexOf('\n', m_pos);
+                m_pos = end < 0 ? m_source.size() : end + 1;
+            } else if (m_source.mid(m_pos, 2) == QLatin1String("/*")) {
+                int end = m_source.indexOf("*/", m_pos + 2);
+                if (end < 0) {
+                    throw ScriptError{"Unterminated comment"};
+                }
+                m_pos = end + 2;
+            } else {
+                return;
+            }
+        }
+    }
+
+    void next() {
+        skipSpaceAndComments();
+        m_token = Token();
+        if (m_pos >= m_source.size()) {
+            return;
+        }
+        const int start = m_pos;
+        const QChar c = m_source[m_pos];
+        if (c.isDigit() || (c == '.' && m_pos + 1 < m_source.size() && m_source[m_pos + 1].isDigit())) {
+            readNumber();
+        } else if (c.isLetter() || c == '_') {
+            while (m_pos < m_source.size() && (m_source[m_pos].isLetterOrNumber() || m_source[m_pos] == '_')) {
+                ++m_pos;
+            }
+            m_token.kind = Token::IDENT;
+        } else if (c == '"' || c == '\'') {
+            readString(c);
+        } else {
+            for (const char* op : kOperators) {
+                const QLatin1String text(op);
+                if (m_source.mid(m_pos, text.size()) == text) {
+                    m_pos += text.size();
+                    m_token.kind = Token::OP;
+                    break;
+                }
+            }
+            if (m_token.kind != Token::OP) {
+                m_token.text = c;
+                fail("Unsupported character");
+            }
+        }
+        if (m_token.text.isEmpty()) {
+            m_token.text = m_source.mid(start, m_pos - start);
+        }
+    }
+
+    void readNumber() {
+        const int start = m_pos;
+        bool isFloat = false;
+        if (m_source.mid(m_pos, 2).toLower() == QLatin1String("0x")) {
+            m_pos += 2;
+            while (m_pos < m_source.size() && isxdigit(m_source[m_pos].toLatin1())) {
+                ++m_pos;
+            }
+            const int digitsEnd = m_pos;
+            while (m_pos < m_source.size() && QString("lLuU").contains(m_source[m_pos])) {
+                ++m_pos;
+            }
+            bool ok = false;
+            qlonglong value = m_source.mid(start + 2, digitsEnd - start - 2).toLongLong(&ok, 16);
+            if (!ok) {
+                m_token.text = m_source.mid(start, m_pos - start);
+                fail("Invalid number");
+            }
+            m_token.kind = Token::NUMBER;
+            m_token.value = integer(value);
+            return;
+        }
+        while (m_pos < m_source.size()) {
+            const QChar c = m_source[m_pos];
+            if (c.isDigit()) {
+                ++m_pos;
+            } else if (c == '.') {
+                isFloat = true;
+                ++m_pos;
+            } else if ((c == 'e' || c == 'E') && m_pos + 1 < m_source.size() &&
+                       (m_source[m_pos + 1].isDigit() || m_source[m_pos + 1] == '+' || m_source[m_pos + 1] == '-')) {
+                isFloat = true;
+                m_pos += 2;
+            } else {
+                break;
+            }
+        }
+        const QString digits = m_source.mid(start, m_pos - start);
+        // Suffixes (1.5f, 10L, 3u) only select a C++ type, the value stays the same
+        while (m_pos < m_source.size() && QString("fFlLuU").contains(m_source[m_pos])) {
+            isFloat = isFloat || m_source[m_pos].toLower() == 'f';
+            ++m_pos;
+        }
+        bool ok = false;
+        m_token.kind = Token::NUMBER;
+        if (isFloat) {
+            m_token.value = digits.toDouble(&ok);
+        } else {
+            m_token.value = integer(digits.toLongLong(&ok));
+        }
+        if (!ok) {
+            m_token.text = m_source.mid(start, m_pos - start);
+            fail("Invalid number");
+        }
+    }
+
+    static QVariant integer(qlonglong value) {
+        if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+            return QVariant(static_cast<int>(value));
+        }
+        return QVariant(value);
+    }
+
+    void readString(QChar quote) {
+        QString text;
+        ++m_pos;
+        while (true) {
+            if (m_pos >= m_source.size() || m_source[m_pos] == '\n') {
+                throw ScriptError{"Unterminated string literal"};
+            }
+            QChar c = m_source[m_pos++];
+            if (c == quote) {
+                break;
+            }
+            if (c == '\\' && m_pos < m_source.size()) {
+                c = m_source[m_pos++];
+                switch (c.unicode()) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case '0': c = QChar(0); break;
+                    default: break;
+                }
+            }
+            text += c;
+        }
+        m_token.kind = Token::STRING;
+        m_token.value = text;
+    }
+
+    // Statements
+
+    NodePtr parseStatement() {
+        if (isOp(";")) {
+            next();
+            return nullptr;
+        }
+        if (isOp("{")) {
+            next();
+            NodePtr block(new ScriptNode(ScriptNode::BLOCK));
+            m_scopes.append(QHash<QString, QPair<int, int>>());
+            while (!isOp("}")) {
+                if (m_token.kind == Token::END) {
+                    fail("Expected '}'");
+                }
+                if (NodePtr statement = parseStatement()) {
+                    block->children.push_back(std::move(statement));
+                }
+            }
+            m_scopes.removeLast();
+            next();
+            return block;
+        }
+        if (isIdent("if")) {
+            next();
+            NodePtr node(new ScriptNode(ScriptNode::IF));
+            expect("(");
+            node->children.push_back(parseAssignment());
+            expect(")");
+            node->children.push_back(statementOrEmpty());
+            if (isIdent("else")) {
+                next();
+                node->children.push_back(statementOrEmpty());
+            }
+            return node;
+        }
+        if (isIdent("return")) {
+            next();
+            NodePtr node(new ScriptNode(ScriptNode::RETURN));
+            if (!isOp(";")) {
+                node->children.push_back(parseAssignment());
+            }
+            expect(";");
+            return node;
+        }
+        if (isIdent("while") || isIdent("for") || isIdent("do") || isIdent("switch")) {
+            fail("Loops and switch are not supported by the interpreter");
+        }
+        if (isTypeName()) {
+            return parseDeclaration();
+        }
+        NodePtr node = parseAssignment();
+        expect(";");
+        return node;
+    }
+
+    NodePtr statementOrEmpty() {
+        NodePtr statement = parseStatement();
+        return statement ? std::move(statement) : NodePtr(new ScriptNode(ScriptNode::BLOCK));
+    }
+
+    NodePtr parseDeclaration() {
+        const int type = parseType();
+        NodePtr block(new ScriptNode(ScriptNode::BLOCK));
+        while (true) {
+            if (m_token.kind != Token::IDENT) {
+                fail("Expected a variable name");
+            }
+            const QString name = m_token.text;
+            if (m_scopes.last().contains(name)) {
+                fail("Redeclaration of '" + name + "'");
+            }
+            next();
+            NodePtr node(new ScriptNode(ScriptNode::DECLARE));
+            node->index = m_localCount++;
+            node->type = type;
+            node->name = name;
+            if (isOp("=")) {
+                next();
+                node->children.push_back(parseAssignment());
+            }
+            // In scope from here on, the initializer cannot refer to the variable itself
+            m_scopes.last().insert(name, qMakePair(node->index, type));
+            block->children.push_back(std::move(node));
+            if (!isOp(",")) {
+                break;
+            }
+            next();
+        }
+        expect(";");
+        return block;
+    }
+
+    // Expressions
+
+    NodePtr parseAssignment() {
+        NodePtr target = parseConditional();
+        int op = -1;
+        if (isOp("=")) {
+            op = OP_ASSIGN;
+        } else if (isOp("+=")) {
+            op = OP_ADD;
+        } else if (isOp("-=")) {
+            op = OP_SUB;
+        } else if (isOp("*=")) {
+            op = OP_MUL;
+        } else if (isOp("/=")) {
+            op = OP_DIV;
+        } else if (isOp("%=")) {
+            op = OP_MOD;
+        }
+        if (op < 0) {
+            return target;
+        }
+        requireAssignable(*target);
+        next();
+        NodePtr node(new ScriptNode(ScriptNode::ASSIGN));
+        node->op = op;
+        node->children.push_back(std::move(target));
+        node->children.push_back(parseAssignment());
+        return node;
+    }
+
+    void requireAssignable(const ScriptNode& node) {
+        if (node.kind != ScriptNode::VARIABLE && node.kind != ScriptNode::LOCAL) {
+            fail("Only variables can be assigned");
+        }
+    }
+
+    NodePtr parseConditional() {
+        NodePtr condition = parseBinary(0);
+        if (!isOp("?")) {
+            return condition;
+        }
+        next();
+        NodePtr node(new ScriptNode(ScriptNode::CONDITIONAL));
+        node->children.push_back(std::move(condition));
+        node->children.push_back(parseAssignment());
+        expect(":");
+        node->children.push_back(parseConditional());
+        return node;
+    }
+
+    /**
+     * @brief Gets the binary operator of the current token at a precedence level.
+     * @param level 0 (||) .. 5 (* / %).
+     * @return The operator, or -1 if the token is not an operator of that level.
+     */
+    int binaryOp(int level) const {
+        if (m_token.kind != Token::OP) {
+            return -1;
+        }
+        const QString& t = m_token.text;
+        switch (level) {
+            case 0: return t == QLatin1String("||") ? OP_OR : -1;
+            case 1: return t == QLatin1String("&&") ? OP_AND : -1;
+            case 2: return t == QLatin1String("==") ? OP_EQ : t == QLatin1String("!=") ? OP_NE : -1;
+            case 3:
+                return t == QLatin1String("<")    ? OP_LT
+                       : t == QLatin1String("<=") ? OP_LE
+                       : t == QLatin1String(">")  ? OP_GT
+                       : t == QLatin1String(">=") ? OP_GE
+                                                  : -1;
+            case 4: return t == QLatin1String("+") ? OP_ADD : t == QLatin1String("-") ? OP_SUB : -1;
+            case 5:
+                return t == QLatin1String("*")   ? OP_MUL
+                       : t == QLatin1String("/") ? OP_DIV
+                       : t == QLatin1String("%") ? OP_MOD
+                                                 : -1;
+        }
+        return -1;
+    }
+
+    NodePtr parseBinary(int level) {
+        if (level > 5) {
+            return parseUnary();
+        }
+        NodePtr left = parseBinary(level + 1);
+        for (int op = binaryOp(level); op >= 0; op = binaryOp(level)) {
+            next();
+            NodePtr node(new ScriptNode(ScriptNode::BINARY));
+            node->op = op;
+            node->children.push_back(std::move(left));
+            node->children.push_back(parseBinary(level + 1));
+            left = std::move(node);
+        }
+        return left;
+    }
+
+    NodePtr parseUnary() {
+        if (isOp("!") || isOp("-") || isOp("+")) {
+            const int op = isOp("!") ? OP_NOT : isOp("-") ? OP_NEG : OP_PLUS;
+            next();
+            NodePtr node(new ScriptNode(ScriptNode::UNARY));
+            node->op = op;
+            node->children.push_back(parseUnary());
+            return node;
+        }
+        if (isOp("++") || isOp("--")) {
+            const int op = isOp("++") ? OP_ADD : OP_SUB;
+            next();
+            NodePtr target = parseUnary();
+            requireAssignable(*target);
+            NodePtr node(new ScriptNode(ScriptNode::INCREMENT));
+            node->op = op;
+            node->children.push_back(std::move(target));
+            return node;
+        }
+        return parsePostfix();
+    }
+
+    NodePtr parsePostfix() {
+        NodePtr node = parsePrimary();
+        while (true) {
+            if (isOp("++") || isOp("--")) {
+                requireAssignable(*node);
+                NodePtr increment(new ScriptNode(ScriptNode::INCREMENT));
+                increment->op = isOp("++") ? OP_ADD : OP_SUB;
+                increment->postfix = true;
+                increment->children.push_back(std::move(node));
+                node = std::move(increment);
+                next();
+            } else if (isOp(".")) {
+                next();
+                if (m_token.kind != Token::IDENT) {
+                    fail("Expected a method name");
+                }
+                static const QStringList methods = {"toInt", "toDouble", "isEmpty", "length", "size", "trimmed",
+                                                    "toUpper", "toLower"};
+                if (!methods.contains(m_token.text)) {
+                    fail("Unsupported method");
+                }
+                NodePtr method(new ScriptNode(ScriptNode::METHOD));
+                method->name = m_token.text;
+                method->children.push_back(std::move(node));
+                node = std::move(method);
+                next();
+                expect("(");
+                expect(")");
+            } else {
+                return node;
+            }
+        }
+    }
+
+    NodePtr parsePrimary() {
+        if (m_token.kind == Token::NUMBER || m_token.kind == Token::STRING) {
+            NodePtr node(new ScriptNode(ScriptNode::LITERAL));
+            node->value = m_token.value;
+            next();
+            return node;
+        }
+        if (isOp("(")) {
+            next();
+            if (isTypeName()) {
+                // C-style cast, (int) x
+                NodePtr cast(new ScriptNode(ScriptNode::CAST));
+                cast->type = parseType();
+                expect(")");
+                cast->children.push_back(parseUnary());
+                return cast;
+            }
+            NodePtr node = parseAssignment();
+            expect(")");
+            return node;
+        }
+        if (m_token.kind != Token::IDENT) {
+            fail("Expected an expression");
+        }
+        QString name = m_token.text;
+        next();
+        if (name == QLatin1String("true") || name == QLatin1String("false")) {
+            NodePtr node(new ScriptNode(ScriptNode::LITERAL));
+            node->value = name == QLatin1String("true");
+            return node;
+        }
+        if (isOp("::")) {
+            next();
+            if (m_token.kind != Token::IDENT) {
+                fail("Expected a name");
+            }
+            name += "::" + m_token.text;
+            next();
+        }
+        if (isOp("(")) {
+            return parseCall(name);
+        }
+        for (int i = m_scopes.size() - 1; i >= 0; --i) {
+            auto local = m_scopes[i].constFind(name);
+            if (local != m_scopes[i].constEnd()) {
+                NodePtr node(new ScriptNode(ScriptNode::LOCAL));
+                node->index = local.value().first;
+                node->type = local.value().second;
+                node->name = name;
+                return node;
+            }
+        }
+        const int variable = m_variables.indexOf(name);
+        if (variable < 0) {
+            throw ScriptError{"Unknown identifier '" + name + "'"};
+        }
+        NodePtr node(new ScriptNode(ScriptNode::VARIABLE));
+        node->index = variable;
+        node->name = name;
+        return node;
+    }
+
+    NodePtr parseCall(const QString& name) {
+        const FunctionInfo* function = nullptr;
+        for (const FunctionInfo& candidate : kFunctions) {
+            if (name == QLatin1String(candidate.name)) {
+                function = &candidate;
+            }
+        }
+        if (!function) {
+            throw ScriptError{"Unknown function '" + name + "'"};
+        }
+        NodePtr node(new ScriptNode(ScriptNode::CALL));
+        node->index = function->id;
+        node->name = name;
+        expect("(");
+        while (!isOp(")")) {
+            node->children.push_back(parseAssignment());
+            if (!isOp(",")) {
+                break;
+            }
+            next();
+        }
+        expect(")");
+        if (static_cast<int>(node->children.size()) != function->arity) {
+            throw ScriptError{QString("%1() takes %2 argument(s)").arg(name).arg(function->arity)};
+        }
+        return node;
+    }
+
+    const QString m_source;
+    const QStringList m_variables;
+    int m_pos = 0;
+    Token m_token;
+    QVector<QHash<QString, QPair<int, int>>> m_scopes;  // Name -> (local index, type) per block
+    int m_localCount = 0;
+};
+
+/**
+ * @brief Values a running script works on.
+ */
+struct ScriptFrame {
+    QVector<QVariant>& variables;  // Machine variables
+    QVector<QVariant> locals;      // Local variables of the script
+    bool returned = false;         // Set by return, stops the statements
+    QVariant result;               // Value given to return
+};
+
+bool isIntegral(const QVariant& value) {
+    switch (value.userType()) {
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong: return true;
+        default: return false;
+    }
+}
+
+bool isNumeric(const QVariant& value) {
+    return isIntegral(value) || value.userType() == QMetaType::Double || value.userType() == QMetaType::Float;
+}
+
+QVariant integerResult(qlonglong value, const QVariant& a, const QVariant& b) {
+    if (a.userType() == QMetaType::LongLong || b.userType() == QMetaType::LongLong) {
+        return QVariant(value);
+    }
+    return QVariant(static_cast<int>(value));
+}
+
+QVariant evaluate(const ScriptNode& node, ScriptFrame& frame);
+
+QVariant arithmetic(int op, const QVariant& a, const QVariant& b) {
+    if (op == OP_ADD && (!isNumeric(a) || !isNumeric(b))) {
+        return a.toString() + b.toString();
+    }
+    if (!isNumeric(a) || !isNumeric(b)) {
+        throw std::runtime_error("Arithmetic on a string, convert it with Qtoi() first");
+    }
+    if (isIntegral(a) && isIntegral(b)) {
+        const qlonglong x = a.toLongLong();
+        const qlonglong y = b.toLongLong();
+        switch (op) {
+            case OP_ADD: return integerResult(x + y, a, b);
+            case OP_SUB: return integerResult(x - y, a, b);
+            case OP_MUL: return integerResult(x * y, a, b);
+            case OP_DIV:
+            case OP_MOD:
+                if (y == 0) {
+                    throw std::runtime_error("Division by zero");
+                }
+                return integerResult(op == OP_DIV ? x / y : x % y, a, b);
+        }
+    }
+    const double x = a.toDouble();
+    const double y = b.toDouble();
+    switch (op) {
+        case OP_ADD: return x + y;
+        case OP_SUB: return x - y;
+        case OP_MUL: return x * y;
+        case OP_DIV: return x / y;
+        default: throw std::runtime_error("Operator % needs integers");
+    }
+}
+
+bool compare(int op, const QVariant& a, const QVariant& b) {
+    int order;
+    if (isNumeric(a) && isNumeric(b)) {
+        const double x = a.toDouble();
+        const double y = b.toDouble();
+        order = x < y ? -1 : x > y ? 1 : 0;
+    } else {
+        order = QString::compare(a.toString(), b.toString());
+    }
+    switch (op) {
+        case OP_EQ: return order == 0;
+        case OP_NE: return order != 0;
+        case OP_LT: return order < 0;
+        case OP_LE: return order <= 0;
+        case OP_GT: return order > 0;
+        default: return order >= 0;
+    }
+}
+
+QVariant& slot(const ScriptNode& target, ScriptFrame& frame) {
+    return target.kind == ScriptNode::VARIABLE ? frame.variables[target.index] : frame.locals[target.index];
+}
+
+QVariant assign(const ScriptNode& target, ScriptFrame& frame, const QVariant& value) {
+    QVariant& stored = slot(target, frame);
+    // Machine variables keep the type they were declared with, locals the type of their declaration
+    const int type = target.kind == ScriptNode::VARIABLE ? stored.userType() : target.type;
+    stored = Script::coerce(value, type);
+    return stored;
+}
+
+QVariant call(const ScriptNode& node, ScriptFrame& frame) {
+    std::vector<QVariant> args;
+    for (const NodePtr& child : node.children) {
+        args.push_back(evaluate(*child, frame));
+    }
+    switch (node.index) {
+        case FN_VALUEOF: return valueof(args[0].toString());
+        case FN_DEFINED: return defined(args[0].toString());
+        case FN_CALLED: return called(args[0].toString());
+        case FN_OUTPUT: output(args[0].toString(), args[1]); return QVariant();
+        case FN_ELAPSED: return elapsed();
+        case FN_ELAPSED_MICROS: return elapsedMicros();
+        case FN_QTOI: return Qtoi(args[0].toString());
+        case FN_LOG: log(args[0].toString()); return QVariant();
+        case FN_DEBUG: debug(args[0].toString()); return QVariant();
+        case FN_NUMBER:
+            // Like QString::number(), doubles are formatted with 'g' and 6 digits rather than every digit of toString()
+            if (isIntegral(args[0])) {
+                return QString::number(args[0].toLongLong());
+            }
+            return isNumeric(args[0]) ? QString::number(args[0].toDouble()) : args[0].toString();
+    }
+    return QVariant();
+}
+
+QVariant method(const ScriptNode& node, ScriptFrame& frame) {
+    const QString text = evaluate(*node.children[0], frame).toString();
+    if (node.name == QLatin1String("toInt")) {
+        return text.toInt();
+    } else if (node.name == QLatin1String("toDouble")) {
+        return text.toDouble();
+    } else if (node.name == QLatin1String("isEmpty")) {
+        return text.isEmpty();
+    } else if (node.name == QLatin1String("trimmed")) {
+        return text.trimmed();
+    } else if (node.name == QLatin1String("toUpper")) {
+        return text.toUpper();
+    } else if (node.name == QLatin1String("toLower")) {
+        return text.toLower();
+    }
+    return text.size();
+}
+
+QVariant evaluate(const ScriptNode& node, ScriptFrame& frame) {
+    switch (node.kind) {
+        case ScriptNode::LITERAL: return node.value;
+        case ScriptNode::VARIABLE: return frame.variables[node.index];
+        case ScriptNode::LOCAL: return frame.locals[node.index];
+        case ScriptNode::CALL: return call(node, frame);
+        case ScriptNode::METHOD: return method(node, frame);
+        case ScriptNode::CAST: return Script::coerce(evaluate(*node.children[0], frame), node.type);
+        case ScriptNode::UNARY: {
+            const QVariant value = evaluate(*node.children[0], frame);
+            if (node.op == OP_NOT) {
+                return !Script::truth(value);
+            }
+            if (!isNumeric(value)) {
+                throw std::runtime_error("Sign of a string, convert it with Qtoi() first");
+            }
+            if (node.op == OP_PLUS) {
+                return value;
+            }
+            return arithmetic(OP_SUB, QVariant(0), value);
+        }
+        case ScriptNode::INCREMENT: {
+            const ScriptNode& target = *node.children[0];
+            const QVariant before = slot(target, frame);
+            const QVariant after = assign(target, frame, arithmetic(node.op, before, QVariant(1)));
+            return node.postfix ? before : after;
+        }
+        case ScriptNode::BINARY: {
+            if (node.op == OP_AND) {
+                return Script::truth(evaluate(*node.children[0], frame)) &&
+                       Script::truth(evaluate(*node.children[1], frame));
+            }
+            if (node.op == OP_OR) {
+                return Script::truth(evaluate(*node.children[0], frame)) ||
+                       Script::truth(evaluate(*node.children[1], frame));
+            }
+            const QVariant a = evaluate(*node.children[0], frame);
+            const QVariant b = evaluate(*node.children[1], frame);
+            if (node.op >= OP_EQ && node.op <= OP_GE) {
+                return compare(node.op, a, b);
+            }
+            return arithmetic(node.op, a, b);
+        }
+        case ScriptNode::CONDITIONAL:
+            return Script::truth(evaluate(*node.children[0], frame)) ? evaluate(*node.children[1], frame)
+                                                                     : evaluate(*node.children[2], frame);
+        case ScriptNode::ASSIGN: {
+            const ScriptNode& target = *node.children[0];
+            QVariant value = evaluate(*node.children[1], frame);
+            if (node.op != OP_ASSIGN) {
+                value = arithmetic(node.op, slot(target, frame), value);
+            }
+            return assign(target, frame, value);
+        }
+        default: return QVariant();
+    }
+}
+
+void execute(const ScriptNode& node, ScriptFrame& frame) {
+    switch (node.kind) {
+        case ScriptNode::BLOCK:
+            for (const NodePtr& statement : node.children) {
+                execute(*statement, frame);
+                if (frame.returned) {
+                    return;
+                }
+            }
+            break;
+        case ScriptNode::IF:
+            if (Script::truth(evaluate(*node.children[0], frame))) {
+                execute(*node.children[1], frame);
+            } else if (node.children.size() > 2) {
+                execute(*node.children[2], frame);
+            }
+            break;
+        case ScriptNode::DECLARE:
+            // An uninitialized local holds the default value of its type, auto always has an initializer
+            frame.locals[node.index] = node.children.empty()
+                                           ? (node.type == 0 ? QVariant() : QVariant(node.type, nullptr))
+                                           : Script::coerce(evaluate(*node.children[0], frame), node.type);
+            break;
+        case ScriptNode::RETURN:
+            frame.result = node.children.empty() ? QVariant() : evaluate(*node.children[0], frame);
+            frame.returned = true;
+            break;
+        default: evaluate(node, frame); break;
+    }
+}
+
+/**
+ * @brief Collect the machine variables a parsed script assigns or increments.
+ *
+ * @param node Root of the parsed script or one of its subtrees.
+ * @param writes Receives every written variable index once.
+ */
+void collectWrites(const ScriptNode& node, QVector<int>& writes) {
+    if ((node.kind == ScriptNode::ASSIGN || node.kind == ScriptNode::INCREMENT) &&
+        node.children[0]->kind == ScriptNode::VARIABLE && !writes.contains(node.children[0]->index)) {
+        writes.append(node.children[0]->index);
+    }
+    for (const NodePtr& child : node.children) {
+        if (child) {
+            collectWrites(*child, writes);
+        }
+    }
+}
+
+}  // namespace
+
+Script::Script() = default;
+Script::~Script() = default;
+Script::Script(Script&& other) noexcept = default;
+Script& Script::operator=(Script&& other) noexcept = default;
+
+bool Script::compile(const QString& source, const QStringList& variables, Mode mode, QString& error) {
+    try {
+        Parser parser(source, variables);
+        m_root = mode == Expression ? parser.parseExpressionScript() : parser.parseStatementsScript();
+        m_localCount = parser.localCount();
+        m_writes.clear();
+        if (m_root) {
+            collectWrites(*m_root, m_writes);
+        }
+        return true;
+    } catch (const ScriptError& e) {
+        m_root.reset();
+        m_writes.clear();
+        error = e.message;
+        return false;
+    }
+}
+
+bool Script::isCompiled() const { return m_root != nullptr; }
+
+const QVector<int>& Script::writtenVariables() const { return m_writes; }
+
+QVariant Script::run(QVector<QVariant>& variables) const {
+    if (!m_root) {
+        return QVariant();
+    }
+    ScriptFrame frame{variables, QVector<QVariant>(m_localCount)};
+    if (m_root->kind == ScriptNode::BLOCK) {
+        execute(*m_root, frame);
+        return frame.result;
+    }
+    return evaluate(*m_root, frame);
+}
+
+bool Script::truth(const QVariant& value) {
+    if (!value.isValid()) {
+        return false;
+    }
+    if (value.userType() == QMetaType::QString) {
+        return !value.toString().isEmpty();
+    }
+    if (isNumeric(value)) {
+        return value.toDouble() != 0;
+    }
+    return value.toBool();
+}
+
+QVariant Script::coerce(const QVariant& value, int type) {
+    if (type == 0 || value.userType() == type) {
+        return value;
+    }
+    switch (type) {
+        case QMetaType::Int:
+            // C++ truncates a double stored into an int
+            return value.userType() == QMetaType::Double ? static_cast<int>(value.toDouble()) : value.toInt();
+        case QMetaType::LongLong: return value.toLongLong();
+        case QMetaType::Double: return value.toDouble();
+        case QMetaType::Bool: return truth(value);
+        case QMetaType::QString: return value.toString();
+        default: return value;
+    }
+}
+
+int Script::typeOf(const QString& typeName) {
+    const QString type = typeName.simplified();
+    if (type == QLatin1String("auto")) {
+        return 0;
+    }
+    if (type.contains("double") || type.contains("float")) {
+        return QMetaType::Double;
+    }
+    if (type == QLatin1String("bool")) {
+        return QMetaType::Bool;
+    }
+    if (type.contains("QString") || type.contains("string") || type.contains("char")) {
+        return QMetaType::QString;
+    }
+    if (type.contains("long long") || type.contains("qint64")) {
+        return QMetaType::LongLong;
+    }
+    return QMetaType::Int;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Script.hpp
+ * @brief Header file for the Script class evaluating guards, delays and state actions without compiling them.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <memory>
+
+struct ScriptNode;
+
+/**
+ * @brief Guard, delay or state action of an interpreted machine.
+ *
+ * Understands the subset of C++ the code of a machine is written in: literals, the machine variables and local
+ * declarations, arithmetic, comparison, logical, conditional and assignment operators, if/else, blocks, return
+ * and the helper API of the generated code (valueof, defined, called, output, elapsed, elapsedMicros, Qtoi, log,
+ * debug).
+ * The source is parsed once, running a script walks the parsed tree.
+ */
+class Script {
+   public:
+    /**
+     * @brief Kind of source a script is compiled from.
+     */
+    enum Mode {
+        Expression,  // Transition condition or delay
+        Statements   // State action
+    };
+
+    Script();
+    ~Script();
+    Script(Script &&other) noexcept;
+    Script &operator=(Script &&other) noexcept;
+
+    /**
+     * @brief Parse the source of a script.
+     *
+     * @param source Code of the guard, delay or state action.
+     * @param variables Names of the machine variables, resolved to their index in the values passed to run().
+     * @param mode Whether the source is an expression or a list of statements.
+     * @param error Set to a description of the problem if the source cannot be parsed.
+     * @return True if the script was compiled.
+     */
+    bool compile(const QString &source, const QStringList &variables, Mode mode, QString &error);
+
+    /**
+     * @brief Check whether a script was compiled.
+     *
+     * @return True if run() has something to evaluate.
+     */
+    bool isCompiled() const;
+
+    /**
+     * @brief Get the machine variables the script assigns or increments.
+     *
+     * @return Variable indices, each listed once.
+     */
+    const QVector<int> &writtenVariables() const;
+
+    /**
+     * @brief Run the script.
+     *
+     * Has to be called while the runtime dispatches the instance owning the variables, the helper API refers to
+     * that instance. Throws std::runtime_error on errors like a division by zero.
+     *
+     * @param variables Values of the machine variables, assignments store into them.
+     * @return Value of an expression, or the returned value of statements (invalid if nothing was returned).
+     */
+    QVariant run(QVector<QVariant> &variables) const;
+
+    /**
+     * @brief Convert a value to the truth value a C++ condition would give it.
+     *
+     * @param value Value of a condition.
+     * @return False for false, zero, empty strings and invalid values, true otherwise.
+     */
+    static bool truth(const QVariant &value);
+
+    /**
+     * @brief Convert a value to the type of a declared variable, as an assignment in C++ would.
+     *
+     * @param value Value to store.
+     * @param type QMetaType id of the variable, 0 keeps the value as it is.
+     * @return The converted value.
+     */
+    static QVariant coerce(const QVariant &value, int type);
+
+    /**
+     * @brief Map a C++ type name of a variable declaration to the type values are kept in.
+     *
+     * @param typeName Type as written in the declaration (int, double, bool, QString, ...).
+     * @return QMetaType id, 0 for auto.
+     */
+    static int typeOf(const QString &typeName);
+
+   private:
+    std::unique_ptr<ScriptNode> m_root;  // Parsed source, null until compiled
+    int m_localCount = 0;                // Local variables declared by the script
+    QVector<int> m_writes;               // Machine variables the script can write
+};
@@ -2,29 +2,370 @@
  * @file logger.cpp
  * @brief Implements the Logger class for logging with colored output.
  *
+ * The message handler only queues the messages, a writer thread formats them and writes them to the console and
+ * the JSON log, so loading a large automaton or receiving a fast event stream is not slowed down by the console.
+ *
  * @author Lukas Pseja (xpsejal00)
  * @date 03-04-2025
  */
 
 #include "logger.hpp"
 
-void Logger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message) {
-    QString formattedMessage;
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+Q_LOGGING_CATEGORY(lcXml, "fsm.xml")
+Q_LOGGING_CATEGORY(lcClient, "fsm.client")
+
+namespace {
+
+// Messages waiting for the writer thread at most, further ones are dropped rather than blocking the caller
+const size_t MAX_QUEUED_MESSAGES = 65536;
 
+// Debug and info messages a category may log per second unless Logger::setRateLimit() says otherwise
+const int DEFAULT_RATE_LIMIT = 200;
+
+// Length of a rate limiting window in milliseconds
+const qint64 RATE_WINDOW = 1000;
+
+/**
+ * @brief A message waiting for the writer thread.
+ */
+struct LogEntry {
+    qint64 time;          // Milliseconds since the epoch
+    QtMsgType type;       // Level of the message
+    QByteArray category;  // Logging category, "default" for qDebug() and the like
+    QString message;      // Text of the message
+};
+
+/**
+ * @brief Debug and info messages a category logged in the current window.
+ */
+struct RateWindow {
+    qint64 start = 0;  // Start of the window in milliseconds since the epoch
+    int count = 0;     // Messages logged in the window
+    int dropped = 0;   // Messages dropped in the window, not reported yet
+};
+
+/**
+ * @brief Rank the message types by severity, the values of QtMsgType are not in that order.
+ *
+ * @param type The type of the message.
+ * @return 0 for debug up to 4 for fatal messages.
+ */
+int severity(QtMsgType type) {
     switch (type) {
         case QtDebugMsg:
-            formattedMessage = QString("%1[Debug]%2 %3").arg(TerminalColors::BLU, TerminalColors::RES, message);
-            break;
+            return 0;
         case QtInfoMsg:
-            formattedMessage = QString("%1[Info]%2 %3").arg(TerminalColors::CYN, TerminalColors::RES, message);
-            break;
+            return 1;
         case QtWarningMsg:
-            formattedMessage = QString("%1[Warning]%2 %3").arg(TerminalColors::YEL, TerminalColors::RES, message);
-            break;
+            return 2;
         case QtCriticalMsg:
-            formattedMessage = QString("%1[Error]%2 %3").arg(TerminalColors::RED, TerminalColors::RES, message);
-            break;
+            return 3;
+        case QtFatalMsg:
+            return 4;
     }
+    return 0;
+}
 
-    fprintf(stdout, "%s\n", formattedMessage.toUtf8().constData());
+/**
+ * @brief Queue and writer thread of the log messages.
+ */
+class LogWriter {
+   public:
+    std::atomic<int> minimumSeverity{0};             // Severity of the least severe messages logged
+    std::atomic<int> rateLimit{DEFAULT_RATE_LIMIT};  // Debug and info messages per category and second, 0 for any
+
+    /**
+     * @brief Queue a message, starting the writer thread on the first one.
+     *
+     * @param type The type of the message.
+     * @param category Logging category, may be null.
+     * @param message Text of the message.
+     */
+    void post(QtMsgType type, const char *category, const QString &message) {
+        LogEntry entry{QDateTime::currentMSecsSinceEpoch(), type, QByteArray(category ? category : "default"),
+                       message};
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stopped) {
+            write(entry);
+            return;
+        }
+        if (!m_thread.joinable()) {
+            m_thread = std::thread([this]() { run(); });
+        }
+        if (severity(type) <= severity(QtInfoMsg) && !admit(entry)) {
+            return;
+        }
+        if (m_queue.size() >= MAX_QUEUED_MESSAGES) {
+            ++m_overflow;
+            return;
+        }
+        enqueue(std::move(entry));
+        lock.unlock();
+        m_wake.notify_one();
+    }
+
+    /**
+     * @brief Wait until the messages queued so far are written.
+     */
+    void flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            return;
+        }
+        const quint64 target = m_queued;
+        m_wake.notify_one();
+        m_idle.wait(lock, [this, target]() { return m_written >= target; });
+    }
+
+    /**
+     * @brief Write the queued messages and stop the writer thread.
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopped) {
+                return;
+            }
+            m_stopped = true;
+        }
+        m_wake.notify_one();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Start writing the messages to a JSON lines file as well.
+     *
+     * @param path File to append to.
+     * @return True if the file could be opened.
+     */
+    bool openJson(const QString &path) {
+        std::lock_guard<std::mutex> lock(m_sinkMutex);
+        m_json.close();
+        m_json.setFileName(path);
+        return m_json.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+   private:
+    /**
+     * @brief Apply the rate limit of the category of a message, called with m_mutex held.
+     *
+     * @param entry The message.
+     * @return True if the message may be logged.
+     */
+    bool admit(const LogEntry &entry) {
+        RateWindow &window = m_windows[entry.category];
+        if (entry.time - window.start >= RATE_WINDOW) {
+            reportDropped(entry.category, window);
+            window.start = entry.time;
+            window.count = 0;
+        }
+        const int limit = rateLimit.load(std::memory_order_relaxed);
+        if (limit > 0 && window.count >= limit) {
+            ++window.dropped;
+            return false;
+        }
+        ++window.count;
+        return true;
+    }
+
+    /**
+     * @brief Queue a warning about the messages a category had dropped, called with m_mutex held.
+     *
+     * @param category Logging category.
+     * @param window Rate limiting window of the category.
+     */
+    void reportDropped(const QByteArray &category, RateWindow &window) {
+        if (window.dropped == 0) {
+            return;
+        }
+        enqueue(LogEntry{QDateTime::currentMSecsSinceEpoch(), QtWarningMsg, category,
+                         QString("%1 debug and info messages dropped by the rate limit").arg(window.dropped)});
+        window.dropped = 0;
+    }
+
+    void enqueue(LogEntry &&entry) {
+        m_queue.push_back(std::move(entry));
+        ++m_queued;
+    }
+
+    void run() {
+        std::deque<LogEntry> batch;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            // The timeout reports the drops of categories that went quiet since
+            m_wake.wait_for(lock, std::chrono::milliseconds(RATE_WINDOW / 2),
+                            [this]() { return !m_queue.empty() || m_stopped; });
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            for (auto it = m_windows.begin(); it != m_windows.end(); ++it) {
+                if (now - it->start >= RATE_WINDOW) {
+                    reportDropped(it.key(), *it);
+                }
+            }
+            if (m_overflow > 0) {
+                enqueue(LogEntry{now, QtWarningMsg, "default",
+                                 QString("%1 messages dropped, the log queue was full").arg(m_overflow)});
+                m_overflow = 0;
+            }
+            batch.swap(m_queue);
+            const quint64 written = m_queued;
+            lock.unlock();
+
+            if (!batch.empty()) {
+                std::lock_guard<std::mutex> sink(m_sinkMutex);
+                for (const LogEntry &entry : batch) {
+                    writeEntry(entry);
+                }
+                fflush(stdout);
+                if (m_json.isOpen()) {
+                    m_json.flush();
+                }
+                batch.clear();
+            }
+
+            lock.lock();
+            m_written = written;
+            m_idle.notify_all();
+            if (m_stopped && m_queue.empty()) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Write a message right away, used once the writer thread stopped.
+     *
+     * @param entry The message.
+     */
+    void write(const LogEntry &entry) {
+        std::lock_guard<std::mutex> sink(m_sinkMutex);
+        writeEntry(entry);
+        fflush(stdout);
+        if (m_json.isOpen()) {
+            m_json.flush();
+        }
+    }
+
+    /**
+     * @brief Format a message to the console and the JSON log, called with m_sinkMutex held.
+     *
+     * @param entry The message.
+     */
+    void writeEntry(const LogEntry &entry) {
+        QString formattedMessage;
+        QString message = entry.message;
+        if (entry.category != "default") {
+            message = QString::fromLatin1(entry.category) + ": " + message;
+        }
+        const char *level = "debug";
+
+        switch (entry.type) {
+            case QtDebugMsg:
+                formattedMessage = QString("%1[Debug]%2 %3").arg(TerminalColors::BLU, TerminalColors::RES, message);
+                break;
+            case QtInfoMsg:
+                formattedMessage = QString("%1[Info]%2 %3").arg(TerminalColors::CYN, TerminalColors::RES, message);
+                level = "info";
+                break;
+            case QtWarningMsg:
+                formattedMessage = QString("%1[Warning]%2 %3").arg(TerminalColors::YEL, TerminalColors::RES, message);
+                level = "warning";
+                break;
+            case QtCriticalMsg:
+                formattedMessage = QString("%1[Error]%2 %3").arg(TerminalColors::RED, TerminalColors::RES, message);
+                level = "critical";
+                break;
+            case QtFatalMsg:
+                formattedMessage = QString("%1[Fatal]%2 %3").arg(TerminalColors::RED, TerminalColors::RES, message);
+                level = "fatal";
+                break;
+        }
+
+        fprintf(stdout, "%s\n", formattedMessage.toUtf8().constData());
+
+        if (m_json.isOpen()) {
+            QJsonObject record{
+                {"time", QDateTime::fromMSecsSinceEpoch(entry.time).toString(Qt::ISODateWithMs)},
+                {"level", level},
+                {"category", QString::fromLatin1(entry.category)},
+                {"message", entry.message},
+            };
+            m_json.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n');
+        }
+    }
+
+    std::mutex m_mutex;                       // Guards the queue, the counters and the rate windows
+    std::condition_variable m_wake;           // Wakes the writer thread
+    std::condition_variable m_idle;           // Signals written messages to flush()
+    std::deque<LogEntry> m_queue;             // Messages waiting for the writer thread
+    QHash<QByteArray, RateWindow> m_windows;  // Rate limiting window of every category
+    quint64 m_queued = 0;                     // Messages queued so far
+    quint64 m_written = 0;                    // Messages written so far
+    int m_overflow = 0;                       // Messages dropped on a full queue, not reported yet
+    bool m_stopped = false;                   // Whether messages are written directly
+    std::thread m_thread;                     // Writer thread, started by the first message
+
+    std::mutex m_sinkMutex;  // Guards the console and the JSON log
+    QFile m_json;            // JSON lines log, closed unless requested
+};
+
+/**
+ * @brief Get the writer of the process.
+ *
+ * It is never destroyed, so messages logged while the program exits still find it.
+ *
+ * @return The writer.
+ */
+LogWriter &writer() {
+    static LogWriter *instance = new LogWriter;
+    return *instance;
+}
+
+}  // namespace
+
+void Logger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message) {
+    LogWriter &log = writer();
+    if (severity(type) < log.minimumSeverity.load(std::memory_order_relaxed)) {
+        return;
+    }
+    log.post(type, context.category, message);
+    if (type == QtFatalMsg) {
+        // Qt aborts right after the handler returns
+        log.flush();
+    }
 }
+
+void Logger::setMinimumLevel(QtMsgType type) {
+    const int minimum = qMin(severity(type), severity(QtCriticalMsg));
+    writer().minimumSeverity.store(minimum, std::memory_order_relaxed);
+    QStringList rules;
+    const char *const levels[] = {"debug", "info", "warning"};
+    for (int i = 0; i < minimum; ++i) {
+        rules << QString("*.%1=false").arg(levels[i]);
+    }
+    QLoggingCategory::setFilterRules(rules.join('\n'));
+}
+
+void Logger::setRateLimit(int messagesPerSecond) {
+    writer().rateLimit.store(qMax(messagesPerSecond, 0), std::memory_order_relaxed);
+}
+
+bool Logger::openJsonLog(const QString &path) { return writer().openJson(path); }
+
+void Logger::flush() { writer().flush(); }
+
+void Logger::shutdown() { writer().stop(); }
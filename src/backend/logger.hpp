@@ -1,7 +1,7 @@
 /**
  * @file logger.hpp
  * @brief Defines the Logger class, the messageHandler method and TerminalColors namespace for logging with colored
- * output.
+ * output, and the logging categories of the chatty parts of the editor.
  *
  * @author Lukas Pseja (xpsejal00)
  * @date 03-04-2025
@@ -10,6 +10,13 @@
 #pragma once
 
 #include <QDebug>
+#include <QLoggingCategory>
+
+/** @brief Category of the XML import and export (fsm.xml), logs every element. */
+Q_DECLARE_LOGGING_CATEGORY(lcXml)
+
+/** @brief Category of the client of the running FSM (fsm.client), logs every received event. */
+Q_DECLARE_LOGGING_CATEGORY(lcClient)
 
 /**
  * @namespace TerminalColors
@@ -37,15 +44,53 @@ constexpr const char *RES = "\033[0m";
  * @class Logger
  *
  * @brief Handles logging with colored output for different log levels.
+ *
+ * Messages are queued and written by a background thread, so the thread logging them never waits for the
+ * console. Messages below the minimum level are dropped, debug and info messages of a category beyond its rate
+ * limit are dropped and counted. Besides the console, the messages can be written to a file as JSON lines.
  */
 class Logger {
    public:
     /**
-     * @brief Custom message handler for Qt logging.
+     * @brief Custom message handler for Qt logging, queues the message for the writer thread.
      *
      * @param type The type of the message.
      * @param context The context of the message.
      * @param message The actual log message to be formatted and displayed.
      */
     static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+    /**
+     * @brief Set the least severe messages that are still logged.
+     *
+     * Also disables the lower levels of the logging categories, so their messages are not even formatted.
+     *
+     * @param type Minimum level, in the order debug, info, warning, critical.
+     */
+    static void setMinimumLevel(QtMsgType type);
+
+    /**
+     * @brief Set how many debug and info messages a category may log per second, the rest is counted and dropped.
+     *
+     * @param messagesPerSecond Limit per category, 0 for no limit.
+     */
+    static void setRateLimit(int messagesPerSecond);
+
+    /**
+     * @brief Additionally write the messages to a file, one JSON object per line.
+     *
+     * @param path File to append to.
+     * @return True if the file could be opened.
+     */
+    static bool openJsonLog(const QString &path);
+
+    /**
+     * @brief Wait until the writer thread wrote every message queued so far.
+     */
+    static void flush();
+
+    /**
+     * @brief Write the queued messages and stop the writer thread, later messages are written directly.
+     */
+    static void shutdown();
 };
\ No newline at end of file
@@ -45,6 +45,7 @@
 #include <QDateTime>
 #include <QTcpSocket>
 #include <QHostAddress>
+#include <QCryptographicHash>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -59,6 +60,7 @@ MainWindow::MainWindow(QWidget *parent)
   //parts of the UI, instantiating, setting up
   fsm = new FSM("DefaultFSM");
   client = new GuiClient("127.0.0.1", 54323, this);
+  interpreter = new FsmInterpreter(this);
   automatView = new AutomatView(fsm, this);
   automatView->setMinimumSize(400, 300);
   automatView->setGeometry(710, 30, 1205, 960);
@@ -937,6 +939,8 @@ void MainWindow::runFSM() {
   ui->groupBox_3->setEnabled(false);
   ui->buttonClear->setEnabled(false);
   ui->buttonRun->setEnabled(false);
+  ui->checkInterpret->setEnabled(false);
+  ui->checkRelease->setEnabled(false);
   ui->buttonRefresh->setEnabled(false);
   ui->buttonStop->setEnabled(true);
   ui->buttonRun->setStyleSheet("");
@@ -977,63 +981,30 @@ void MainWindow::runFSM() {
     qDebug() << "[ERROR] Could not read FSM XML from temp file:" << xmlPath;
   }
 
-  //code generation part, using codegen class
-  CodeGenerator codeGen;
-  QString generatedCode = codeGen.generateCode(fsm);
-  QString genCpp = QDir::temp().filePath("fsm_generated_%1.cpp").arg(user);
-  QFile file(genCpp);
-  //writing to file
-  if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-    QTextStream out(&file);
-    out << generatedCode;
-    file.close();
-  } else {
-    ui->logConsole->appendPlainText("[ERROR] Code generation failed!");
-    qDebug() << "Failed to save generated code to file" << genCpp;
-    return;
-  }
+  // the editor talks to its own server over a local socket, tcp stays open for other clients
+  QString localName = QString("icp-fsm-%1").arg(QCoreApplication::applicationPid());
 
-  //compiling the generated code using g++
-  //using process because compiler is not our class
-  QString exe = QDir::temp().filePath(QString("fsm_run_%1").arg(user));
-
-  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-  env.insert("PKG_CONFIG_PATH", "/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/lib/pkgconfig");
-  QProcess pkgConfigProc;
-  pkgConfigProc.setProcessEnvironment(env);
-  pkgConfigProc.start("pkg-config", QStringList() << "--cflags" << "--libs" << "Qt5Core" << "Qt5Network"
-                                                    << "Qt5Widgets" << "Qt5Xml" << "Qt5Gui");
-  if (!pkgConfigProc.waitForFinished() || pkgConfigProc.exitCode() != 0) {
-    ui->logConsole->appendPlainText("[ERROR] pkg-config failed!");
-    qDebug() << "pkg-config failed:" << pkgConfigProc.readAllStandardError();
+  // interpreter mode runs the machine inside the editor, nothing is generated or compiled
+  if (ui->checkInterpret->isChecked()) {
+    QString error;
+    if (!interpreter->load(fsm, error) ||
+        !interpreter->start(client->getHost(), client->getPort(), localName, error)) {
+      ui->logConsole->appendPlainText("[ERROR] " + error);
+      return;
+    }
+    ui->logConsole->appendPlainText("[INFO] FSM interpreter started.");
+    QTimer::singleShot(0, this, [this, localName]() {
+      client->connectToLocalServer(localName);
+    });
+    stateChanged(fsm->getInitialState()->getName());
     return;
   }
-  QString pkgFlags = QString::fromLocal8Bit(pkgConfigProc.readAllStandardOutput()).trimmed();
-  QStringList flagList = pkgFlags.split(' ');
-  // filter out flags that are used for compiling
-  QStringList filteredFlags;
-  for (const QString &flag : flagList) {
-    if (flag.startsWith("-I/tmp/Qt5.9.2")) continue;
-    if (flag.startsWith("-L/tmp/Qt5.9.2")) continue;
-    filteredFlags << flag;
-    qDebug() << "Filtered flag:" << flag;
-  }
-  filteredFlags << "-I/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/include";
-  filteredFlags << "-L/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/lib";
-  filteredFlags << "-lQt5Core" << "-lQt5Network" << "-lQt5Widgets" << "-lQt5Xml" << "-lQt5Gui";
-
-  QStringList args = {genCpp, "-o", exe, "-fPIC", "-std=c++17"};
-  args.append(filteredFlags);
-
-  QString debugCmd = "g++ ";
-  for (const QString &arg : args) debugCmd += arg + " ";
-  qDebug() << "Compile command:" << debugCmd.trimmed();
 
-  QProcess compiling;
-  compiling.start("g++", args);
-  if (!compiling.waitForFinished() || compiling.exitCode() != 0) {
-    ui->logConsole->appendPlainText("[ERROR] Compilation failed!");
-    qDebug() << "Compilation failed SADGE:" << compiling.readAllStandardError();
+  //code generation part, using codegen class
+  CodeGenerator codeGen;
+  QString generatedCode = codeGen.generateCode(fsm);
+  QString exe = buildFSM(generatedCode);
+  if (exe.isEmpty()) {
     return;
   }
 
@@ -1046,7 +1017,8 @@ void MainWindow::runFSM() {
   }
   serverProcess = new QProcess(this);
   serverProcess->setProcessEnvironment(myenv);
-  serverProcess->start(exe, QStringList{"--port", QString::number(client->getPort()), "--host", client->getHost()});
+  serverProcess->start(exe, QStringList{"--port", QString::number(client->getPort()), "--host", client->getHost(),
+                                        "--local", localName});
   if (!serverProcess->waitForStarted()) {
     ui->logConsole->appendPlainText("[ERROR] Failed to start server process!");
     qDebug() << "Failed to start server process SADGE";
@@ -1054,11 +1026,174 @@ void MainWindow::runFSM() {
   }
   qDebug() << "Server is running RAAAAHHHH:" << serverProcess->processId();
   ui->logConsole->appendPlainText("[INFO] FSM server started.");
-  QTimer::singleShot(750, this, [this]() {
-    client->connectToServer();
+  QTimer::singleShot(750, this, [this, localName]() {
+    client->connectToLocalServer(localName);
   });
   stateChanged(fsm->getInitialState()->getName());
 }
+// returns the executable of the generated code, compiling it only when the cache has no build of it yet
+// the cache key covers the generated source, the compiler flags, the compiler version and the runtime library
+QString MainWindow::buildFSM(const QString &generatedCode) {
+  if (compilerId.isEmpty()) {
+    // pkg-config and the compiler version do not change while the editor runs, ask only once
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    env.insert("PKG_CONFIG_PATH", "/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/lib/pkgconfig");
+    QProcess pkgConfigProc;
+    pkgConfigProc.setProcessEnvironment(env);
+    pkgConfigProc.start("pkg-config", QStringList() << "--cflags" << "--libs" << "Qt5Core" << "Qt5Network"
+                                                      << "Qt5Widgets" << "Qt5Xml" << "Qt5Gui");
+    if (!pkgConfigProc.waitForFinished() || pkgConfigProc.exitCode() != 0) {
+      ui->logConsole->appendPlainText("[ERROR] pkg-config failed!");
+      qDebug() << "pkg-config failed:" << pkgConfigProc.readAllStandardError();
+      return QString();
+    }
+    QString pkgFlags = QString::fromLocal8Bit(pkgConfigProc.readAllStandardOutput()).trimmed();
+    QStringList flagList = pkgFlags.split(' ');
+    // filter out flags that are used for compiling
+    QStringList filteredFlags;
+    for (const QString &flag : flagList) {
+      if (flag.startsWith("-I/tmp/Qt5.9.2")) continue;
+      if (flag.startsWith("-L/tmp/Qt5.9.2")) continue;
+      filteredFlags << flag;
+      qDebug() << "Filtered flag:" << flag;
+    }
+    filteredFlags << "-I/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/include";
+    filteredFlags << "-L/usr/local/share/Qt-5.9.2/5.9.2/gcc_64/lib";
+    filteredFlags << "-lQt5Core" << "-lQt5Network" << "-lQt5Widgets" << "-lQt5Xml" << "-lQt5Gui";
+
+    QProcess version;
+    version.start("g++", QStringList{"--version"});
+    if (!version.waitForFinished() || version.exitCode() != 0) {
+      ui->logConsole->appendPlainText("[ERROR] Compiler not found!");
+      return QString();
+    }
+    // the generated code only describes the machine, the engine comes from the prebuilt runtime library
+    // which has to be linked before the qt libraries it depends on
+    QString runtimeLib = FSM_RUNTIME_LIBRARY;
+    if (!QFile::exists(runtimeLib)) {
+      ui->logConsole->appendPlainText("[ERROR] FSM runtime library not found!");
+      qDebug() << "Missing runtime library:" << runtimeLib;
+      return QString();
+    }
+    // -rdynamic exports the runtime to machine modules the program loads with /reload
+    compileFlags = QStringList{"-fPIC", "-rdynamic", "-std=c++17", "-I" + QString(FSM_RUNTIME_INCLUDE_DIR),
+                               runtimeLib, "-ldl", "-pthread"} +
+                   filteredFlags;
+    qtFlags = filteredFlags;
+    compilerId = QString::fromLocal8Bit(version.readAllStandardOutput()).section('\n', 0, 0);
+    // a rebuilt runtime invalidates the cached programs linked against the old one
+    QCryptographicHash runtimeHash(QCryptographicHash::Sha1);
+    QDir runtimeDir(FSM_RUNTIME_INCLUDE_DIR);
+    QStringList runtimeFiles = {runtimeLib, FSM_RUNTIME_RELEASE_LIBRARY};
+    for (const QString &header : runtimeDir.entryList(QStringList{"*.hpp"}, QDir::Files, QDir::Name)) {
+      runtimeFiles << runtimeDir.filePath(header);
+    }
+    for (const QString &path : runtimeFiles) {
+      QFile part(path);
+      if (part.open(QIODevice::ReadOnly)) runtimeHash.addData(&part);
+    }
+    compilerId += " runtime " + QString::fromLatin1(runtimeHash.result().toHex());
+    // the runtime header pulls in the qt headers, they are parsed once into a precompiled header
+    QString pchDir = buildPrecompiledHeader(filteredFlags, "pch");
+    if (!pchDir.isEmpty()) {
+      // searched before the runtime directory, so g++ takes the .gch for #include "FsmRuntime.hpp"
+      compileFlags.prepend("-I" + pchDir);
+    }
+  }
+  // the release profile compiles the debug messages and the decorative output out of the program
+  // it needs the runtime built with the same macro, set up on its first use
+  bool release = ui->checkRelease->isChecked();
+  if (release && releaseCompileFlags.isEmpty()) {
+    QString releaseLib = FSM_RUNTIME_RELEASE_LIBRARY;
+    if (!QFile::exists(releaseLib)) {
+      ui->logConsole->appendPlainText("[ERROR] FSM release runtime library not found!");
+      qDebug() << "Missing release runtime library:" << releaseLib;
+      return QString();
+    }
+    releaseCompileFlags = QStringList{"-DFSM_RELEASE", "-O2", "-fPIC", "-rdynamic", "-std=c++17",
+                                      "-I" + QString(FSM_RUNTIME_INCLUDE_DIR), releaseLib, "-ldl", "-pthread"} +
+                          qtFlags;
+    QString pchDir = buildPrecompiledHeader(releaseCompileFlags, "pch-release");
+    if (!pchDir.isEmpty()) {
+      releaseCompileFlags.prepend("-I" + pchDir);
+    }
+  }
+  const QStringList &flags = release ? releaseCompileFlags : compileFlags;
+
+  QByteArray source = generatedCode.toUtf8();
+  QString key = CompileCache::key(source, flags, compilerId);
+  QString exe = compileCache.lookup(key);
+  if (!exe.isEmpty()) {
+    qDebug() << "Reusing cached build:" << exe;
+    ui->logConsole->appendPlainText("[INFO] FSM unchanged, reusing the previous build.");
+    return exe;
+  }
+
+  //writing to file
+  QDir().mkpath(compileCache.directory());
+  QString genCpp = compileCache.sourcePath(key);
+  QFile file(genCpp);
+  if (!file.open(QIODevice::WriteOnly)) {
+    ui->logConsole->appendPlainText("[ERROR] Code generation failed!");
+    qDebug() << "Failed to save generated code to file" << genCpp;
+    return QString();
+  }
+  file.write(source);
+  file.close();
+
+  //compiling the generated code using g++
+  //using process because compiler is not our class
+  QString built = compileCache.buildPath(key);
+  QStringList args = {genCpp, "-o", built};
+  args.append(flags);
+
+  QString debugCmd = "g++ ";
+  for (const QString &arg : args) debugCmd += arg + " ";
+  qDebug() << "Compile command:" << debugCmd.trimmed();
+
+  QProcess compiling;
+  compiling.start("g++", args);
+  if (!compiling.waitForFinished() || compiling.exitCode() != 0) {
+    ui->logConsole->appendPlainText("[ERROR] Compilation failed!");
+    qDebug() << "Compilation failed SADGE:" << compiling.readAllStandardError();
+    QFile::remove(built);
+    return QString();
+  }
+  return compileCache.store(key, built);
+}
+// precompiles the runtime header into the compile cache directory, again only when the compiler or the runtime
+// changed, returns the directory holding the .gch or an empty string if it could not be built
+QString MainWindow::buildPrecompiledHeader(const QStringList &flags, const QString &name) {
+  // a .gch is only used with the same language options, macros and optimization, the include paths may differ
+  QStringList pchFlags = {"-x", "c++-header", "-fPIC", "-std=c++17", "-pthread"};
+  for (const QString &flag : flags) {
+    if (flag.startsWith("-I") || flag.startsWith("-D") || flag.startsWith("-O")) pchFlags << flag;
+  }
+  QString pchDir = QDir(compileCache.directory()).filePath(name);
+  QString gch = QDir(pchDir).filePath("FsmRuntime.hpp.gch");
+  QByteArray stamp = QCryptographicHash::hash((compilerId + pchFlags.join(' ')).toUtf8(),
+                                              QCryptographicHash::Sha1).toHex();
+  QFile stampFile(gch + ".key");
+  if (QFile::exists(gch) && stampFile.open(QIODevice::ReadOnly) && stampFile.readAll() == stamp) {
+    return pchDir;
+  }
+  stampFile.close();
+
+  QDir().mkpath(pchDir);
+  QProcess pch;
+  pch.start("g++", pchFlags + QStringList{QDir(FSM_RUNTIME_INCLUDE_DIR).filePath("FsmRuntime.hpp"), "-o", gch});
+  if (!pch.waitForFinished() || pch.exitCode() != 0) {
+    // not fatal, the generated code is then compiled against the plain header
+    qDebug() << "Precompiled header failed:" << pch.readAllStandardError();
+    QFile::remove(gch);
+    return QString();
+  }
+  if (stampFile.open(QIODevice::WriteOnly)) {
+    stampFile.write(stamp);
+    stampFile.close();
+  }
+  return pchDir;
+}
 // function to stop the FSM
 // it differs between terminating the process and sending shutdown command
 // both client and owner handling
@@ -1071,6 +1206,9 @@ void MainWindow::stopFSM() {
     delete serverProcess;
     serverProcess = nullptr;
     ui->logConsole->appendPlainText("[INFO] FSM server stopped.");
+  } else if (interpreter->isRunning()) {
+    interpreter->stop();
+    ui->logConsole->appendPlainText("[INFO] FSM interpreter stopped.");
   } else {
     if (client && client->isConnected()) {
       qDebug() << "[DEBUG] Sending shutdown command to remote FSM server.";
@@ -1093,6 +1231,8 @@ void MainWindow::stopFSM() {
   ui->groupBox_3->setEnabled(true);
   ui->buttonClear->setEnabled(true);
   ui->buttonRun->setEnabled(true);
+  ui->checkInterpret->setEnabled(true);
+  ui->checkRelease->setEnabled(true);
   ui->buttonRefresh->setEnabled(true);
   ui->buttonStop->setEnabled(false);
   ui->buttonRun->setStyleSheet("background-color: green; color: white;");
@@ -1245,6 +1385,8 @@ void MainWindow::connectToFSM() {
   ui->groupBox_3->setEnabled(false);
   ui->buttonClear->setEnabled(false);
   ui->buttonRun->setEnabled(false);
+  ui->checkInterpret->setEnabled(false);
+  ui->checkRelease->setEnabled(false);
   ui->buttonRefresh->setEnabled(false);
   ui->buttonStop->setEnabled(true);
   ui->buttonRun->setStyleSheet("");
@@ -1276,8 +1418,6 @@ void MainWindow::cleanupTempFiles() {
   if (user.isEmpty()) user = "unknown";
     QStringList files = {
     QDir::temp().filePath(QString("fsm_run_%1.xml").arg(user)),
-    QDir::temp().filePath(QString("fsm_generated_%1.cpp").arg(user)),
-    QDir::temp().filePath(QString("fsm_run_%1").arg(user)),
     QDir::temp().filePath(QString("fsm_refresh_%1.xml").arg(user)),
     QDir::temp().filePath(QString("req_fsm_%1.xml").arg(user))
   };
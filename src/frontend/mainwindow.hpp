@@ -21,6 +21,8 @@
 #include <QVBoxLayout>
 #include "AutomatView.hpp"
 #include "StateItem.hpp"
+#include "backend/CompileCache.hpp"
+#include "backend/FsmInterpreter.hpp"
 #include "backend/GuiClient.hpp"
 #include "backend/fsm.hpp"
 
@@ -327,6 +329,49 @@ class MainWindow : public QMainWindow {
      */
     void cleanupTempFiles();
 
+    /**
+     * @brief Returns the executable of the generated code, compiling it on a compile cache miss.
+     *
+     * @param generatedCode The generated C++ source.
+     * @return Path of the executable, or an empty string if the build failed.
+     */
+    QString buildFSM(const QString &generatedCode);
+
+    /**
+     * @brief Precompiles the header of the FSM runtime, reusing an up to date build.
+     *
+     * @param flags Compiler flags of the build profile, the include paths, macros and optimization level are passed
+     * to the compiler.
+     * @param name Directory of the profile in the compile cache, as profiles need their own header.
+     * @return Directory holding FsmRuntime.hpp.gch, or an empty string if it could not be built.
+     */
+    QString buildPrecompiledHeader(const QStringList &flags, const QString &name);
+
+    /**
+     * @brief Compiled FSM programs of earlier runs.
+     */
+    CompileCache compileCache;
+
+    /**
+     * @brief Compiler flags from pkg-config, filled on the first run.
+     */
+    QStringList compileFlags;
+
+    /**
+     * @brief Qt flags from pkg-config, filled on the first run.
+     */
+    QStringList qtFlags;
+
+    /**
+     * @brief Compiler flags of the release profile, filled on the first release build.
+     */
+    QStringList releaseCompileFlags;
+
+    /**
+     * @brief Version of the compiler, filled on the first run.
+     */
+    QString compilerId;
+
     /**
      * @brief List of transitions connected to the currently selected state.
      */
@@ -347,6 +392,11 @@ class MainWindow : public QMainWindow {
      */
     QProcess *serverProcess = nullptr;
 
+    /**
+     * @brief Runs the FSM inside the editor when compilation is skipped.
+     */
+    FsmInterpreter *interpreter;
+
     /**
      * @brief Map of input names to their values.
      */
@@ -376,7 +426,7 @@ Accessing variables
 - Custom variables: Use them by name (e.g., counter = 0;).
 - Inputs: Use valueof("inputName") to get the value as a QString.
 - Check if input is set: defined("inputName") returns true if the input has a value.
-- Check if input was called as an event: called("inputName") returns true if triggered (and resets the flag).
+- Check if input was called as an event: called("inputName") returns true in the transitions of that input and in the first eventless step after them.
 
 Note: Values are handled as QStrings. Use the provided helper function for conversions:
 - Use `Qtoi(qstring)` to convert a QString to int.
@@ -399,6 +449,8 @@ Limitations
 - All variables are global; avoid name conflicts.
 - No advanced C++ features (e.g., custom includes, classes).
 - Code runs synchronously; avoid long-running operations.
+- With "Interpret (skip compilation)" checked the code is not compiled, only a subset of C++ is understood:
+  variables, local declarations, operators, if/else, blocks, return and the helper functions above.
 
 Example snippets
 ----------------
@@ -1,16 +1,42 @@
 #include <QApplication>
+#include <QCommandLineParser>
 
 #include "backend/GuiClient.hpp"
 #include "backend/logger.hpp"
 #include "frontend/mainwindow.hpp"
 
 int main(int argc, char* argv[]) {
+    qInstallMessageHandler(Logger::messageHandler);
     QApplication app(argc, argv);
     qRegisterMetaType<FsmStatus>("FsmStatus");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption levelOption("log-level", "Least severe messages logged: debug, info, warning or critical.",
+                                   "level", "debug");
+    QCommandLineOption fileOption("log-file", "Also write the log to <file> as JSON lines.", "file");
+    QCommandLineOption rateOption("log-rate", "Debug and info messages a category may log per second, 0 for any.",
+                                  "count", "200");
+    parser.addOptions({levelOption, fileOption, rateOption});
+    parser.process(app);
+
+    const QString level = parser.value(levelOption);
+    if (level == "critical") {
+        Logger::setMinimumLevel(QtCriticalMsg);
+    } else if (level == "warning") {
+        Logger::setMinimumLevel(QtWarningMsg);
+    } else if (level == "info") {
+        Logger::setMinimumLevel(QtInfoMsg);
+    }
+    Logger::setRateLimit(parser.value(rateOption).toInt());
+    if (parser.isSet(fileOption) && !Logger::openJsonLog(parser.value(fileOption))) {
+        qWarning() << "Could not open the log file" << parser.value(fileOption);
+    }
+
     MainWindow w;
     w.show();
 
-    qInstallMessageHandler(Logger::messageHandler);
-
-    return app.exec();
+    int result = app.exec();
+    Logger::shutdown();
+    return result;
 }
@@ -0,0 +1,984 @@
+/**
+ * @file DispatchEngine.cpp
+ * @brief Hosted machine instances, the table-driven dispatch engine and the helper API of the machine code.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "DispatchEngine.hpp"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QEvent>
+#include <QtCore/QHash>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "WireProtocol.hpp"
+
+const MachineDefinition* machine = nullptr;
+int instanceCount = 1;
+thread_local MachineInstance* activeInstance = nullptr;
+DispatchEngine engine;
+
+// Name lookups of the hosted machine, built by useMachine()
+static QHash<QString, int> inputsByName;
+static QHash<QByteArray, int> inputsByRawName;
+static QHash<QString, int> outputsByName;
+
+void useMachine(const MachineDefinition& definition) {
+    machine = &definition;
+    inputsByName.clear();
+    inputsByRawName.clear();
+    outputsByName.clear();
+    for (int i = 0; i < definition.inputCount; ++i) {
+        inputsByName.insert(QString::fromUtf8(definition.inputNames[i]), i);
+        inputsByRawName.insert(QByteArray(definition.inputNames[i]), i);
+    }
+    for (int i = 0; i < definition.outputCount; ++i) {
+        outputsByName.insert(QString::fromUtf8(definition.outputNames[i]), i);
+    }
+    prepareEventTemplates();
+}
+
+MachineInstance::MachineInstance(int id)
+    : instanceId(id),
+      context(machine->createContext()),
+      inputValues(machine->inputCount),
+      outputValues(machine->outputCount),
+      timerArmed(machine->transitionCount, false),
+      timerDelay(machine->transitionCount, 0),
+      timerGeneration(machine->transitionCount, 0) {}
+
+int inputIndex(const QString& name) { return inputsByName.value(name, NO_EVENT); }
+
+int inputIndex(const XmlSlice& name) {
+    if (name.isEscaped()) {
+        return inputIndex(name.toString());
+    }
+    return inputsByRawName.value(name.toRawData(), NO_EVENT);
+}
+
+int outputIndex(const QString& name) { return outputsByName.value(name, NO_OUTPUT); }
+
+QString currentStateName(const MachineInstance& instance) {
+    return instance.currentState < 0 ? QStringLiteral("UNKNOWN")
+                                     : QString::fromUtf8(machine->stateNames[instance.currentState]);
+}
+
+QString valueof(int input) { return activeInstance->inputValues.at(input); }
+
+QString valueof(const QString& input) {
+    int index = inputIndex(input);
+    return index == NO_EVENT ? QString() : activeInstance->inputValues.at(index);
+}
+
+int Qtoi(const QString& str) {
+    bool ok = false;
+    int value = str.toInt(&ok);
+    return ok ? value : 0;
+}
+
+bool defined(int input) { return !activeInstance->inputValues.at(input).isEmpty(); }
+
+bool defined(const QString& input) {
+    int index = inputIndex(input);
+    return index != NO_EVENT && !activeInstance->inputValues.at(index).isEmpty();
+}
+
+void output(int port, const QVariant& value) {
+    QString valueStr = value.toString();
+    const QString portName = QString::fromUtf8(machine->outputNames[port]);
+    debugLazy("output('%1', %2)", portName, valueStr);
+    activeInstance->outputValues[port] = valueStr;
+    logOutputEvent(portName, valueStr);
+    broadcastEvent(WireEvent{FRAME_OUTPUT, activeInstance->instanceId, port, 0, 0, valueStr});
+}
+
+void output(const QString& port, const QVariant& value) {
+    int index = outputIndex(port);
+    if (index == NO_OUTPUT) {
+        log(COLOR_WARNING + "output(): unknown output '" + port + "'" + ANSI_RESET);
+        return;
+    }
+    output(index, value);
+}
+
+int elapsed() {
+    const int diff = static_cast<int>(elapsedMicros() / 1000);
+    debugLazy("elapsed(): %1 ms", diff);
+    return diff;
+}
+
+qint64 elapsedMicros() {
+    if (activeInstance->currentState < 0) {
+        return 0;
+    }
+    return monotonicMicros() - activeInstance->stateEntryTime;
+}
+
+qint64 monotonicMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief Reads the monotonic clock in the milliseconds the timers are armed with.
+ * @return Milliseconds since an arbitrary fixed point.
+ */
+static qint64 monotonicMillis() { return monotonicMicros() / 1000; }
+
+bool called(int input) { return input == activeInstance->dispatchedInput; }
+
+bool called(const QString& input) {
+    const int dispatchedInput = activeInstance->dispatchedInput;
+    bool result = dispatchedInput != NO_EVENT && inputIndex(input) == dispatchedInput;
+    debugLazy("called('%1') returning %2", input, result ? "true" : "false");
+    return result;
+}
+
+/**
+ * @brief Unit of work queued to the shard owning an instance.
+ */
+struct ShardTask {
+    std::atomic<ShardTask*> next{nullptr};
+    MachineInstance* instance = nullptr;
+    int input = NO_EVENT;  // Input to dispatch
+    bool store = false;    // Store value as the new input value before dispatching
+    QString value;
+    std::function<void(MachineInstance&)> job;  // Runs instead of a dispatch when set
+};
+
+/**
+ * @brief Lock-free multi-producer single-consumer queue of shard tasks (Vyukov's intrusive queue).
+ *
+ * Any thread may push, only the shard owning the queue pops. Tasks of one producer are popped in the order they
+ * were pushed, which keeps the inputs of an instance in order.
+ */
+class TaskQueue {
+   public:
+    TaskQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+    ~TaskQueue() {
+        while (ShardTask* task = pop()) {
+            delete task;
+        }
+    }
+
+    void push(ShardTask* task) {
+        task->next.store(nullptr, std::memory_order_relaxed);
+        ShardTask* prev = m_head.exchange(task, std::memory_order_acq_rel);
+        prev->next.store(task, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pops the oldest task.
+     * @return The task, or nullptr if the queue is empty or a producer is still linking its task in.
+     */
+    ShardTask* pop() {
+        ShardTask* tail = m_tail;
+        ShardTask* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub) {
+            if (!next) {
+                return nullptr;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            m_tail = next;
+            return tail;
+        }
+        if (tail != m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            m_tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+   private:
+    std::atomic<ShardTask*> m_head;  // Last pushed task, producers swap themselves in here
+    ShardTask* m_tail;               // Next task to pop, owned by the consumer
+    ShardTask m_stub;                // Placeholder keeping the list non-empty
+};
+
+// Upper bound of immediate eventless transitions taken in a row before giving up
+constexpr int MAX_EVENTLESS_STEPS = 1000;
+
+/**
+ * @brief Min-heap scheduler owning the timers of the delayed transitions of a shard's instances.
+ *
+ * A single QTimer is kept pointed at the earliest deadline. Arming pushes a heap entry stamped with the generation
+ * of the transition; cancelling only bumps the generation, so it is O(1) and the stale entry is dropped when it
+ * reaches the top of the heap.
+ */
+class TimerScheduler {
+   public:
+    /**
+     * @brief Arms the timer of a transition.
+     * @param instance Instance owning the transition.
+     * @param t Transition index.
+     * @param delay Delay in milliseconds.
+     * @param now Current time in milliseconds.
+     */
+    void arm(MachineInstance& instance, int t, int delay, qint64 now) {
+        instance.timerArmed[t] = true;
+        instance.timerDelay[t] = delay;
+        m_heap.push_back({now + delay, &instance, t, ++instance.timerGeneration[t]});
+        std::push_heap(m_heap.begin(), m_heap.end(), later);
+        ++m_live;
+        compact();
+    }
+
+    /**
+     * @brief Cancels the timer of a transition.
+     * @param instance Instance owning the transition.
+     * @param t Transition index.
+     * @return True if the timer was armed.
+     */
+    bool cancel(MachineInstance& instance, int t) {
+        if (!instance.timerArmed[t]) {
+            return false;
+        }
+        instance.timerArmed[t] = false;
+        ++instance.timerGeneration[t];
+        --m_live;
+        return true;
+    }
+
+    /**
+     * @brief Takes the next timer whose deadline has passed.
+     * @param now Current time in milliseconds.
+     * @param t Set to the transition index of the expired timer.
+     * @return Instance owning the expired timer, or nullptr if no armed timer is due.
+     */
+    MachineInstance* takeExpired(qint64 now, int& t) {
+        dropStale();
+        if (m_heap.empty() || m_heap.front().deadline > now) {
+            return nullptr;
+        }
+        MachineInstance* instance = m_heap.front().instance;
+        t = m_heap.front().transition;
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        m_heap.pop_back();
+        instance->timerArmed[t] = false;
+        --m_live;
+        return instance;
+    }
+
+    /**
+     * @brief Points the armed timers at the transitions of a reloaded machine, keeping their deadlines.
+     *
+     * Called while the shard is paused and before its instances are migrated, so stale entries are still told
+     * apart by the timer arrays of the previous machine.
+     *
+     * @param transitionMap New index of every previous transition, -1 if it is gone or no longer delayed.
+     */
+    void remap(const std::vector<int>& transitionMap) {
+        std::vector<Entry> kept;
+        for (const Entry& entry : m_heap) {
+            if (!stale(entry) && transitionMap[entry.transition] >= 0) {
+                // Migrated timers start over at generation 1, see migrateInstance()
+                kept.push_back({entry.deadline, entry.instance, transitionMap[entry.transition], 1});
+            }
+        }
+        m_heap.swap(kept);
+        std::make_heap(m_heap.begin(), m_heap.end(), later);
+        m_live = static_cast<int>(m_heap.size());
+    }
+
+    /**
+     * @brief Gets the time until the earliest armed deadline.
+     * @param now Current time in milliseconds.
+     * @return Milliseconds to wait, or -1 if nothing is armed.
+     */
+    int nextTimeout(qint64 now) {
+        dropStale();
+        if (m_heap.empty()) {
+            return -1;
+        }
+        return static_cast<int>(qMax<qint64>(0, m_heap.front().deadline - now));
+    }
+
+   private:
+    struct Entry {
+        qint64 deadline;
+        MachineInstance* instance;
+        int transition;
+        quint32 generation;
+    };
+
+    static bool later(const Entry& a, const Entry& b) { return a.deadline > b.deadline; }
+
+    static bool stale(const Entry& entry) {
+        return !entry.instance->timerArmed[entry.transition] ||
+               entry.generation != entry.instance->timerGeneration[entry.transition];
+    }
+
+    void dropStale() {
+        while (!m_heap.empty() && stale(m_heap.front())) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            m_heap.pop_back();
+        }
+    }
+
+    // Rebuilds the heap once cancelled entries outnumber the armed ones
+    void compact() {
+        if (m_heap.size() < 64 || m_heap.size() < 2 * static_cast<size_t>(m_live)) {
+            return;
+        }
+        m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), stale), m_heap.end());
+        std::make_heap(m_heap.begin(), m_heap.end(), later);
+    }
+
+    std::vector<Entry> m_heap;  // Pending deadlines, earliest on top
+    int m_live = 0;             // Number of armed timers
+};
+
+/**
+ * @brief Executor running the transition table for a subset of the hosted instances.
+ *
+ * Each shard drains its own task queue and owns the timers of its instances, so instances of different shards run
+ * in parallel while the inputs of one instance are handled in order. An input is routed straight to the bucket of
+ * the current state of its instance that listens to it, so only guards subscribed to that input are evaluated; the
+ * bucket of eventless transitions is re-evaluated after every step until the instance settles.
+ */
+class Shard : public QObject {
+   public:
+    /**
+     * @brief Queues a task and wakes the shard if it is idle. Safe to call from any thread.
+     * @param task Task to run, the shard takes ownership.
+     */
+    void post(ShardTask* task) {
+        m_queue.push(task);
+        if (!m_wakeupPending.exchange(true, std::memory_order_acq_rel)) {
+            QCoreApplication::postEvent(this, new QEvent(DrainEventType));
+        }
+    }
+
+    /**
+     * @brief Enters the initial state of an instance and evaluates its eventless transitions.
+     * @param instance Instance to start.
+     * @param initialState Initial state index.
+     */
+    void startInstance(MachineInstance& instance, int initialState) {
+        enterState(instance, initialState);
+        runEventless(instance);
+    }
+
+    /**
+     * @brief Applies the operations of a batch command to an instance.
+     *
+     * Atomic batches store every value first and then dispatch each input of the batch once, in order of first
+     * appearance, so guards see the complete update. Otherwise every item is stored and dispatched in turn, like
+     * separate set/call commands.
+     *
+     * @param instance Instance receiving the inputs.
+     * @param items Operations in order.
+     * @param atomic Whether to dispatch once after storing all values.
+     */
+    void applyBatch(MachineInstance& instance, const std::vector<BatchItem>& items, bool atomic) {
+        if (!atomic) {
+            for (const BatchItem& item : items) {
+                if (item.store) {
+                    storeInput(instance, item.input, item.value);
+                }
+                dispatchInput(instance, item.input);
+            }
+            return;
+        }
+        for (const BatchItem& item : items) {
+            if (item.store) {
+                storeInput(instance, item.input, item.value);
+            }
+        }
+        QVector<bool> dispatched(machine->inputCount, false);
+        for (const BatchItem& item : items) {
+            if (!dispatched[item.input]) {
+                dispatched[item.input] = true;
+                dispatchInput(instance, item.input);
+            }
+        }
+    }
+
+    /**
+     * @brief Runs the queued tasks. Only called on the thread of the shard.
+     */
+    void drain() {
+        // Cleared before draining, a task pushed meanwhile posts a new wakeup. An exchange rather than a store: both
+        // read-modify-writes of the flag are ordered, so post() either sees it cleared or its task is popped here
+        m_wakeupPending.exchange(false, std::memory_order_acq_rel);
+        while (ShardTask* task = m_queue.pop()) {
+            run(*task);
+            delete task;
+        }
+        flushMainThreadCalls();
+    }
+
+    /**
+     * @brief Points the armed timers at the transitions of a reloaded machine.
+     * @param transitionMap New index of every previous transition, -1 if the timer has to be dropped.
+     */
+    void remapTimers(const std::vector<int>& transitionMap) { m_scheduler.remap(transitionMap); }
+
+   protected:
+    void customEvent(QEvent* event) override {
+        if (event->type() == DrainEventType) {
+            drain();
+        }
+    }
+
+   private:
+    static const QEvent::Type DrainEventType = static_cast<QEvent::Type>(QEvent::User + 2);
+
+    void run(ShardTask& task) {
+        MachineInstance& instance = *task.instance;
+        activeInstance = &instance;
+        if (task.job) {
+            task.job(instance);
+        } else {
+            if (task.store) {
+                storeInput(instance, task.input, task.value);
+            }
+            dispatchInput(instance, task.input);
+        }
+        activeInstance = nullptr;
+    }
+
+    void storeInput(MachineInstance& instance, int input, const QString& value) {
+        if (instance.inputValues[input] == value) {
+            return;
+        }
+        instance.inputValues[input] = value;
+        broadcastEvent(WireEvent{FRAME_INPUT, instance.instanceId, input, 0, 0, value});
+    }
+
+    void dispatchInput(MachineInstance& instance, int input) {
+        if (instance.currentState < 0 || input == NO_EVENT) {
+            return;
+        }
+        // called() reports the dispatched input to its bucket and to the first eventless step only, so a cycle of
+        // eventless transitions guarded by called() takes one step per input instead of spinning until the limit
+        instance.dispatchedInput = input;
+        const int bucket = instance.currentState * (machine->inputCount + 1) + input;
+        const int end = machine->eventBuckets[bucket + 1];
+        for (int t = machine->eventBuckets[bucket]; t < end; ++t) {
+            if (tryTransition(instance, t)) {
+                break;
+            }
+        }
+        const bool fired = stepEventless(instance);
+        instance.dispatchedInput = NO_EVENT;
+        if (fired) {
+            runEventless(instance);
+        }
+    }
+
+    /**
+     * @brief Takes the first eventless transition of the current state whose guard holds.
+     * @param instance Instance to step.
+     * @return True if a transition was taken.
+     */
+    bool stepEventless(MachineInstance& instance) {
+        const int bucket = instance.currentState * (machine->inputCount + 1) + machine->inputCount;
+        const int end = machine->eventBuckets[bucket + 1];
+        for (int t = machine->eventBuckets[bucket]; t < end; ++t) {
+            if (tryTransition(instance, t)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runEventless(MachineInstance& instance) {
+        for (int step = 0; step < MAX_EVENTLESS_STEPS; ++step) {
+            if (!stepEventless(instance)) {
+                return;
+            }
+        }
+        log(COLOR_WARNING + "Eventless transitions of state " + currentStateName(instance) +
+            " did not settle, check for an unconditional loop" + ANSI_RESET);
+    }
+
+    /**
+     * @brief Evaluates a transition, taking it or arming its timer.
+     * @param instance Instance evaluating the transition.
+     * @param t Transition index.
+     * @return True if the transition was taken.
+     */
+    bool tryTransition(MachineInstance& instance, int t) {
+        const TransitionEntry& entry = machine->transitions[t];
+        if (instance.timerArmed[t]) {
+            debugLazy("Timer already armed for transition %1 → %2", machine->stateNames[entry.from],
+                      machine->stateNames[entry.to]);
+            return false;
+        }
+        if (entry.guarded && !evaluateGuard(instance, t)) {
+            return false;
+        }
+        const int delay = entry.delayed ? instance.context->delay(t) : 0;
+        if (delay > 0) {
+            armTimer(instance, t, delay);
+            return false;
+        }
+        fire(instance, t);
+        return true;
+    }
+
+    bool evaluateGuard(MachineInstance& instance, int t) {
+        try {
+            bool result = instance.context->guard(t);
+            const TransitionEntry& entry = machine->transitions[t];
+            debugLazy("Evaluating transition %1 → %2: %3", machine->stateNames[entry.from],
+                      machine->stateNames[entry.to], result ? "true" : "false");
+            reportVariables(instance);
+            return result;
+        } catch (const std::exception& e) {
+            log("Error evaluating transition condition: " + QString::fromStdString(e.what()));
+        } catch (...) {
+            log("Unknown error evaluating transition condition");
+        }
+        reportVariables(instance);
+        return false;
+    }
+
+    void fire(MachineInstance& instance, int t) {
+        const TransitionEntry& entry = machine->transitions[t];
+        m_scheduler.cancel(instance, t);
+        debugLazy("Taking transition %1 → %2", machine->stateNames[entry.from], machine->stateNames[entry.to]);
+        if (entry.to != instance.currentState) {
+            cancelTimers(instance);
+        }
+        enterState(instance, entry.to);
+    }
+
+    void enterState(MachineInstance& instance, int state) {
+        if (state != instance.currentState) {
+            instance.stateEntryTime = monotonicMicros();
+        }
+        instance.currentState = state;
+        if constexpr (LOG_DECORATIONS) {
+            log(DOUBLE_SEPARATOR);
+            if (instanceCount > 1) {
+                logLazy("%1%2%3%4%5 ENTERED%6 [instance %7]%5", STATE_HEADER, ANSI_BOLD, COLOR_STATE,
+                        machine->stateNames[state], ANSI_RESET, COLOR_NOTICE, instance.instanceId);
+            } else {
+                logLazy("%1%2%3%4%5 ENTERED", STATE_HEADER, ANSI_BOLD, COLOR_STATE, machine->stateNames[state],
+                        ANSI_RESET);
+            }
+            log(SECTION_SEPARATOR);
+        } else if (instanceCount > 1) {
+            logLazy("State %1 entered [instance %2]", machine->stateNames[state], instance.instanceId);
+        } else {
+            logLazy("State %1 entered", machine->stateNames[state]);
+        }
+        broadcastEvent(WireEvent{FRAME_STATE_CHANGE, instance.instanceId, state, 0, 0, QString()});
+        if (machine->stateActions[state]) {
+            if constexpr (LOG_DECORATIONS) {
+                logLazy("Executing onEntry action for state: %1%2%3", ANSI_BOLD, machine->stateNames[state],
+                        ANSI_RESET);
+            }
+            instance.context->onEntry(state);
+            reportVariables(instance);
+        }
+        if constexpr (LOG_DECORATIONS) {
+            log(SECTION_SEPARATOR);
+            log(" ");
+        }
+    }
+
+    /**
+     * @brief Broadcasts the variables a guard or state action changed.
+     * @param instance Instance that ran the guard or action.
+     */
+    void reportVariables(MachineInstance& instance) {
+        std::vector<int>& changed = instance.context->changedVariables();
+        for (int v : changed) {
+            const QString value = instance.context->variable(v).toString();
+            debugLazy("Variable changed: %1 = %2", machine->variableNames[v], value);
+            broadcastEvent(WireEvent{FRAME_VARIABLE, instance.instanceId, v, 0, 0, value});
+        }
+        changed.clear();
+    }
+
+    void armTimer(MachineInstance& instance, int t, int delay) {
+        const TransitionEntry& entry = machine->transitions[t];
+        m_scheduler.arm(instance, t, delay, monotonicMillis());
+        instance.armedInState.append(t);
+        if constexpr (LOG_DECORATIONS) {
+            logTimer(false, instance, entry, delay);
+        } else {
+            logLazy("Timeout started for transition %1 → %2 (delay: %3 ms)", machine->stateNames[entry.from],
+                    machine->stateNames[entry.to], delay);
+        }
+        broadcastEvent(WireEvent{FRAME_TIMER_START, instance.instanceId, entry.from, entry.to, delay, QString()});
+        rescheduleTimer();
+    }
+
+    /**
+     * @brief Points the timer of the shard at the earliest armed deadline.
+     */
+    void rescheduleTimer() {
+        const int timeout = m_scheduler.nextTimeout(monotonicMillis());
+        if (timeout < 0) {
+            if (m_timer) {
+                m_timer->stop();
+            }
+            return;
+        }
+        if (!m_timer) {
+            m_timer = new QTimer(this);
+            m_timer->setSingleShot(true);
+            m_timer->setTimerType(Qt::PreciseTimer);
+            QObject::connect(m_timer, &QTimer::timeout, this, [this]() { onTimerExpired(); });
+        }
+        m_timer->start(timeout);
+    }
+
+    void onTimerExpired() {
+        int t = -1;
+        while (MachineInstance* instance = m_scheduler.takeExpired(monotonicMillis(), t)) {
+            const TransitionEntry& entry = machine->transitions[t];
+            if (entry.from != instance->currentState) {
+                continue;
+            }
+            activeInstance = instance;
+            instance->armedInState.removeOne(t);
+            if constexpr (LOG_DECORATIONS) {
+                logTimer(true, *instance, entry, instance->timerDelay[t]);
+            } else {
+                logLazy("Timeout expired for transition %1 → %2 (delay: %3 ms)", machine->stateNames[entry.from],
+                        machine->stateNames[entry.to], instance->timerDelay[t]);
+            }
+            broadcastEvent(WireEvent{FRAME_TIMER_EXPIRED, instance->instanceId, entry.from, entry.to, 0, QString()});
+            fire(*instance, t);
+            runEventless(*instance);
+            activeInstance = nullptr;
+        }
+        rescheduleTimer();
+        flushMainThreadCalls();
+    }
+
+    /**
+     * @brief Cancels the armed timers of the state an instance is leaving.
+     *
+     * Only the active state can have armed timers, they are tracked in a short list so leaving a state does not
+     * scan its transitions.
+     */
+    void cancelTimers(MachineInstance& instance) {
+        for (int t : instance.armedInState) {
+            if (m_scheduler.cancel(instance, t)) {
+                debugLazy("Stopped timer for transition %1 → %2", machine->stateNames[machine->transitions[t].from],
+                          machine->stateNames[machine->transitions[t].to]);
+            }
+        }
+        instance.armedInState.clear();
+    }
+
+    /**
+     * @brief Logs the decorated line of a started or expired timer, formatted on the log thread.
+     * @param expired Whether the timer expired rather than started.
+     * @param instance Instance owning the timer.
+     * @param entry Transition of the timer.
+     * @param delay Delay of the timer in milliseconds.
+     */
+    void logTimer(bool expired, const MachineInstance& instance, const TransitionEntry& entry, int delay) {
+        // The decorations are built once and passed as shared copies, only the names and numbers vary
+        static const QString started = TIMEOUT_STARTED + ANSI_BOLD + "▶ Timeout started";
+        static const QString expiredTitle = TIMEOUT_EXPIRED + ANSI_BOLD + "▶ Timeout expired";
+        const QString& title = expired ? expiredTitle : started;
+        static const QString source = ANSI_RESET + " for transition " + COLOR_SOURCE;
+        static const QString arrow = ANSI_RESET + COLOR_TRANSITION + " → " + COLOR_TARGET;
+        if (instanceCount > 1) {
+            logLazy("%1%2%3%4%5%6 (delay: %7 ms)%6%8 [instance %9]%6", title, source, machine->stateNames[entry.from],
+                    arrow, machine->stateNames[entry.to], ANSI_RESET, delay, COLOR_NOTICE, instance.instanceId);
+        } else {
+            logLazy("%1%2%3%4%5%6 (delay: %7 ms)%6", title, source, machine->stateNames[entry.from], arrow,
+                    machine->stateNames[entry.to], ANSI_RESET, delay);
+        }
+    }
+
+    TaskQueue m_queue;                         // Tasks posted to this shard
+    std::atomic<bool> m_wakeupPending{false};  // Whether a drain event is already queued
+    TimerScheduler m_scheduler;                // Deadlines of the delayed transitions of the shard
+    QTimer* m_timer = nullptr;                 // Single timer firing at the earliest deadline, created lazily
+};
+
+/**
+ * @brief Gets the key matching a transition across reloads: its source, target and input names.
+ * @param definition Machine the transition belongs to.
+ * @param t Transition index.
+ * @return The key.
+ */
+static QByteArray transitionKey(const MachineDefinition& definition, int t) {
+    const TransitionEntry& entry = definition.transitions[t];
+    return QByteArray(definition.stateNames[entry.from]) + '\n' + definition.stateNames[entry.to] + '\n' +
+           (entry.event == NO_EVENT ? "" : definition.inputNames[entry.event]);
+}
+
+/**
+ * @brief Carries the values of inputs or outputs over to the names of the reloaded machine.
+ * @param values Values indexed by the previous machine.
+ * @param names Names of the previous machine.
+ * @param count Number of names of the current machine.
+ * @param indexOf Resolves a name to its index in the current machine, negative if the name is gone.
+ * @return Values indexed by the current machine.
+ */
+static QVector<QString> carryValues(const QVector<QString>& values, const char* const* names, int count,
+                                    int (*indexOf)(const QString&)) {
+    QVector<QString> carried(count);
+    for (int i = 0; i < values.size(); ++i) {
+        const int index = indexOf(QString::fromUtf8(names[i]));
+        if (index >= 0) {
+            carried[index] = values[i];
+        }
+    }
+    return carried;
+}
+
+/**
+ * @brief Moves an instance from the previous machine to the current one.
+ *
+ * The state and the armed timers are mapped by name, inputs, outputs and variables carried over by name; names
+ * the current machine added start out empty or with their initial value.
+ *
+ * @param instance Instance to migrate, its shard is paused.
+ * @param previous The machine that is replaced.
+ * @param stateMap Current index of every previous state.
+ * @param transitionMap Current index of every previous transition, -1 if its timer is dropped.
+ * @param variableMap Current index of every previous variable, -1 if it is gone.
+ */
+static void migrateInstance(MachineInstance& instance, const MachineDefinition& previous,
+                            const std::vector<int>& stateMap, const std::vector<int>& transitionMap,
+                            const std::vector<int>& variableMap) {
+    if (instance.currentState >= 0) {
+        instance.currentState = stateMap[instance.currentState];
+    }
+    instance.inputValues = carryValues(instance.inputValues, previous.inputNames, machine->inputCount, inputIndex);
+    instance.outputValues =
+        carryValues(instance.outputValues, previous.outputNames, machine->outputCount, outputIndex);
+
+    // Changes are reported right after the guard or action making them, the carried values are all reported
+    std::unique_ptr<MachineContext> context(machine->createContext());
+    for (int v = 0; v < previous.variableCount; ++v) {
+        if (variableMap[v] >= 0) {
+            context->setVariable(variableMap[v], instance.context->variable(v));
+        }
+    }
+    // The previous context is deleted here, before the module holding its code is unloaded
+    instance.context = std::move(context);
+
+    QVector<bool> timerArmed(machine->transitionCount, false);
+    QVector<int> timerDelay(machine->transitionCount, 0);
+    QVector<quint32> timerGeneration(machine->transitionCount, 0);
+    QVector<int> armedInState;
+    for (int t = 0; t < previous.transitionCount; ++t) {
+        const int next = transitionMap[t];
+        if (instance.timerArmed[t] && next >= 0) {
+            timerArmed[next] = true;
+            timerDelay[next] = instance.timerDelay[t];
+            timerGeneration[next] = 1;
+            armedInState.append(next);
+        }
+    }
+    instance.timerArmed = timerArmed;
+    instance.timerDelay = timerDelay;
+    instance.timerGeneration = timerGeneration;
+    instance.armedInState = armedInState;
+    instance.dispatchedInput = NO_EVENT;
+}
+
+DispatchEngine::~DispatchEngine() { stop(); }
+
+void DispatchEngine::createInstances(int count) {
+    for (int i = 0; i < count; ++i) {
+        m_instances.emplace_back(new MachineInstance(static_cast<int>(m_instances.size())));
+    }
+}
+
+void DispatchEngine::createShards(int threads) {
+    const int count = qMax(1, threads);
+    for (int i = 0; i < count; ++i) {
+        Shard* shard = new Shard;
+        if (threads > 0) {
+            QThread* thread = new QThread;
+            shard->moveToThread(thread);
+            // The shard and its timer belong to the worker thread, so they are deleted there once it finishes
+            QObject::connect(thread, &QThread::finished, shard, &QObject::deleteLater);
+            thread->start();
+            m_threads.push_back(thread);
+        }
+        m_shards.push_back(shard);
+    }
+}
+
+void DispatchEngine::stop() {
+    if (m_threads.empty()) {
+        for (Shard* shard : m_shards) {
+            delete shard;
+        }
+    }
+    // Worker threads delete their shards when they finish, wait() returns after that
+    for (QThread* thread : m_threads) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+    m_shards.clear();
+    m_instances.clear();
+}
+
+MachineInstance* DispatchEngine::instance(int id) {
+    return id >= 0 && id < static_cast<int>(m_instances.size()) ? m_instances[id].get() : nullptr;
+}
+
+void DispatchEngine::start(int initialState) {
+    if (initialState < 0 || initialState >= machine->stateCount) {
+        log(COLOR_ERROR + "No initial state defined, the machine cannot be started" + ANSI_RESET);
+        return;
+    }
+    for (const std::unique_ptr<MachineInstance>& instance : m_instances) {
+        Shard* shard = shardOf(*instance);
+        runOn(instance->instanceId,
+              [shard, initialState](MachineInstance& target) { shard->startInstance(target, initialState); });
+    }
+}
+
+void DispatchEngine::setInput(int instance, int input, const QString& value) { post(instance, input, true, value); }
+
+void DispatchEngine::callInput(int instance, int input) { post(instance, input, false, QString()); }
+
+void DispatchEngine::applyBatch(int instance, std::vector<BatchItem> items, bool atomic) {
+    MachineInstance* owner = this->instance(instance);
+    if (!owner || items.empty()) {
+        return;
+    }
+    Shard* shard = shardOf(*owner);
+    runOn(instance, [shard, items = std::move(items), atomic](MachineInstance& target) {
+        shard->applyBatch(target, items, atomic);
+    });
+}
+
+void DispatchEngine::runOn(int instance, std::function<void(MachineInstance&)> job) {
+    MachineInstance* target = this->instance(instance);
+    if (!target) {
+        return;
+    }
+    ShardTask* task = new ShardTask;
+    task->instance = target;
+    task->job = std::move(job);
+    shardOf(*target)->post(task);
+}
+
+void DispatchEngine::post(int instance, int input, bool store, const QString& value) {
+    MachineInstance* target = this->instance(instance);
+    if (!target || input == NO_EVENT) {
+        return;
+    }
+    ShardTask* task = new ShardTask;
+    task->instance = target;
+    task->input = input;
+    task->store = store;
+    task->value = value;
+    shardOf(*target)->post(task);
+}
+
+bool DispatchEngine::reload(const MachineDefinition& next, const QString& source, QString& error) {
+    const MachineDefinition& previous = *machine;
+
+    QHash<QByteArray, int> nextStates;
+    for (int s = 0; s < next.stateCount; ++s) {
+        nextStates.insert(QByteArray(next.stateNames[s]), s);
+    }
+    std::vector<int> stateMap(previous.stateCount);
+    for (int s = 0; s < previous.stateCount; ++s) {
+        auto it = nextStates.constFind(QByteArray(previous.stateNames[s]));
+        if (it == nextStates.constEnd()) {
+            error = QString("state '%1' is missing in the new machine").arg(previous.stateNames[s]);
+            return false;
+        }
+        stateMap[s] = it.value();
+    }
+
+    // Transitions sharing source, target and input are matched in table order
+    QHash<QByteArray, QVector<int>> nextTransitions;
+    for (int t = 0; t < next.transitionCount; ++t) {
+        nextTransitions[transitionKey(next, t)].append(t);
+    }
+    QHash<QByteArray, int> matched;
+    std::vector<int> transitionMap(previous.transitionCount, -1);
+    for (int t = 0; t < previous.transitionCount; ++t) {
+        const QByteArray key = transitionKey(previous, t);
+        const int nth = matched[key]++;
+        const QVector<int> candidates = nextTransitions.value(key);
+        if (nth < candidates.size() && next.transitions[candidates[nth]].delayed) {
+            transitionMap[t] = candidates[nth];
+        }
+    }
+
+    std::vector<int> variableMap(previous.variableCount, -1);
+    for (int v = 0; v < previous.variableCount; ++v) {
+        for (int n = 0; n < next.variableCount; ++n) {
+            if (qstrcmp(previous.variableNames[v], next.variableNames[n]) == 0) {
+                variableMap[v] = n;
+            }
+        }
+    }
+
+    // Every shard finishes its queued tasks and waits, so nothing runs on the previous tables during the swap
+    auto arrived = std::make_shared<QSemaphore>();
+    auto released = std::make_shared<QSemaphore>();
+    int paused = 0;
+    for (Shard* shard : m_shards) {
+        if (m_threads.empty()) {
+            shard->drain();
+            continue;
+        }
+        auto owned = std::find_if(m_instances.begin(), m_instances.end(),
+                                  [this, shard](const std::unique_ptr<MachineInstance>& instance) {
+                                      return shardOf(*instance) == shard;
+                                  });
+        if (owned == m_instances.end()) {
+            continue;
+        }
+        ShardTask* task = new ShardTask;
+        task->instance = owned->get();
+        task->job = [arrived, released](MachineInstance&) {
+            flushMainThreadCalls();
+            arrived->release();
+            released->acquire();
+        };
+        shard->post(task);
+        ++paused;
+    }
+    arrived->acquire(paused);
+    // Events of the previous machine are sent while its names are still in place
+    runMainThreadCalls();
+    flushConflatedEvents();
+
+    useMachine(next);
+    for (Shard* shard : m_shards) {
+        shard->remapTimers(transitionMap);
+    }
+    for (const std::unique_ptr<MachineInstance>& instance : m_instances) {
+        migrateInstance(*instance, previous, stateMap, transitionMap, variableMap);
+    }
+    released->release(paused);
+    announceMachineReload(previous, source);
+    return true;
+}
+
+Shard* DispatchEngine::shardOf(const MachineInstance& instance) const {
+    return m_shards[instance.instanceId % m_shards.size()];
+}
@@ -0,0 +1,213 @@
+/**
+ * @file DispatchEngine.hpp
+ * @brief Hosted machine instances and the table-driven dispatch engine executing them.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+#include <QtCore/QVector>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "FsmRuntime.hpp"
+#include "XmlMessageReader.hpp"
+
+class QThread;
+class Shard;
+
+constexpr int NO_EVENT = -1;   // No input, for eventless transitions and outside of a dispatch
+constexpr int NO_OUTPUT = -1;  // Unknown output name
+
+/**
+ * @brief Machine hosted by the process, set by useMachine().
+ */
+extern const MachineDefinition *machine;
+
+/**
+ * @brief Number of hosted machine instances (--instances).
+ */
+extern int instanceCount;
+
+/**
+ * @brief Make a machine the one hosted by the process.
+ *
+ * Builds the name lookups and the pre-serialized event pieces of the machine, so it has to be called before the
+ * instances are created and the clients are served.
+ *
+ * @param definition The machine, has to outlive its instances.
+ */
+void useMachine(const MachineDefinition &definition);
+
+/**
+ * @brief State of one hosted copy of the machine.
+ *
+ * One process can host many independent instances of the machine. The custom variables and the code of the
+ * machine live in the context, the runtime keeps the inputs, outputs, timers and the current state.
+ */
+struct MachineInstance {
+    /**
+     * @brief Create an instance of the hosted machine, sized by its definition.
+     * @param id Index of the instance.
+     */
+    explicit MachineInstance(int id);
+
+    int instanceId = 0;                       // Index of the instance, selected by the protocol "instance" attribute
+    int currentState = -1;                    // Active state, -1 until the machine is started
+    qint64 stateEntryTime = 0;                // Time the active state was entered (monotonicMicros())
+    int dispatchedInput = NO_EVENT;           // Input being dispatched, reported by called()
+    std::unique_ptr<MachineContext> context;  // Custom variables, guards, delays and state actions
+    QVector<QString> inputValues;             // Last known value of every input
+    QVector<QString> outputValues;            // Last sent value of every output
+    QVector<bool> timerArmed;                 // Whether the timer of a transition is running
+    QVector<int> timerDelay;                  // Delay the timer of a transition was armed with
+    QVector<quint32> timerGeneration;         // Bumped on every arm/cancel of a transition
+    QVector<int> armedInState;                // Transitions of the active state whose timer is armed
+};
+
+/**
+ * @brief Instance whose guards and actions are running on the calling thread.
+ */
+extern thread_local MachineInstance *activeInstance;
+
+/**
+ * @brief Resolves an input name to its dense index.
+ * @param name Input name.
+ * @return Index of the input, or NO_EVENT if the input does not exist.
+ */
+int inputIndex(const QString &name);
+
+/**
+ * @brief Resolves an input name taken from a protocol message to its dense index.
+ * @param name Raw input name from XmlMessage.
+ * @return Index of the input, or NO_EVENT if the input does not exist.
+ */
+int inputIndex(const XmlSlice &name);
+
+/**
+ * @brief Resolves an output name to its dense index.
+ * @param name Output name.
+ * @return Index of the output, or NO_OUTPUT if the output does not exist.
+ */
+int outputIndex(const QString &name);
+
+/**
+ * @brief Gets the name of the active state of an instance.
+ * @param instance Machine instance.
+ * @return Name of the current state, or "UNKNOWN" before the machine is started.
+ */
+QString currentStateName(const MachineInstance &instance);
+
+/**
+ * @brief One operation of a batch command.
+ */
+struct BatchItem {
+    int input;      // Input index
+    bool store;     // set (store value, then dispatch) or call (dispatch with the last value)
+    QString value;  // New value of a set operation
+};
+
+/**
+ * @brief Front end owning the hosted instances and the shards executing them.
+ *
+ * Instance i belongs to shard i % shard count. Without worker threads a single shard runs on the main event loop;
+ * with --threads N every shard gets its own thread. A shard evaluates the transitions, runs the state actions and
+ * schedules the timers of the delayed transitions of its instances on a single min-heap.
+ */
+class DispatchEngine {
+   public:
+    ~DispatchEngine();
+
+    /**
+     * @brief Creates the hosted machine instances.
+     * @param count Number of instances, numbered from 0.
+     */
+    void createInstances(int count);
+
+    /**
+     * @brief Creates the shards executing the instances.
+     * @param threads Number of worker threads, 0 runs everything on the main event loop.
+     */
+    void createShards(int threads);
+
+    /**
+     * @brief Stops the worker threads and deletes the shards and the instances.
+     */
+    void stop();
+
+    /**
+     * @brief Gets a hosted instance.
+     * @param id Instance index.
+     * @return The instance, or nullptr if no instance has that index.
+     */
+    MachineInstance *instance(int id);
+
+    /**
+     * @brief Enters the initial state in every instance and evaluates its eventless transitions.
+     * @param initialState Initial state index.
+     */
+    void start(int initialState);
+
+    /**
+     * @brief Stores a new input value and dispatches the input on the owning shard.
+     * @param instance Instance (instanceId) receiving the input.
+     * @param input Input index.
+     * @param value New value of the input.
+     */
+    void setInput(int instance, int input, const QString &value);
+
+    /**
+     * @brief Dispatches an input with its last value on the owning shard.
+     * @param instance Instance (instanceId) receiving the input.
+     * @param input Input index.
+     */
+    void callInput(int instance, int input);
+
+    /**
+     * @brief Applies a batch of set/call operations as one task on the owning shard.
+     * @param instance Instance (instanceId) receiving the inputs.
+     * @param items Operations in order.
+     * @param atomic Store all values before a single dispatch pass, or dispatch item by item.
+     */
+    void applyBatch(int instance, std::vector<BatchItem> items, bool atomic);
+
+    /**
+     * @brief Swaps the logic of the running machine for a reloaded one.
+     *
+     * The shards are paused between tasks while the instances move over: the current state, armed timers (with
+     * their deadlines), inputs, outputs and variables are mapped by name. Only machines that kept every state of
+     * the running one are accepted. Has to be called on the main thread.
+     *
+     * @param next The new machine, has to outlive its instances.
+     * @param source Where the machine was loaded from, told to the clients.
+     * @param error Set to the reason if the machine is rejected.
+     * @return True if the new machine runs.
+     */
+    bool reload(const MachineDefinition &next, const QString &source, QString &error);
+
+    /**
+     * @brief Runs a job on the shard owning an instance, in order with the inputs of that instance.
+     * @param instance Instance (instanceId) the job works on.
+     * @param job Job to run.
+     */
+    void runOn(int instance, std::function<void(MachineInstance &)> job);
+
+   private:
+    void post(int instance, int input, bool store, const QString &value);
+
+    Shard *shardOf(const MachineInstance &instance) const;
+
+    std::vector<std::unique_ptr<MachineInstance>> m_instances;  // Hosted machine instances
+    std::vector<Shard *> m_shards;                              // Executors, one per worker thread
+    std::vector<QThread *> m_threads;                           // Worker threads, empty without --threads
+};
+
+/**
+ * @brief Global dispatch engine instance.
+ */
+extern DispatchEngine engine;
@@ -0,0 +1,487 @@
+/**
+ * @file FsmRuntime.cpp
+ * @brief Entry point of the FSM runtime library: command line, terminal interface and startup of a machine.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "FsmRuntime.hpp"
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSocketNotifier>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "DispatchEngine.hpp"
+#include "ProtocolServer.hpp"
+#include "WireProtocol.hpp"
+
+// Machine module swapped in by the last /reload, null while the program runs its built-in logic
+static void* machineModule = nullptr;
+
+/**
+ * @brief Swap the logic of the running machine for the one of a machine module.
+ *
+ * The module is loaded from a private copy, so a module rebuilt at the same path is loaded again instead of the
+ * dynamic loader handing out the already loaded one. The previous module is unloaded once nothing refers to it.
+ *
+ * @param path Shared object built from generated code with -DFSM_MODULE.
+ * @param error Set to the reason if the module cannot be used.
+ * @return True if the module's machine runs.
+ */
+static bool reloadMachine(const QString& path, QString& error) {
+    static int reloadCount = 0;
+    const QString copy = QDir::temp().filePath(
+        QString("fsm-module-%1-%2.so").arg(QCoreApplication::applicationPid()).arg(++reloadCount));
+    QFile::remove(copy);
+    if (!QFile::copy(path, copy)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    void* module = dlopen(QFile::encodeName(copy).constData(), RTLD_NOW | RTLD_LOCAL);
+    // The mapping stays valid without the file
+    QFile::remove(copy);
+    if (!module) {
+        error = QString::fromLocal8Bit(dlerror());
+        return false;
+    }
+    MachineModuleEntry entry = reinterpret_cast<MachineModuleEntry>(dlsym(module, FSM_MODULE_ENTRY_NAME));
+    const MachineDefinition* next = entry ? entry() : nullptr;
+    if (!next) {
+        error = path + " is not a machine module";
+        dlclose(module);
+        return false;
+    }
+    if (!engine.reload(*next, path, error)) {
+        dlclose(module);
+        return false;
+    }
+    if (machineModule) {
+        dlclose(machineModule);
+    }
+    machineModule = module;
+    return true;
+}
+
+int runMachine(int argc, char* argv[], const MachineDefinition& definition) {
+    QCoreApplication app(argc, argv);
+
+    // --host, --port, --local, --shm, --shm-size, --instances, --threads, --flush-latency, --client-queue-limit,
+    // --slow-client, --conflate, --binary-log and --decode-log arguments
+    QString hostStr = "127.0.0.1";
+    quint16 port = 54323;
+    QString localName;                  // Local socket name, empty for TCP only
+    QString shmKey;                     // Shared-memory event stream key, empty for none
+    quint32 shmSize = 4 * 1024 * 1024;  // Bytes of the shared-memory ring
+    int threadCount = 0;                // Worker threads executing the instances, 0 uses the main event loop
+    for (int i = 1; i < argc; ++i) {
+        QString arg = argv[i];
+        if (arg == "--host" && i + 1 < argc) {
+            hostStr = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            bool ok = false;
+            int p = QString(argv[++i]).toInt(&ok);
+            if (ok && p > 1024 && p < 65536) {
+                port = static_cast<quint16>(p);
+            }
+        } else if (arg == "--local" && i + 1 < argc) {
+            localName = argv[++i];
+        } else if (arg == "--shm" && i + 1 < argc) {
+            shmKey = argv[++i];
+        } else if (arg == "--shm-size" && i + 1 < argc) {
+            bool ok = false;
+            qint64 bytes = QString(argv[++i]).toLongLong(&ok);
+            if (ok && bytes >= 65536) {
+                shmSize = static_cast<quint32>(qMin<qint64>(bytes, 1024 * 1024 * 1024));
+            }
+        } else if (arg == "--instances" && i + 1 < argc) {
+            bool ok = false;
+            int n = QString(argv[++i]).toInt(&ok);
+            if (ok && n > 0) {
+                instanceCount = n;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            bool ok = false;
+            int n = QString(argv[++i]).toInt(&ok);
+            if (ok && n >= 0) {
+                threadCount = qMin(n, QThread::idealThreadCount() * 4);
+            }
+        } else if (arg == "--flush-latency" && i + 1 < argc) {
+            bool ok = false;
+            int ms = QString(argv[++i]).toInt(&ok);
+            if (ok && ms >= 0) {
+                flushLatencyMs = qMin(ms, 1000);
+            }
+        } else if (arg == "--client-queue-limit" && i + 1 < argc) {
+            bool ok = false;
+            qint64 bytes = QString(argv[++i]).toLongLong(&ok);
+            if (ok && bytes >= 4096) {
+                clientQueueLimit = bytes;
+            }
+        } else if (arg == "--conflate" && i + 1 < argc) {
+            bool ok = false;
+            int ms = QString(argv[++i]).toInt(&ok);
+            if (ok && ms >= 0) {
+                conflationWindowMs = qMin(ms, 1000);
+            }
+        } else if (arg == "--slow-client" && i + 1 < argc) {
+            QString policy = argv[++i];
+            if (policy == "drop") {
+                slowClientPolicy = POLICY_DROP_OLDEST;
+            } else if (policy == "coalesce") {
+                slowClientPolicy = POLICY_COALESCE;
+            } else if (policy == "disconnect") {
+                slowClientPolicy = POLICY_DISCONNECT;
+            } else {
+                log("Unknown slow client policy '" + policy + "', using coalesce");
+            }
+        } else if (arg == "--binary-log" && i + 1 < argc) {
+            QString path = argv[++i];
+            if (!openBinaryLog(path)) {
+                log("Could not create binary log '" + path + "'");
+            }
+        } else if (arg == "--decode-log" && i + 1 < argc) {
+            QString path = argv[++i];
+            bool ok = printBinaryLog(path);
+            flushLog();
+            if (!ok) {
+                std::fprintf(stderr, "Cannot read binary log '%s'\n", qPrintable(path));
+            }
+            return ok ? 0 : 1;
+        }
+    }
+    QHostAddress hostAddr;
+    if (!hostAddr.setAddress(hostStr)) {
+        log("Invalid host address specified, defaulting to 127.0.0.1");
+        hostAddr = QHostAddress::LocalHost;
+    }
+    useMachine(definition);
+    if (!shmKey.isEmpty() && openSharedRing(shmKey, shmSize)) {
+        log("Publishing events to shared memory '" + shmKey + "' (ring of " + QString::number(shmSize) + " bytes)");
+        updateWantedEvents();
+    }
+
+    // The banner is printed directly, after the messages logged while parsing the arguments
+    flushLog();
+    if constexpr (LOG_DECORATIONS) {
+        qDebug().noquote() << "\n" + DOUBLE_SEPARATOR;
+        qDebug().noquote() << ANSI_BOLD + COLOR_HEADER + "✧ ✧ ✧  OBLIVION STATE MACHINE  ✧ ✧ ✧" + ANSI_RESET;
+        qDebug().noquote() << COLOR_TRANSITION + "     we looove finite state machines (｡◕‿‿◕｡)" + ANSI_RESET;
+        qDebug().noquote() << DOUBLE_SEPARATOR + "\n";
+    }
+
+    debugLazy("Starting FSM application with the table-driven dispatch engine");
+    debugLazy("State machine name: %1%2%3%4", ANSI_BOLD, COLOR_STATE, machine->name, ANSI_RESET);
+
+    std::signal(SIGINT, [](int) {
+        if constexpr (LOG_DECORATIONS) {
+            log(DOUBLE_SEPARATOR);
+        }
+        log(ANSI_BOLD + COLOR_WARNING + "SIGINT (Ctrl+C) recieved. Exiting application." + ANSI_RESET);
+        if constexpr (LOG_DECORATIONS) {
+            log(DOUBLE_SEPARATOR);
+        }
+        broadcastShutdownEvent("Server is shutting down due to SIGINT (Ctrl+C). All clients will be disconnected.");
+        closeAndCleanupAllSockets();
+        QCoreApplication::quit();
+    });
+
+    engine.createInstances(instanceCount);
+    engine.createShards(threadCount);
+    if (instanceCount > 1 || threadCount > 0) {
+        log(QString("Hosting %1 instance(s) of the machine on %2 worker thread(s)").arg(instanceCount).arg(threadCount));
+    }
+    int terminalInstance = 0;  // Instance addressed by terminal commands, changed with /instance
+
+    QSet<QString> validInputNames;
+    for (int i = 0; i < machine->inputCount; ++i) {
+        validInputNames.insert(QString::fromUtf8(machine->inputNames[i]));
+    }
+
+    const QStringList helpLines = {
+        "• " + ANSI_BOLD + QString("input_name=value").leftJustified(26) + ANSI_RESET + "- Set an input value",
+        "• " + ANSI_BOLD + QString("input_name").leftJustified(26) + ANSI_RESET + "- Call an input",
+        "• " + ANSI_BOLD + QString("/status").leftJustified(26) + ANSI_RESET + "- Show the current system state",
+        "• " + ANSI_BOLD + QString("/instance <id>").leftJustified(26) + ANSI_RESET + "- Address another instance",
+        "• " + ANSI_BOLD + QString("/reload <module.so>").leftJustified(26) + ANSI_RESET +
+            "- Swap in the logic of a machine module",
+        "• " + ANSI_BOLD + QString("/help").leftJustified(26) + ANSI_RESET + "- Show this help message",
+        "• " + ANSI_BOLD + QString("/exit").leftJustified(26) + ANSI_RESET + "- Exit the application",
+        "• " + ANSI_BOLD + QString("/debugon /debugoff").leftJustified(26) + ANSI_RESET +
+            "- Turn debug statements on/off"};
+
+    showHelp(machine->name, machine->description, validInputNames, helpLines);
+
+    FILE* terminalInput = fdopen(dup(STDIN_FILENO), "r");
+    if (!terminalInput) {
+        debug("Error: Could not open terminal input");
+        return 1;
+    }
+
+    int terminalFd = fileno(terminalInput);
+    QSocketNotifier* inputNotifier = new QSocketNotifier(terminalFd, QSocketNotifier::Read, &app);
+
+    // QSocketNotifier::activated lambda: terminal input processing
+    QObject::connect(inputNotifier, &QSocketNotifier::activated, [&]() {
+        char buffer[256];
+        if (!fgets(buffer, sizeof(buffer), terminalInput)) {
+            if constexpr (LOG_DECORATIONS) {
+                log(DOUBLE_SEPARATOR);
+            }
+            log(ANSI_BOLD + COLOR_WARNING + "EOF (Ctrl+D) received. Exiting application." + ANSI_RESET);
+            if constexpr (LOG_DECORATIONS) {
+                log(DOUBLE_SEPARATOR);
+            }
+            inputNotifier->setEnabled(false);
+            fclose(terminalInput);
+            terminalInput = nullptr;
+            broadcastShutdownEvent("Server is shutting down due to EOF (Ctrl+D) on terminal. All clients will be "
+                                   "disconnected.");
+            closeAndCleanupAllSockets();
+            QCoreApplication::quit();
+            return;
+        }
+        QString inputLine = QString::fromLocal8Bit(buffer).trimmed();
+
+        if (inputLine.isEmpty()) {
+            return;
+        }
+
+        if (inputLine == "/exit") {
+            log("Quit command received. Terminating application.");
+            broadcastShutdownEvent("Server is shutting down due to /exit command. All clients will be disconnected.");
+            closeAndCleanupAllSockets();
+            QCoreApplication::quit();
+            return;
+        }
+
+        if (inputLine == "/help") {
+            showHelp(machine->name, machine->description, validInputNames, helpLines);
+            return;
+        }
+
+        if (inputLine.startsWith("/instance")) {
+            bool ok = false;
+            int id = inputLine.mid(9).trimmed().toInt(&ok);
+            if (!ok || !engine.instance(id)) {
+                log("Invalid instance, valid range is 0.." + QString::number(instanceCount - 1));
+                return;
+            }
+            terminalInstance = id;
+            log("Terminal commands now address instance " + QString::number(id));
+            return;
+        }
+
+        if (inputLine.startsWith("/reload")) {
+            QString path = inputLine.mid(7).trimmed();
+            if (path.isEmpty()) {
+                log("Usage: /reload <module.so>");
+                return;
+            }
+            QString error;
+            if (!reloadMachine(path, error)) {
+                log(COLOR_ERROR + "Reload rejected: " + error + ANSI_RESET);
+                return;
+            }
+            validInputNames.clear();
+            for (int i = 0; i < machine->inputCount; ++i) {
+                validInputNames.insert(QString::fromUtf8(machine->inputNames[i]));
+            }
+            log(COLOR_SUCCESS + "Machine logic reloaded from " + path + ANSI_RESET);
+            return;
+        }
+
+        if (inputLine == "/status") {
+            if (instanceCount > 1) {
+                log("Instance: " + ANSI_BOLD + QString::number(terminalInstance) + ANSI_RESET + " of " +
+                    QString::number(instanceCount));
+            }
+            // Show debug state
+            log(SECTION_SEPARATOR);
+            log(ANSI_BOLD + COLOR_HEADER + "DEBUG STATE:" + ANSI_RESET);
+            log(QString("  Debug output is ") +
+                (debugEnabled ? (COLOR_SUCCESS + "ENABLED" + ANSI_RESET) : (COLOR_WARNING + "DISABLED" + ANSI_RESET)));
+            // Show client connection status
+            log(SECTION_SEPARATOR);
+            log(ANSI_BOLD + COLOR_HEADER + "CLIENT CONNECTIONS:" + ANSI_RESET);
+            for (QIODevice* clientSocket : clientSockets) {
+                if (isClientConnected(clientSocket)) {
+                    const ClientQueue& queue = clientQueues[clientSocket];
+                    log("  " + COLOR_SUCCESS + "Client connected" + ANSI_RESET + " (" + clientAddress(clientSocket) +
+                        ") sent " + QString::number(queue.sent) + ", dropped " + QString::number(queue.dropped) +
+                        ", coalesced " + QString::number(queue.coalesced) + ", queued " +
+                        QString::number(queue.bytes + clientSocket->bytesToWrite()) + " B");
+                } else {
+                    log("  " + COLOR_WARNING + "Client disconnected" + ANSI_RESET);
+                }
+            }
+            // The machine state is read on the shard owning the instance
+            engine.runOn(terminalInstance, [](MachineInstance& instance) {
+                log(SECTION_SEPARATOR);
+                log("Current state: " + ANSI_BOLD + COLOR_STATE + currentStateName(instance) + ANSI_RESET);
+                // Show inputs
+                log(SECTION_SEPARATOR);
+                log(ANSI_BOLD + COLOR_HEADER + "INPUTS:" + ANSI_RESET);
+                for (int i = 0; i < machine->inputCount; ++i) {
+                    log("  " + COLOR_COMMAND + machine->inputNames[i] + ANSI_RESET + " = " + COLOR_VALUE +
+                        instance.inputValues[i] + ANSI_RESET);
+                }
+                // Show outputs
+                log(SECTION_SEPARATOR);
+                log(ANSI_BOLD + COLOR_HEADER + "OUTPUTS:" + ANSI_RESET);
+                for (int i = 0; i < machine->outputCount; ++i) {
+                    log("  " + COLOR_COMMAND + machine->outputNames[i] + ANSI_RESET + " = " + COLOR_VALUE +
+                        instance.outputValues[i] + ANSI_RESET);
+                }
+                // Show internal variables
+                log(SECTION_SEPARATOR);
+                log(ANSI_BOLD + COLOR_HEADER + "INTERNAL VARIABLES:" + ANSI_RESET);
+                for (int v = 0; v < machine->variableCount; ++v) {
+                    log("  " + COLOR_COMMAND + machine->variableNames[v] + ANSI_RESET + " = " + COLOR_VALUE +
+                        instance.context->variable(v).toString() + ANSI_RESET);
+                }
+                log(SECTION_SEPARATOR);
+            });
+            return;
+        }
+
+        if (inputLine == "/debugon") {
+            debugEnabled = true;
+            log("Debug output enabled.");
+            return;
+        }
+        if (inputLine == "/debugoff") {
+            debugEnabled = false;
+            log("Debug output disabled.");
+            return;
+        }
+
+        static const QRegularExpression inputRegex("^(\\w+)(?:=(.*))?$");
+        QRegularExpressionMatch match = inputRegex.match(inputLine);
+
+        if (match.hasMatch()) {
+            QString name = match.captured(1);
+            QString value = match.captured(2);
+
+            int input = inputIndex(name);
+            if (input == NO_EVENT) {
+                log("Invalid input name: " + ANSI_BOLD + COLOR_ERROR + name + ANSI_RESET);
+                return;
+            }
+
+            if (!value.isEmpty()) {
+                // SET mode: store the new value and trigger event
+                debugLazy("SET MODE for '%1' with value '%2'", name, value);
+                logInputEvent(name, value);
+                engine.setInput(terminalInstance, input, value);
+            } else {
+                // CALL mode: treat as pure event without changing stored value
+                debugLazy("CALL MODE for '%1'", name);
+                log("Input called: " + ANSI_BOLD + name + ANSI_RESET);
+                engine.callInput(terminalInstance, input);
+            }
+        } else {
+            log("Unrecognized command: " + ANSI_BOLD + COLOR_ERROR + inputLine + ANSI_RESET);
+        }
+    });
+
+    ProtocolServer server([]() { QCoreApplication::quit(); });
+    server.listen(hostAddr, port, localName);
+
+    debugLazy("%1%2INITIALIZING STATE MACHINE%3", ANSI_BOLD, COLOR_HEADER, ANSI_RESET);
+    engine.start(machine->initialState);
+    debugLazy("%1FSM activated successfully\n\n%2", COLOR_SUCCESS, ANSI_RESET);
+    int result = app.exec();
+    engine.stop();
+    if (machineModule) {
+        dlclose(machineModule);
+        machineModule = nullptr;
+    }
+    debugLazy("Application terminated with code %1", result);
+    return result;
+}
+
+int runMachineByName(int argc, char* argv[], const char* const* names, const MachineDefinition* const* machines,
+                     int count) {
+    // --machine NAME is taken out of the arguments, everything else is left to runMachine()
+    QByteArray selected = QFileInfo(QString::fromLocal8Bit(argv[0])).fileName().toLocal8Bit();
+    std::vector<char*> args = {argv[0]};
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--machine") == 0 && i + 1 < argc) {
+            selected = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    int rest = static_cast<int>(args.size());
+    args.push_back(nullptr);
+
+    for (int m = 0; m < count; ++m) {
+        if (selected == names[m]) {
+            return runMachine(rest, args.data(), *machines[m]);
+        }
+    }
+    std::fprintf(stderr, "Unknown machine '%s', run a link named after a machine or pass --machine with one of:\n",
+                 selected.constData());
+    for (int m = 0; m < count; ++m) {
+        std::fprintf(stderr, "  %s\n", names[m]);
+    }
+    return 1;
+}
+
+// Server of the machine hosted by startEmbeddedMachine(), null while none runs
+static std::unique_ptr<ProtocolServer> embeddedServer;
+
+bool startEmbeddedMachine(const MachineDefinition& definition, const QString& host, quint16 port,
+                          const QString& localName, std::function<void()> onShutdown) {
+    stopEmbeddedMachine();
+    instanceCount = 1;
+    useMachine(definition);
+    engine.createInstances(instanceCount);
+    engine.createShards(1);
+    embeddedServer.reset(new ProtocolServer([onShutdown]() {
+        // The server is still handling the command, it is deleted once control is back in the event loop
+        QTimer::singleShot(0, QCoreApplication::instance(), [onShutdown]() {
+            stopEmbeddedMachine();
+            if (onShutdown) {
+                onShutdown();
+            }
+        });
+    }));
+    QHostAddress hostAddr;
+    if (!hostAddr.setAddress(host)) {
+        log("Invalid host address specified, defaulting to 127.0.0.1");
+        hostAddr = QHostAddress::LocalHost;
+    }
+    if (!embeddedServer->listen(hostAddr, port, localName)) {
+        stopEmbeddedMachine();
+        return false;
+    }
+    engine.start(machine->initialState);
+    return true;
+}
+
+void stopEmbeddedMachine() {
+    // Taken first, the shutdown event may make a client stop the machine again while the sockets are closed
+    std::unique_ptr<ProtocolServer> server = std::move(embeddedServer);
+    if (!server) {
+        return;
+    }
+    broadcastShutdownEvent("Server is shutting down. All clients will be disconnected.");
+    closeAndCleanupAllSockets();
+    server.reset();
+    engine.stop();
+}
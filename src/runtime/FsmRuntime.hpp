@@ -0,0 +1,306 @@
+/**
+ * @file FsmRuntime.hpp
+ * @brief Public interface of the FSM runtime library linked into every generated FSM program.
+ *
+ * A generated program only holds what is specific to its machine: the name and transition tables, the custom
+ * variables and the code of the guards, delays and state actions. It describes them with a MachineDefinition and
+ * hands it to runMachine(); the dispatch engine, the client protocol, the transports and the terminal interface
+ * are compiled once into the fsm-runtime library.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QDebug>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+#include <functional>
+#include <vector>
+
+#include "Monitoring.hpp"
+
+/**
+ * @brief Custom variables and code of one hosted copy of a machine.
+ *
+ * The generated program derives from it, its variables become members and its guards, delays and state actions
+ * member functions, so user code keeps referring to the variables by name. The runtime creates one context per
+ * instance and calls it on the thread owning the instance.
+ */
+class MachineContext {
+   public:
+    virtual ~MachineContext() = default;
+
+    /**
+     * @brief Evaluate the condition of a transition.
+     * @param transition Index into MachineDefinition::transitions, only called for guarded transitions.
+     * @return True if the transition may be taken.
+     */
+    virtual bool guard(int transition) = 0;
+
+    /**
+     * @brief Get the delay of a transition.
+     * @param transition Index into MachineDefinition::transitions, only called for delayed transitions.
+     * @return Delay in milliseconds, 0 or less for an immediate transition.
+     */
+    virtual int delay(int transition) = 0;
+
+    /**
+     * @brief Run the onEntry action of a state.
+     * @param state Index of the entered state, only called for states with an action.
+     */
+    virtual void onEntry(int state) = 0;
+
+    /**
+     * @brief Read a custom variable, for status reports and change events.
+     * @param variable Index into MachineDefinition::variableNames.
+     * @return The current value.
+     */
+    virtual QVariant variable(int variable) const = 0;
+
+    /**
+     * @brief Overwrite a custom variable, used to carry the values over when the machine logic is reloaded.
+     * @param variable Index into MachineDefinition::variableNames.
+     * @param value New value, converted to the type of the variable, it counts as reported to the clients.
+     */
+    virtual void setVariable(int variable, const QVariant &value) = 0;
+
+    /**
+     * @brief Get the variables the last guards and state actions changed, the runtime reports and clears them.
+     * @return Indices into MachineDefinition::variableNames.
+     */
+    std::vector<int> &changedVariables() { return m_changed; }
+
+   protected:
+    /**
+     * @brief Note a variable as changed if it differs from its last reported value.
+     *
+     * Called after the guards and state actions that can write the variable. The shadow copy keeps the last
+     * reported value in the type of the variable, so unchanged variables are compared without building a QVariant.
+     *
+     * @param variable Index into MachineDefinition::variableNames.
+     * @param value Current value of the variable.
+     * @param shadow Last reported value, set to value on a change.
+     */
+    template <typename T>
+    void trackChange(int variable, const T &value, T &shadow) {
+        if (!(value == shadow)) {
+            shadow = value;
+            m_changed.push_back(variable);
+        }
+    }
+
+   private:
+    std::vector<int> m_changed;  // Variables changed since the runtime last reported them
+};
+
+/**
+ * @brief One row of the flat transition table.
+ */
+struct TransitionEntry {
+    int from;      // Source state
+    int to;        // Target state
+    int event;     // Triggering input, or -1 for eventless transitions
+    bool guarded;  // Whether MachineContext::guard() has to be asked
+    bool delayed;  // Whether MachineContext::delay() has to be asked
+};
+
+/**
+ * @brief Static description of a machine, emitted by the code generator.
+ *
+ * States, inputs, outputs and variables are referred to by their dense index into the name tables. The transitions
+ * are grouped by source state and then by input (eventless ones last); eventBuckets holds, for every state s and
+ * input e (e = inputCount for eventless transitions), the offset of bucket s * (inputCount + 1) + e, followed by
+ * transitionCount, so the dispatcher only walks the transitions listening to the dispatched input.
+ */
+struct MachineDefinition {
+    const char *name;                    // Name of the machine
+    const char *description;             // Comment of the machine, may be empty
+    const char *xml;                     // FSM model sent to clients on reqFSM
+    int stateCount;                      // Number of states
+    const char *const *stateNames;       // State names, sorted
+    int inputCount;                      // Number of inputs
+    const char *const *inputNames;       // Input names, sorted
+    int outputCount;                     // Number of outputs
+    const char *const *outputNames;      // Output names, sorted
+    int variableCount;                   // Number of custom variables
+    const char *const *variableNames;    // Variable names
+    const char *const *variableTypes;    // C++ types of the variables, for status reports
+    int transitionCount;                 // Number of transitions
+    const TransitionEntry *transitions;  // Transition table
+    const int *eventBuckets;             // stateCount * (inputCount + 1) + 1 bucket offsets into transitions
+    const bool *stateActions;            // Whether a state has an onEntry action
+    int initialState;                    // Initial state, -1 if the machine has none
+    MachineContext *(*createContext)();  // Creates the context of a new instance
+};
+
+/*
+ * Machine modules. A generated file compiled with -DFSM_MODULE as a shared object (-shared -fPIC) leaves out
+ * main() and only exports its definition through FSM_MODULE_ENTRY. A running program loads it with the /reload
+ * terminal command and swaps it in for the logic it runs, keeping the state, the variables and the armed timers.
+ * The program has to export the runtime to the module, so it is linked with -rdynamic; the module is built with
+ * -fvisibility=hidden so its own symbols do not clash with the ones of the program.
+ */
+#define FSM_MODULE_ENTRY fsmMachineDefinition
+#define FSM_MODULE_ENTRY_NAME "fsmMachineDefinition"
+
+/**
+ * @brief Signature of the FSM_MODULE_ENTRY function of a machine module.
+ */
+typedef const MachineDefinition *(*MachineModuleEntry)();
+
+/**
+ * @brief Run a machine as a standalone program.
+ *
+ * Parses the command line (--host, --port, --local, --shm, --shm-size, --instances, --threads, --flush-latency,
+ * --client-queue-limit, --slow-client, --conflate and --binary-log), serves the client protocol and the terminal
+ * commands and returns when the program is shut down. With --decode-log FILE it only prints a binary log.
+ *
+ * @param argc Argument count of main().
+ * @param argv Arguments of main().
+ * @param machine The machine to run, has to stay valid until the function returns.
+ * @return Exit code of the event loop.
+ */
+int runMachine(int argc, char *argv[], const MachineDefinition &machine);
+
+/**
+ * @brief Run one of several machines built into a single program, as done by a unity build.
+ *
+ * The machine is selected by --machine NAME or else by the file name the program was started as, so a link named
+ * after a machine runs that machine. The remaining arguments are handled by runMachine().
+ *
+ * @param argc Argument count of main().
+ * @param argv Arguments of main().
+ * @param names Names the machines are selected by.
+ * @param machines The machines, in the order of names.
+ * @param count Number of machines.
+ * @return Exit code of the event loop, 1 if no machine of that name exists.
+ */
+int runMachineByName(int argc, char *argv[], const char *const *names, const MachineDefinition *const *machines,
+                     int count);
+
+/**
+ * @brief Host a machine inside an application that runs its own event loop.
+ *
+ * Used by the interpreter mode of the editor. A single instance runs on a worker thread, the clients are served
+ * on the calling thread with the same protocol as a standalone program. A shutdown command stops the machine
+ * instead of quitting the application. A machine that is already hosted is stopped first.
+ *
+ * @param machine The machine to run, has to stay valid until it is stopped.
+ * @param host Address of the TCP server.
+ * @param port Port of the TCP server.
+ * @param localName Name of the local socket, empty for TCP only.
+ * @param onShutdown Called after a client shut the machine down, may be empty.
+ * @return True if the machine runs, false if the TCP server could not listen.
+ */
+bool startEmbeddedMachine(const MachineDefinition &machine, const QString &host, quint16 port,
+                          const QString &localName, std::function<void()> onShutdown);
+
+/**
+ * @brief Stop the machine started by startEmbeddedMachine(), notifying and disconnecting its clients.
+ */
+void stopEmbeddedMachine();
+
+/*
+ * Helper API for guards and state actions. The functions refer to the instance whose code is running; inputs and
+ * outputs are passed by index (the generator rewrites literal names to them) or by name.
+ */
+
+/*
+ * The generator emits the debug() calls of guards and state actions as FSM_DEBUG(). Its arguments are only
+ * evaluated while debugging is enabled, and a release build (-DFSM_RELEASE) compiles the calls out entirely.
+ */
+#ifdef FSM_RELEASE
+#define FSM_DEBUG(...) ((void)0)
+#else
+#define FSM_DEBUG(...) (debugEnabled.load(std::memory_order_relaxed) ? debug(__VA_ARGS__) : (void)0)
+#endif
+
+/**
+ * @brief Gets the value of an input.
+ * @param input Input index.
+ * @return Current value of the input as a string.
+ */
+QString valueof(int input);
+
+/**
+ * @brief Gets the value of an input.
+ * @param input Input name.
+ * @return Current value of the input as a string, or empty if not found.
+ */
+QString valueof(const QString &input);
+
+/**
+ * @brief Checks if an input has a non-empty value.
+ * @param input Input index.
+ * @return True if the input has a value.
+ */
+bool defined(int input);
+
+/**
+ * @brief Checks if an input is defined and has a non-empty value.
+ * @param input Input name to check.
+ * @return True if the input exists and has a value.
+ */
+bool defined(const QString &input);
+
+/**
+ * @brief Checks if an input is the event currently being dispatched.
+ *
+ * The input is reported to the transitions listening to it and to the first eventless step after them.
+ *
+ * @param input Input index to check.
+ * @return True if the input triggered the current dispatch.
+ */
+bool called(int input);
+
+/**
+ * @brief Checks if an input is the event currently being dispatched (regardless of value).
+ * @param input Input name to check.
+ * @return True if the input triggered the current dispatch.
+ */
+bool called(const QString &input);
+
+/**
+ * @brief Sends an output value.
+ * @param port Output index.
+ * @param value Value to send (any type supported by QVariant).
+ */
+void output(int port, const QVariant &value);
+
+/**
+ * @brief Sends an output value.
+ * @param port Output name.
+ * @param value Value to send (any type supported by QVariant).
+ */
+void output(const QString &port, const QVariant &value);
+
+/**
+ * @brief Returns time elapsed since state entry in milliseconds.
+ * @return Milliseconds elapsed since entering the current state.
+ */
+int elapsed();
+
+/**
+ * @brief Returns time elapsed since state entry in microseconds, for guards that need a finer resolution.
+ * @return Microseconds elapsed since entering the current state.
+ */
+qint64 elapsedMicros();
+
+/**
+ * @brief Reads the monotonic clock the runtime measures state entries and timers with.
+ *
+ * Unlike the wall clock it does not jump when the system time is adjusted.
+ *
+ * @return Microseconds since an arbitrary fixed point.
+ */
+qint64 monotonicMicros();
+
+/**
+ * @brief Converts a QString to an integer.
+ * @param str String to convert.
+ * @return Integer value, or 0 if conversion fails.
+ */
+int Qtoi(const QString &str);
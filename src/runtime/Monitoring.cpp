@@ -0,0 +1,438 @@
+/**
+ * @file Monitoring.cpp
+ * @brief Terminal logging and debugging output of the FSM runtime library.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "Monitoring.hpp"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "FsmRuntime.hpp"
+
+std::atomic<bool> debugEnabled{false};
+
+const QString ANSI_RESET = "\033[0m";
+const QString ANSI_BOLD = "\033[1m";
+
+const QString COLOR_STATE = "\033[38;5;93m";       // Purple
+const QString COLOR_TRANSITION = "\033[38;5;39m";  // Blueish
+const QString COLOR_SOURCE = "\033[38;5;102m";     // Gray
+const QString COLOR_TARGET = "\033[38;5;84m";      // Green
+const QString COLOR_COMMAND = "\033[38;5;231m";    // Whitish
+const QString COLOR_INPUT = "\033[38;5;75m";       // Cyan
+const QString COLOR_VALUE = "\033[38;5;153m";      // Light Blue
+const QString COLOR_HEADER = "\033[38;5;141m";     // Dark Purple
+
+const QString COLOR_INFO = "\033[38;5;39m";      // Blue
+const QString COLOR_NOTICE = "\033[38;5;102m";   // Grayish
+const QString COLOR_WARNING = "\033[38;5;220m";  // Yellow
+const QString COLOR_ERROR = "\033[38;5;196m";    // Red
+const QString COLOR_SUCCESS = "\033[38;5;84m";   // Greener
+
+const QString TIMEOUT_STARTED = "\033[38;5;177m";  // Pinkish
+const QString TIMEOUT_EXPIRED = "\033[38;5;213m";  // Magenta
+
+const QString STATE_HEADER = ANSI_BOLD + COLOR_STATE + "════════ STATE: " + ANSI_RESET;
+const QString COMMAND_HEADER = ANSI_BOLD + COLOR_COMMAND + "⟫ COMMAND: " + ANSI_RESET;
+const QString SECTION_SEPARATOR = COLOR_NOTICE + "───────────────────────────────────────────────────" + ANSI_RESET;
+const QString DOUBLE_SEPARATOR = COLOR_TRANSITION + "═══════════════════════════════════════════════════" + ANSI_RESET;
+
+namespace {
+
+// Identifies a binary log and the version of its record layout
+const quint32 BINARY_LOG_MAGIC = 0x46534d4c;
+const quint32 BINARY_LOG_VERSION = 1;
+
+/**
+ * @brief Message waiting in the log ring, formatted only when the log thread writes it.
+ */
+struct LogRecord {
+    qint64 time = 0;               // monotonicMicros() when the message was logged
+    LogLevel level = LOG_INFO;     // Severity
+    const char* format = nullptr;  // Static format of logRecord(), null if text is the message
+    QString text;                  // Message of log() and debug()
+    QVariant args[LOG_MAX_ARGS];   // Values of the placeholders of format
+    int argCount = 0;              // Number of args in use
+};
+
+/**
+ * @brief Replace the placeholders of a format in one pass, so arguments containing %n stay as they are.
+ * @param format Format with %1, %2, ... placeholders.
+ * @param args Values of the placeholders.
+ * @param count Number of args.
+ * @return The formatted message.
+ */
+QString formatMessage(const QString& format, const QVariant* args, int count) {
+    QString a[LOG_MAX_ARGS];
+    for (int i = 0; i < count; ++i) {
+        a[i] = args[i].toString();
+    }
+    switch (count) {
+        case 0: return format;
+        case 1: return format.arg(a[0]);
+        case 2: return format.arg(a[0], a[1]);
+        case 3: return format.arg(a[0], a[1], a[2]);
+        case 4: return format.arg(a[0], a[1], a[2], a[3]);
+        case 5: return format.arg(a[0], a[1], a[2], a[3], a[4]);
+        case 6: return format.arg(a[0], a[1], a[2], a[3], a[4], a[5]);
+        case 7: return format.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+        case 8: return format.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        default: return format.arg(a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8]);
+    }
+}
+
+/**
+ * @brief Print a message to the terminal.
+ * @param time Wall clock time the message was logged at.
+ * @param level Severity, debug messages get a prefix.
+ * @param message The message.
+ */
+void printMessage(const QDateTime& time, LogLevel level, const QString& message) {
+    const QString timeStr = time.toString("HH:mm:ss.zzz");
+    if (level == LOG_DEBUG) {
+        QString prefix = COLOR_INFO + "• DEBUG" + ANSI_RESET + ": ";
+        qDebug().noquote() << "[" << timeStr << "]" << prefix << message;
+    } else {
+        qDebug().noquote() << "[" << timeStr << "]" << message;
+    }
+}
+
+/**
+ * @brief Bounded multi-producer, single-consumer ring of log records.
+ *
+ * Every slot carries a sequence number telling whether it is free for the producer claiming that position or
+ * filled for the consumer, so producers only race on a compare-and-swap of the write position and never block.
+ */
+class LogRing {
+   public:
+    static constexpr size_t CAPACITY = 16384;  // Power of two, so positions wrap with a mask
+
+    LogRing() : m_slots(new Slot[CAPACITY]) {
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Append a record, called by any thread.
+     * @param record Record to move into the ring.
+     * @return False if the ring is full.
+     */
+    bool push(LogRecord& record) {
+        size_t position = m_writePosition.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &m_slots[position & (CAPACITY - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (m_writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = m_writePosition.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record = std::move(record);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest record, called by the log thread only.
+     * @param record Receives the record.
+     * @return False if the ring is empty.
+     */
+    bool pop(LogRecord& record) {
+        Slot& slot = m_slots[m_readPosition & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_readPosition + 1) {
+            return false;
+        }
+        record = std::move(slot.record);
+        slot.record = LogRecord();
+        slot.sequence.store(m_readPosition + CAPACITY, std::memory_order_release);
+        ++m_readPosition;
+        return true;
+    }
+
+   private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        LogRecord record;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<size_t> m_writePosition{0};  // Next position a producer claims
+    alignas(64) size_t m_readPosition = 0;               // Next position the log thread reads
+};
+
+/**
+ * @brief Background thread writing the queued messages to the terminal and the binary log.
+ */
+class LogWriter {
+   public:
+    LogWriter()
+        : m_wallBase(QDateTime::currentMSecsSinceEpoch()),
+          m_monotonicBase(monotonicMicros()),
+          m_thread([this]() { run(); }) {}
+
+    ~LogWriter() {
+        m_stop.store(true);
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    /**
+     * @brief Queue a record, dropping it if the ring is full.
+     * @param record Record to queue.
+     */
+    void write(LogRecord& record) {
+        if (!m_ring.push(record)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_queued.fetch_add(1, std::memory_order_release);
+        if (m_sleeping.load(std::memory_order_acquire)) {
+            m_wake.notify_one();
+        }
+    }
+
+    /**
+     * @brief Wait until the records queued so far are written.
+     */
+    void flush() {
+        const quint64 target = m_queued.load(std::memory_order_acquire);
+        m_wake.notify_one();
+        // Bounded, a message logged while the program exits must not hang it
+        for (int i = 0; i < 2000 && m_written.load(std::memory_order_acquire) < target; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    /**
+     * @brief Start writing the records to a binary log as well.
+     * @param path File to create.
+     * @return True if the file was opened.
+     */
+    bool openBinary(const QString& path) {
+        std::lock_guard<std::mutex> lock(m_binaryMutex);
+        std::unique_ptr<QFile> file(new QFile(path));
+        if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        m_binaryFile = std::move(file);
+        m_binary.setDevice(m_binaryFile.get());
+        m_binary.setVersion(QDataStream::Qt_5_6);
+        m_binary << BINARY_LOG_MAGIC << BINARY_LOG_VERSION;
+        return true;
+    }
+
+   private:
+    /**
+     * @brief Loop of the log thread, drains the ring and sleeps while it is empty.
+     */
+    void run() {
+        LogRecord record;
+        while (true) {
+            bool wrote = false;
+            while (m_ring.pop(record)) {
+                emitRecord(record);
+                m_written.fetch_add(1, std::memory_order_release);
+                wrote = true;
+            }
+            const quint64 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                LogRecord notice;
+                notice.time = monotonicMicros();
+                notice.text = COLOR_WARNING + QString::number(dropped) + " log messages dropped" + ANSI_RESET;
+                emitRecord(notice);
+            }
+            if (wrote) {
+                std::lock_guard<std::mutex> lock(m_binaryMutex);
+                if (m_binaryFile) {
+                    m_binaryFile->flush();
+                }
+                continue;
+            }
+            if (m_stop.load()) {
+                return;
+            }
+            // Producers only notify while the flag is set and never take the mutex, the timeout covers a
+            // notification sent between the empty check and the wait
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_sleeping.store(true, std::memory_order_release);
+            m_wake.wait_for(lock, std::chrono::milliseconds(20));
+            m_sleeping.store(false, std::memory_order_release);
+        }
+    }
+
+    /**
+     * @brief Write a record to the binary log and the terminal.
+     * @param record The record.
+     */
+    void emitRecord(const LogRecord& record) {
+        const QDateTime time = QDateTime::fromMSecsSinceEpoch(m_wallBase + (record.time - m_monotonicBase) / 1000);
+        {
+            std::lock_guard<std::mutex> lock(m_binaryMutex);
+            if (m_binaryFile) {
+                QVariantList args;
+                for (int i = 0; i < record.argCount; ++i) {
+                    args << record.args[i];
+                }
+                m_binary << time.toMSecsSinceEpoch() << static_cast<quint8>(record.level)
+                         << (record.format ? QString::fromUtf8(record.format) : record.text) << args;
+            }
+        }
+        const QString message = record.format ? formatMessage(QString::fromUtf8(record.format), record.args,
+                                                              record.argCount)
+                                              : record.text;
+        printMessage(time, record.level, message);
+    }
+
+    LogRing m_ring;
+    const qint64 m_wallBase;              // Wall clock (ms since epoch) at m_monotonicBase
+    const qint64 m_monotonicBase;         // monotonicMicros() when the writer started
+    std::atomic<quint64> m_queued{0};     // Records pushed into the ring
+    std::atomic<quint64> m_written{0};    // Records written by the log thread
+    std::atomic<quint64> m_dropped{0};    // Records lost to a full ring since the last notice
+    std::atomic<bool> m_sleeping{false};  // Whether the log thread waits for a notification
+    std::atomic<bool> m_stop{false};      // Set on destruction, the thread drains the ring and exits
+    std::mutex m_sleepMutex;              // Only taken by the log thread to wait
+    std::condition_variable m_wake;
+    std::mutex m_binaryMutex;             // Guards the binary log against openBinary() while writing
+    std::unique_ptr<QFile> m_binaryFile;  // Binary log, null if none
+    QDataStream m_binary;
+    std::thread m_thread;                 // Started last, after every member it uses
+};
+
+/**
+ * @brief Get the log writer, started on the first message.
+ * @return The writer of the process.
+ */
+LogWriter& logWriter() {
+    static LogWriter writer;
+    return writer;
+}
+
+/**
+ * @brief Queue a fully built message.
+ * @param level Severity.
+ * @param message The message.
+ */
+void queueText(LogLevel level, const QString& message) {
+    LogRecord record;
+    record.time = monotonicMicros();
+    record.level = level;
+    record.text = message;
+    logWriter().write(record);
+}
+
+}  // namespace
+
+void log(const QString& message) {
+    if (FSM_LOG_LEVEL <= LOG_INFO) {
+        queueText(LOG_INFO, message);
+    }
+}
+
+void logInputEvent(const QString& input, const QString& value) {
+    logLazy("Input value: %1%2%3 = %4%5%6", ANSI_BOLD, input, ANSI_RESET, COLOR_VALUE, value, ANSI_RESET);
+}
+
+void logOutputEvent(const QString& output, const QString& value) {
+    logLazy("Output value: %1%2%3 = %4%5%6", ANSI_BOLD, output, ANSI_RESET, COLOR_VALUE, value, ANSI_RESET);
+}
+
+void debug(const QString& message) {
+    if (FSM_LOG_LEVEL > LOG_DEBUG || !debugEnabled) return;
+    queueText(LOG_DEBUG, message);
+}
+
+void logRecord(LogLevel level, const char* format, std::initializer_list<QVariant> args) {
+    LogRecord record;
+    record.time = monotonicMicros();
+    record.level = level;
+    record.format = format;
+    for (const QVariant& arg : args) {
+        if (record.argCount < LOG_MAX_ARGS) {
+            record.args[record.argCount++] = arg;
+        }
+    }
+    logWriter().write(record);
+}
+
+void flushLog() { logWriter().flush(); }
+
+bool openBinaryLog(const QString& path) { return logWriter().openBinary(path); }
+
+bool printBinaryLog(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != BINARY_LOG_MAGIC || version != BINARY_LOG_VERSION) {
+        return false;
+    }
+    while (!in.atEnd()) {
+        qint64 time = 0;
+        quint8 level = 0;
+        QString format;
+        QVariantList args;
+        in >> time >> level >> format >> args;
+        if (in.status() != QDataStream::Ok) {
+            return false;
+        }
+        QVariant values[LOG_MAX_ARGS];
+        const int count = qMin(args.size(), LOG_MAX_ARGS);
+        for (int i = 0; i < count; ++i) {
+            values[i] = args[i];
+        }
+        printMessage(QDateTime::fromMSecsSinceEpoch(time), static_cast<LogLevel>(level),
+                     formatMessage(format, values, count));
+    }
+    return true;
+}
+
+void showHelp(const QString& fsmName, const QString& fsmDescription, const QSet<QString>& validInputs,
+              const QStringList& helpLines) {
+    log(DOUBLE_SEPARATOR);
+    log(ANSI_BOLD + COLOR_HEADER + "Machine: " + ANSI_RESET + COLOR_STATE + fsmName + ANSI_RESET);
+    if (!fsmDescription.isEmpty()) {
+        log(fsmDescription);
+    }
+    log(DOUBLE_SEPARATOR);
+    log(ANSI_BOLD + COLOR_COMMAND + "AVAILABLE COMMANDS:" + ANSI_RESET);
+    for (const QString& line : helpLines) {
+        log(line);
+    }
+    log(SECTION_SEPARATOR);
+    if (!validInputs.isEmpty()) {
+        log(ANSI_BOLD + COLOR_INPUT + "VALID INPUTS:" + ANSI_RESET);
+        QStringList sortedInputs = validInputs.values();
+        sortedInputs.sort();
+        for (const QString& input : sortedInputs) {
+            log("  " + COLOR_INPUT + input + ANSI_RESET);
+        }
+    }
+    log(SECTION_SEPARATOR);
+}
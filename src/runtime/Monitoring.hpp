@@ -0,0 +1,203 @@
+/**
+ * @file Monitoring.hpp
+ * @brief Terminal logging and debugging output of the FSM runtime library.
+ *
+ * The functions are part of the helper API, so the code of a machine can log through them as well. Messages are
+ * queued in a lock-free ring and written by a background thread, so logging never waits for the terminal. The
+ * timestamp and the lazily formatted messages of logLazy() and debugLazy() are only formatted by that thread.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+#include <atomic>
+#include <initializer_list>
+
+/**
+ * @brief Severity of a runtime message. LOG_NONE is no severity, as FSM_LOG_LEVEL it compiles every message out.
+ */
+enum LogLevel { LOG_DEBUG = 0, LOG_INFO = 1, LOG_NONE = 2 };
+
+/*
+ * Build profiles. The default one keeps every message, debug messages are toggled at runtime with /debugon and only
+ * formatted when enabled. The release profile (-DFSM_RELEASE, for the runtime and the generated code alike)
+ * compiles the debug messages and the decorative banners and separators out.
+ */
+// Messages below this level are compiled out, e.g. -DFSM_LOG_LEVEL=1 (LOG_INFO) drops debugLazy() and
+// -DFSM_LOG_LEVEL=2 (LOG_NONE) drops logLazy() and log() as well, leaving a silent runtime
+#ifndef FSM_LOG_LEVEL
+#ifdef FSM_RELEASE
+#define FSM_LOG_LEVEL LOG_INFO
+#else
+#define FSM_LOG_LEVEL LOG_DEBUG
+#endif
+#endif
+
+/**
+ * @brief Whether the terminal output is decorated with banners and separators.
+ */
+#ifdef FSM_RELEASE
+constexpr bool LOG_DECORATIONS = false;
+#else
+constexpr bool LOG_DECORATIONS = true;
+#endif
+
+/**
+ * @brief Most arguments a message of logLazy() or debugLazy() can take.
+ */
+constexpr int LOG_MAX_ARGS = 9;
+
+/**
+ * @brief Whether debug() prints anything, toggled with /debugon and /debugoff.
+ */
+extern std::atomic<bool> debugEnabled;
+
+extern const QString ANSI_RESET;
+extern const QString ANSI_BOLD;
+
+// Semantic Color Mappings
+extern const QString COLOR_STATE;
+extern const QString COLOR_TRANSITION;
+extern const QString COLOR_SOURCE;
+extern const QString COLOR_TARGET;
+extern const QString COLOR_COMMAND;
+extern const QString COLOR_INPUT;
+extern const QString COLOR_VALUE;
+extern const QString COLOR_HEADER;
+
+// Status & Logging Colors
+extern const QString COLOR_INFO;
+extern const QString COLOR_NOTICE;
+extern const QString COLOR_WARNING;
+extern const QString COLOR_ERROR;
+extern const QString COLOR_SUCCESS;
+
+// Timeout Specific Colors
+extern const QString TIMEOUT_STARTED;
+extern const QString TIMEOUT_EXPIRED;
+
+extern const QString STATE_HEADER;
+extern const QString COMMAND_HEADER;
+extern const QString SECTION_SEPARATOR;
+extern const QString DOUBLE_SEPARATOR;
+
+/**
+ * @brief Prints a log message.
+ * @param message Log message to display.
+ */
+void log(const QString &message);
+
+/**
+ * @brief Prints a debug message if debugEnabled is true.
+ * @param message Debug message to display.
+ */
+void debug(const QString &message);
+
+/**
+ * @brief Queues a message that is formatted by the log thread.
+ * @param level Severity of the message.
+ * @param format Format with %1, %2, ... placeholders, has to outlive the program (a string literal).
+ * @param args Values of the placeholders, at most LOG_MAX_ARGS.
+ */
+void logRecord(LogLevel level, const char *format, std::initializer_list<QVariant> args);
+
+/**
+ * @brief Captures an argument of a lazily formatted message.
+ * @param text C string, copied as it may not live until the message is formatted.
+ * @return The captured value.
+ */
+inline QVariant logArgument(const char *text) { return QString::fromUtf8(text); }
+
+/**
+ * @brief Captures an argument of a lazily formatted message.
+ * @param value Value of a type QVariant can hold.
+ * @return The captured value.
+ */
+template <typename T>
+inline QVariant logArgument(const T &value) {
+    return QVariant::fromValue(value);
+}
+
+/**
+ * @brief Prints a log message, formatting it on the log thread. Not compiled at all if FSM_LOG_LEVEL is LOG_NONE.
+ * @param format Format with %1, %2, ... placeholders, has to outlive the program (a string literal).
+ * @param args Values of the placeholders.
+ */
+template <typename... Args>
+void logLazy(const char *format, const Args &...args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments of a log message");
+    if constexpr (FSM_LOG_LEVEL <= LOG_INFO) {
+        logRecord(LOG_INFO, format, {logArgument(args)...});
+    }
+}
+
+/**
+ * @brief Prints a debug message if debugEnabled is true, formatting it on the log thread.
+ *
+ * The arguments are only captured while debugging is enabled, so a disabled call costs a flag check and a call
+ * below FSM_LOG_LEVEL is not compiled at all.
+ *
+ * @param format Format with %1, %2, ... placeholders, has to outlive the program (a string literal).
+ * @param args Values of the placeholders.
+ */
+template <typename... Args>
+void debugLazy(const char *format, const Args &...args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments of a log message");
+    if constexpr (FSM_LOG_LEVEL <= LOG_DEBUG) {
+        if (debugEnabled.load(std::memory_order_relaxed)) {
+            logRecord(LOG_DEBUG, format, {logArgument(args)...});
+        }
+    }
+}
+
+/**
+ * @brief Wait until the log thread wrote every message queued so far.
+ */
+void flushLog();
+
+/**
+ * @brief Additionally write every message to a binary log, unformatted.
+ *
+ * Records keep the format and the arguments of a message, so writing them costs no formatting.
+ *
+ * @param path File to create.
+ * @return True if the file was opened.
+ */
+bool openBinaryLog(const QString &path);
+
+/**
+ * @brief Print a binary log written with openBinaryLog() as text.
+ * @param path The binary log.
+ * @return True if the whole file was read.
+ */
+bool printBinaryLog(const QString &path);
+
+/**
+ * @brief Logs input values for monitoring.
+ * @param input Input name.
+ * @param value Input value.
+ */
+void logInputEvent(const QString &input, const QString &value);
+
+/**
+ * @brief Logs output values for monitoring.
+ * @param output Output name.
+ * @param value Output value.
+ */
+void logOutputEvent(const QString &output, const QString &value);
+
+/**
+ * @brief Displays all available commands and valid inputs.
+ * @param fsmName Name of the FSM.
+ * @param fsmDescription Description of the FSM.
+ * @param validInputs Set of valid input names.
+ * @param helpLines List of command descriptions to display.
+ */
+void showHelp(const QString &fsmName, const QString &fsmDescription, const QSet<QString> &validInputs,
+              const QStringList &helpLines);
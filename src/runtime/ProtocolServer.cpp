@@ -0,0 +1,485 @@
+/**
+ * @file ProtocolServer.cpp
+ * @brief TCP and local socket server of the FSM runtime, executing the commands of the clients.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "ProtocolServer.hpp"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QPointer>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QtEndian>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpSocket>
+#include <QtXml/QDomDocument>
+#include <vector>
+
+#include "DispatchEngine.hpp"
+#include "WireProtocol.hpp"
+
+/**
+ * @brief Builds the status event reported to clients.
+ * @param instance Machine instance to report.
+ * @return Serialized status event.
+ */
+static QString generateStatusXml(const MachineInstance& instance) {
+    QDomDocument doc;
+    QDomElement eventElem = doc.createElement("event");
+    eventElem.setAttribute("type", "status");
+    tagInstance(eventElem, instance.instanceId);
+    QDomElement root = doc.createElement("status");
+    eventElem.appendChild(root);
+    doc.appendChild(eventElem);
+
+    QDomElement stateElem = doc.createElement("state");
+    stateElem.appendChild(doc.createTextNode(currentStateName(instance)));
+    root.appendChild(stateElem);
+
+    QDomElement inputsElem = doc.createElement("inputs");
+    for (int i = 0; i < machine->inputCount; ++i) {
+        QDomElement inputElem = doc.createElement("input");
+        inputElem.setAttribute("name", machine->inputNames[i]);
+        inputElem.appendChild(doc.createTextNode(instance.inputValues[i]));
+        inputsElem.appendChild(inputElem);
+    }
+    root.appendChild(inputsElem);
+
+    QDomElement outputsElem = doc.createElement("outputs");
+    for (int i = 0; i < machine->outputCount; ++i) {
+        QDomElement outputElem = doc.createElement("output");
+        outputElem.setAttribute("name", machine->outputNames[i]);
+        outputElem.appendChild(doc.createTextNode(instance.outputValues[i]));
+        outputsElem.appendChild(outputElem);
+    }
+    root.appendChild(outputsElem);
+
+    QDomElement varsElem = doc.createElement("variables");
+    for (int v = 0; v < machine->variableCount; ++v) {
+        QDomElement varElem = doc.createElement("var");
+        varElem.setAttribute("name", machine->variableNames[v]);
+        varElem.setAttribute("type", machine->variableTypes[v]);
+        varElem.appendChild(doc.createTextNode(instance.context->variable(v).toString()));
+        varsElem.appendChild(varElem);
+    }
+    root.appendChild(varsElem);
+
+    QDomElement timersElem = doc.createElement("timers");
+    for (int t = 0; t < machine->transitionCount; ++t) {
+        if (!instance.timerArmed[t]) {
+            continue;
+        }
+        QDomElement timerElem = doc.createElement("timer");
+        QDomElement fromElem = doc.createElement("from");
+        fromElem.appendChild(doc.createTextNode(machine->stateNames[machine->transitions[t].from]));
+        QDomElement toElem = doc.createElement("to");
+        toElem.appendChild(doc.createTextNode(machine->stateNames[machine->transitions[t].to]));
+        QDomElement msElem = doc.createElement("ms");
+        msElem.appendChild(doc.createTextNode(QString::number(instance.timerDelay[t])));
+        timerElem.appendChild(fromElem);
+        timerElem.appendChild(toElem);
+        timerElem.appendChild(msElem);
+        timersElem.appendChild(timerElem);
+    }
+    root.appendChild(timersElem);
+
+    return doc.toString(-1);
+}
+
+/**
+ * @brief Replaces the subscription of a client.
+ *
+ * The events element lists event types (stateChange, input, output, variable, timer, timerStart, timerExpired, or
+ * none for no events at all), the names element input, output and variable names; both are separated by spaces or
+ * commas and missing or empty means everything. An instance attribute limits the events to one instance.
+ *
+ * @param socket Client socket.
+ * @param message The subscribe command.
+ * @param error Set to the offending entry if the command is rejected.
+ * @return True if the subscription was applied.
+ */
+static bool subscribeClient(QIODevice* socket, const XmlMessage& message, QString& error) {
+    static const QRegularExpression separators("[\\s,]+");
+    Subscription subscription;
+    const XmlSlice instance = message.attribute("instance");
+    if (!instance.isNull()) {
+        bool ok = false;
+        subscription.instance = instance.toInt(&ok);
+        if (!ok || subscription.instance < 0 || subscription.instance >= instanceCount) {
+            error = instance.toString();
+            return false;
+        }
+    }
+    const QStringList events = message.child("events").toString().split(separators, QString::SkipEmptyParts);
+    if (!events.isEmpty()) {
+        subscription.types = 0;
+    }
+    for (const QString& event : events) {
+        if (event == "none") {
+            // Replies only, used by clients that read the events from the shared-memory stream
+            continue;
+        } else if (event == "stateChange") {
+            subscription.types |= 1u << FRAME_STATE_CHANGE;
+        } else if (event == "input") {
+            subscription.types |= 1u << FRAME_INPUT;
+        } else if (event == "output") {
+            subscription.types |= 1u << FRAME_OUTPUT;
+        } else if (event == "variable") {
+            subscription.types |= 1u << FRAME_VARIABLE;
+        } else if (event == "timer") {
+            subscription.types |= (1u << FRAME_TIMER_START) | (1u << FRAME_TIMER_EXPIRED);
+        } else if (event == "timerStart") {
+            subscription.types |= 1u << FRAME_TIMER_START;
+        } else if (event == "timerExpired") {
+            subscription.types |= 1u << FRAME_TIMER_EXPIRED;
+        } else {
+            error = event;
+            return false;
+        }
+    }
+    const QStringList names = message.child("names").toString().split(separators, QString::SkipEmptyParts);
+    if (!names.isEmpty()) {
+        subscription.byName = true;
+        subscription.inputs.fill(false, machine->inputCount);
+        subscription.outputs.fill(false, machine->outputCount);
+        subscription.variables.fill(false, machine->variableCount);
+    }
+    for (const QString& name : names) {
+        bool known = false;
+        const int input = inputIndex(name);
+        if (input != NO_EVENT) {
+            subscription.inputs[input] = known = true;
+        }
+        const int output = outputIndex(name);
+        if (output != NO_OUTPUT) {
+            subscription.outputs[output] = known = true;
+        }
+        for (int v = 0; v < machine->variableCount; ++v) {
+            if (name == QLatin1String(machine->variableNames[v])) {
+                subscription.variables[v] = known = true;
+            }
+        }
+        if (!known) {
+            error = name;
+            return false;
+        }
+    }
+    clientQueues[socket].subscription = subscription;
+    updateWantedEvents();
+    return true;
+}
+
+ProtocolServer::ProtocolServer(std::function<void()> shutdown) : m_shutdown(std::move(shutdown)) {
+    QObject::connect(&m_server, &QTcpServer::newConnection, [this]() {
+        while (m_server.hasPendingConnections()) {
+            QTcpSocket* socket = m_server.nextPendingConnection();
+            setupClient(socket);
+
+            QObject::connect(socket, &QTcpSocket::disconnected, [socket]() {
+                log("Client disconnected");
+                cleanupSocket(socket);
+            });
+
+            // Done this way to avoid ambiguity because in Qt5.9 there are multiple overloaded error signals
+            QObject::connect(socket,
+                             // Explicitly choosing the right signal overload
+                             static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::error),
+                             [socket](QAbstractSocket::SocketError) {
+                                 log(QString("Socket error occurred: %1").arg(socket->errorString()));
+                                 cleanupSocket(socket);
+                             });
+        }
+    });
+
+    QObject::connect(&m_localServer, &QLocalServer::newConnection, [this]() {
+        while (m_localServer.hasPendingConnections()) {
+            QLocalSocket* socket = m_localServer.nextPendingConnection();
+            setupClient(socket);
+
+            QObject::connect(socket, &QLocalSocket::disconnected, [socket]() {
+                log("Local client disconnected");
+                cleanupSocket(socket);
+            });
+
+            // QLocalSocket has the same overloaded error signals as QTcpSocket
+            QObject::connect(
+                socket, static_cast<void (QLocalSocket::*)(QLocalSocket::LocalSocketError)>(&QLocalSocket::error),
+                [socket](QLocalSocket::LocalSocketError) {
+                    log(QString("Socket error occurred: %1").arg(socket->errorString()));
+                    cleanupSocket(socket);
+                });
+        }
+    });
+
+    m_pingIntervalTimer.setInterval(20000);  // 20s
+    QObject::connect(&m_pingIntervalTimer, &QTimer::timeout, [this]() { pingClients(); });
+}
+
+bool ProtocolServer::listen(const QHostAddress& host, quint16 port, const QString& localName) {
+    const bool listening = m_server.listen(host, port);
+    if (listening) {
+        log(QString("Listening for TCP connections on %1:%2").arg(host.toString()).arg(port));
+    } else {
+        log("Could not listen on TCP port " + QString::number(port) + ": " + m_server.errorString());
+    }
+    if (!localName.isEmpty()) {
+        // A socket file left behind by a crashed server would make listen() fail
+        QLocalServer::removeServer(localName);
+        if (m_localServer.listen(localName)) {
+            log("Listening for local connections on " + m_localServer.fullServerName());
+        } else {
+            log("Could not listen on local socket '" + localName + "': " + m_localServer.errorString());
+        }
+    }
+    m_pingIntervalTimer.start();
+    return listening;
+}
+
+void ProtocolServer::setupClient(QIODevice* socket) {
+    clientSockets.insert(socket);
+    watchClient(socket);
+    log("Client connected from " + clientAddress(socket));
+    QObject::connect(socket, &QIODevice::readyRead, [this, socket]() { readClient(socket); });
+}
+
+void ProtocolServer::readClient(QIODevice* socket) {
+    while (isClientConnected(socket)) {
+        if (!binaryClients.contains(socket)) {
+            // Shared by all clients, an incomplete line stays in its socket until the rest arrives
+            static XmlLineReader lineReader;
+            if (!lineReader.readLine(socket)) {
+                break;
+            }
+            handleXmlCommand(socket, lineReader.data(), lineReader.size());
+            continue;
+        }
+        uchar header[5];
+        if (socket->peek(reinterpret_cast<char*>(header), 5) < 5) {
+            break;
+        }
+        const quint32 length = qFromBigEndian<quint32>(header);
+        if (length == 0 || length > MAX_FRAME_LENGTH) {
+            log("Client " + clientAddress(socket) + " sent an invalid frame, disconnecting");
+            sendError(ERR_MALFORMED_FRAME, "Malformed frame", socket);
+            disconnectClient(socket);
+            break;
+        }
+        if (socket->bytesAvailable() < static_cast<qint64>(length) + 4) {
+            break;
+        }
+        socket->read(5);
+        handleFrame(socket, header[4], socket->read(length - 1));
+    }
+}
+
+void ProtocolServer::handleXmlCommand(QIODevice* socket, const char* data, int size) {
+    const XmlSlice line = XmlSlice{data, size}.trimmed();
+    if (line.size == 0) {
+        return;
+    }
+    if (debugEnabled) {
+        debugLazy("TCP: Received line: %1", line.toString());
+    }
+    static XmlMessage message;
+    if (!message.parse(line.data, line.size) || message.tag() != "command") {
+        debugLazy("TCP: Malformed XML received: %1", QString::fromUtf8(line.data, line.size));
+        sendError(ERR_MALFORMED_XML, "Malformed XML", socket);
+        return;
+    }
+    const XmlSlice type = message.attribute("type");
+    const bool addressed = type == "set" || type == "call" || type == "status" || type == "batch";
+    MachineInstance* target = nullptr;
+    if (addressed) {
+        // set, call and status address an instance, the first one if the attribute is missing
+        const XmlSlice instanceAttr = message.attribute("instance");
+        bool instanceOk = true;
+        target = engine.instance(instanceAttr.isNull() ? 0 : instanceAttr.toInt(&instanceOk));
+        if (!instanceOk || !target) {
+            debugLazy("TCP: Unknown instance '%1' in %2 command", instanceAttr.toString(), type.toString());
+            sendError(ERR_UNKNOWN_INSTANCE, "Unknown instance", socket);
+            return;
+        }
+    }
+    if (type == "set") {
+        const XmlSlice name = message.child("name");
+        int input = inputIndex(name);
+        if (input != NO_EVENT) {
+            QString value = message.child("value").toString();
+            engine.setInput(target->instanceId, input, value);
+            logLazy("Input '%1' set to '%2' via TCP", machine->inputNames[input], value);
+        } else {
+            debugLazy("TCP: Unknown input '%1' in set command", name.toString());
+            sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
+        }
+    } else if (type == "call") {
+        const XmlSlice name = message.child("name");
+        int input = inputIndex(name);
+        if (input != NO_EVENT) {
+            engine.callInput(target->instanceId, input);
+            logLazy("Input '%1' called via TCP", machine->inputNames[input]);
+        } else {
+            debugLazy("TCP: Unknown input '%1' in call command", name.toString());
+            sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
+        }
+    } else if (type == "batch") {
+        // <set name="x">value</set> and <call name="y"/> items, rejected as a whole on an error
+        const XmlSlice mode = message.attribute("mode");
+        if (!mode.isNull() && mode != "atomic" && mode != "each") {
+            sendError(ERR_UNKNOWN_COMMAND, "Unknown batch mode", socket);
+            return;
+        }
+        std::vector<BatchItem> items;
+        items.reserve(message.children().size());
+        for (const XmlMessage::Child& child : message.children()) {
+            const bool store = child.tag == "set";
+            if (!store && child.tag != "call") {
+                sendError(ERR_UNKNOWN_COMMAND, "Unknown batch operation", socket);
+                return;
+            }
+            const int input = inputIndex(child.name);
+            if (input == NO_EVENT) {
+                debugLazy("TCP: Unknown input '%1' in batch command", child.name.toString());
+                sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
+                return;
+            }
+            items.push_back(BatchItem{input, store, store ? child.text.toString() : QString()});
+        }
+        const int count = static_cast<int>(items.size());
+        engine.applyBatch(target->instanceId, std::move(items), mode != "each");
+        logLazy("Batch of %1 inputs applied via TCP", count);
+    } else if (type == "status") {
+        // The owning shard builds the report, in order with the inputs queued before it
+        QPointer<QIODevice> client(socket);
+        engine.runOn(target->instanceId, [client](MachineInstance& instance) {
+            sendStatusToClient(client, generateStatusXml(instance));
+            debugLazy("TCP: Sent status XML");
+        });
+    } else if (type == "subscribe") {
+        QString error;
+        if (!subscribeClient(socket, message, error)) {
+            debugLazy("TCP: Unknown entry '%1' in subscribe command", error);
+            sendError(ERR_UNKNOWN_SUBSCRIPTION, "Unknown event type, name or instance", socket);
+            return;
+        }
+        writeEvent(socket, "<event type=\"log\"><message>Subscription updated</message></event>");
+        log("Client " + clientAddress(socket) + " updated its subscription");
+    } else if (type == "binary") {
+        if (binaryClients.contains(socket)) {
+            return;
+        }
+        // The acknowledgement is the last line; everything after it is framed
+        queueWrite(socket, buildEvent("<event type=\"binary\" version=\"1\"/>"));
+        binaryClients.insert(socket);
+        queueWrite(socket, buildNamesFrame());
+        log("Client " + clientAddress(socket) + " switched to binary framing");
+    } else if (type == "help") {
+        QString helpMsg =
+            "<event type=\"log\"><message>Supported commands: set, call, batch, status, subscribe, reqFSM, binary, "
+            "help, disconnect, shutdown</message></event>";
+        writeEvent(socket, helpMsg);
+        debugLazy("TCP: Sent help message");
+    } else if (type == "reqFSM") {
+        QString fsmMsgLine = QString::fromUtf8(machine->xml).replace('\n', ' ').replace('\r', ' ');
+        QString fsmMsg = QString("<event type=\"fsm\"><model>%1</model></event>").arg(fsmMsgLine);
+        writeEvent(socket, fsmMsg);
+        debugLazy("TCP: FSM model XML sent to client");
+    } else if (type == "disconnect") {
+        QString disconnectMsg = "<event type=\"disconnect\"><message>Disconnecting client</message></event>";
+        writeEvent(socket, disconnectMsg);
+        flushWrites(socket);
+        disconnectClient(socket);
+        debugLazy("TCP: Client requested disconnect via socket communication");
+    } else if (type == "shutdown") {
+        broadcastShutdownEvent("Server is shutting down due to a TCP shutdown command. All clients will be "
+                               "disconnected.");
+        log("Shutdown command received via socket communication. Shutting down server.");
+        closeAndCleanupAllSockets();
+        m_shutdown();
+    } else if (type == "pong") {
+        if (awaitingPong.contains(socket)) {
+            awaitingPong.remove(socket);
+            if (pingTimers.contains(socket)) {
+                QTimer* t = pingTimers.take(socket);
+                if (t) {
+                    t->stop();
+                    t->deleteLater();
+                }
+            }
+            debugLazy("Received pong from a client.");
+        }
+    } else {
+        debugLazy("TCP: Unknown XML command received: %1", type.toString());
+        sendError(ERR_UNKNOWN_COMMAND, "Unknown command", socket);
+    }
+}
+
+void ProtocolServer::handleFrame(QIODevice* socket, quint8 type, const QByteArray& payload) {
+    if (type == FRAME_XML) {
+        handleXmlCommand(socket, payload.constData(), payload.size());
+        return;
+    }
+    if (type != FRAME_SET && type != FRAME_CALL) {
+        debugLazy("TCP: Unknown frame type %1", static_cast<int>(type));
+        sendError(ERR_UNKNOWN_COMMAND, "Unknown command", socket);
+        return;
+    }
+    QDataStream in(payload);
+    quint32 instance = 0;
+    quint16 input = 0;
+    QByteArray value;
+    in >> instance >> input;
+    if (type == FRAME_SET) {
+        in >> value;
+    }
+    if (in.status() != QDataStream::Ok) {
+        debugLazy("TCP: Truncated frame received");
+        sendError(ERR_MALFORMED_FRAME, "Malformed frame", socket);
+        return;
+    }
+    MachineInstance* target = engine.instance(static_cast<int>(instance));
+    if (!target) {
+        sendError(ERR_UNKNOWN_INSTANCE, "Unknown instance", socket);
+        return;
+    }
+    if (input >= machine->inputCount) {
+        sendError(ERR_UNKNOWN_INPUT, "Unknown input", socket);
+        return;
+    }
+    if (type == FRAME_SET) {
+        const QString text = QString::fromUtf8(value);
+        engine.setInput(target->instanceId, input, text);
+        logLazy("Input '%1' set to '%2' via TCP", machine->inputNames[input], text);
+    } else {
+        engine.callInput(target->instanceId, input);
+        logLazy("Input '%1' called via TCP", machine->inputNames[input]);
+    }
+}
+
+void ProtocolServer::pingClients() {
+    for (QIODevice* clientSocket : clientSockets) {
+        if (!awaitingPong.contains(clientSocket)) {
+            // Send ping
+            QString pingMsg = "<event type=\"ping\"/>";
+            writeEvent(clientSocket, pingMsg);
+            awaitingPong.insert(clientSocket);
+            debugLazy("Sent ping to a client.\n");
+
+            // Expect pong
+            QTimer* pongTimer = new QTimer(clientSocket);
+            pongTimer->setSingleShot(true);
+            // Handles keepalive timeout for individual clients
+            QObject::connect(pongTimer, &QTimer::timeout, [clientSocket]() {
+                debugLazy("A client timed out.");
+                QString shutdownMsg = "<event type=\"shutdown\"><message>Keepalive timeout</message></event>";
+                writeEvent(clientSocket, shutdownMsg);
+                flushWrites(clientSocket);
+                cleanupSocket(clientSocket);
+            });
+            pingTimers[clientSocket] = pongTimer;
+            pongTimer->start(10000);  // 10 s
+        }
+    }
+}
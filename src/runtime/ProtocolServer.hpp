@@ -0,0 +1,79 @@
+/**
+ * @file ProtocolServer.hpp
+ * @brief TCP and local socket server of the FSM runtime, executing the commands of the clients.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QTcpServer>
+#include <functional>
+
+/**
+ * @brief Accepts clients on TCP and local sockets and serves the command protocol.
+ *
+ * Commands arrive as XML lines, or as frames once a client switched to the binary framing. Inputs are handed to the
+ * dispatch engine; the connected clients are kept alive with a ping every 20 s.
+ */
+class ProtocolServer {
+   public:
+    /**
+     * @brief Creates a server that is not listening yet.
+     * @param shutdown Called by the shutdown command once the clients were notified and disconnected.
+     */
+    explicit ProtocolServer(std::function<void()> shutdown);
+
+    /**
+     * @brief Starts listening for clients.
+     * @param host Address of the TCP server.
+     * @param port Port of the TCP server.
+     * @param localName Name of the local socket, empty for TCP only.
+     * @return True if the TCP server listens.
+     */
+    bool listen(const QHostAddress &host, quint16 port, const QString &localName);
+
+   private:
+    /**
+     * @brief Sets up the protocol handlers of a new client, shared by TCP and local sockets.
+     * @param socket Client socket.
+     */
+    void setupClient(QIODevice *socket);
+
+    /**
+     * @brief Reads the pending commands of a client.
+     * @param socket Client socket.
+     */
+    void readClient(QIODevice *socket);
+
+    /**
+     * @brief Handles one XML command, received as a line or as a FRAME_XML frame.
+     * @param socket Client socket.
+     * @param data Command text.
+     * @param size Length of the command in bytes.
+     */
+    void handleXmlCommand(QIODevice *socket, const char *data, int size);
+
+    /**
+     * @brief Handles one frame of a client that switched to binary framing.
+     * @param socket Client socket.
+     * @param type Frame type.
+     * @param payload Frame payload.
+     */
+    void handleFrame(QIODevice *socket, quint8 type, const QByteArray &payload);
+
+    /**
+     * @brief Sends a ping to every client not already awaiting a pong (keepalive mechanism).
+     */
+    void pingClients();
+
+    QTcpServer m_server;               // TCP clients
+    QLocalServer m_localServer;        // Local socket clients, listening only with --local
+    QTimer m_pingIntervalTimer;        // Periodic keepalive pings
+    std::function<void()> m_shutdown;  // Ends the program or the embedded machine
+};
@@ -0,0 +1,54 @@
+/**
+ * @file WireFormat.hpp
+ * @brief Binary frame types and shared-memory stream layout of the FSM client protocol.
+ *
+ * The header only depends on QtCore. It is included by the FSM runtime library and by GuiClient, so both ends of
+ * the protocol agree on the frame types and the layout of the shared-memory event stream.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QtGlobal>
+#include <atomic>
+
+enum FrameType : quint8 {
+    FRAME_NAMES = 0x01,          // 4x (quint16 count, strings): states, inputs, outputs, variables
+    FRAME_STATE_CHANGE = 0x02,   // quint32 instance, quint16 state
+    FRAME_OUTPUT = 0x03,         // quint32 instance, quint16 output, string value
+    FRAME_INPUT = 0x04,          // quint32 instance, quint16 input, string value
+    FRAME_VARIABLE = 0x05,       // quint32 instance, quint16 variable, string value
+    FRAME_TIMER_START = 0x06,    // quint32 instance, quint16 from, quint16 to, quint32 ms
+    FRAME_TIMER_EXPIRED = 0x07,  // quint32 instance, quint16 from, quint16 to
+    FRAME_ERROR = 0x08,          // quint16 code, string message
+    FRAME_XML = 0x09,            // UTF-8 XML event or command, for everything without its own frame
+    FRAME_SET = 0x10,            // client: quint32 instance, quint16 input, string value
+    FRAME_CALL = 0x11,           // client: quint32 instance, quint16 input
+};
+
+constexpr quint32 MAX_FRAME_LENGTH = 16 * 1024 * 1024;  // Larger frames are treated as a broken stream
+
+/*
+ * Optional shared-memory event stream (--shm) for clients on the same machine. The segment holds a
+ * SharedRingHeader, the FRAME_NAMES frame and then the ring, to which every machine event is appended as a binary
+ * frame. writePos counts all bytes ever published, a frame starts at writePos % capacity and may wrap around the
+ * end of the ring. Readers poll writePos; one that fell more than capacity bytes behind lost events and has to
+ * resynchronize at the current writePos.
+ *
+ * The writer raises reservePos to the end of a frame before copying its bytes, like the sequence of a seqlock. A
+ * reader checks it after copying: bytes up to reservePos - capacity may have been overwritten while it copied, so
+ * if that reaches past its read position the copy is torn and it resynchronizes as well.
+ */
+struct SharedRingHeader {
+    quint32 magic;                    // SHARED_RING_MAGIC
+    quint32 version;                  // SHARED_RING_VERSION
+    quint32 capacity;                 // Bytes of the ring
+    quint32 namesSize;                // Bytes of the FRAME_NAMES frame following the header
+    std::atomic<quint64> writePos;    // Bytes published so far, stored after the frame bytes were copied
+    std::atomic<quint64> reservePos;  // End of the frame being copied, stored before its bytes are copied
+};
+
+constexpr quint32 SHARED_RING_MAGIC = 0x46534d52;  // "FSMR"
+constexpr quint32 SHARED_RING_VERSION = 2;
@@ -0,0 +1,790 @@
+/**
+ * @file WireProtocol.cpp
+ * @brief Client protocol of the FSM runtime: event encoding, per-client output queues and the shared-memory stream.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include "WireProtocol.hpp"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDataStream>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QtEndian>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QLocalSocket>
+#include <QtNetwork/QTcpSocket>
+#include <QtXml/QDomElement>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "DispatchEngine.hpp"
+
+QSet<QIODevice*> clientSockets;
+QSet<QIODevice*> binaryClients;
+QMap<QIODevice*, QTimer*> pingTimers;
+QSet<QIODevice*> awaitingPong;
+QHash<QIODevice*, ClientQueue> clientQueues;
+int flushLatencyMs = 0;
+qint64 clientQueueLimit = 1024 * 1024;
+int conflationWindowMs = 0;
+SlowClientPolicy slowClientPolicy = POLICY_COALESCE;
+
+// Pre-serialized XML pieces, each follows the event type (and instance) attribute and ends right where the dynamic
+// value goes
+static std::vector<QByteArray> stateChangeXml;
+static std::vector<QByteArray> inputXml;
+static std::vector<QByteArray> outputXml;
+static std::vector<QByteArray> variableXml;
+static std::vector<QByteArray> timerFromXml;
+static std::vector<QByteArray> timerToXml;
+
+void prepareEventTemplates() {
+    auto build = [](std::vector<QByteArray>& table, const char* const* names, int count, const char* head,
+                    const char* tail) {
+        table.clear();
+        for (int i = 0; i < count; ++i) {
+            table.push_back(head + QString::fromUtf8(names[i]).toHtmlEscaped().toUtf8() + tail);
+        }
+    };
+    build(stateChangeXml, machine->stateNames, machine->stateCount, "><name>", "</name></event>\n");
+    build(inputXml, machine->inputNames, machine->inputCount, "><name>", "</name><value>");
+    build(outputXml, machine->outputNames, machine->outputCount, "><name>", "</name><value>");
+    build(variableXml, machine->variableNames, machine->variableCount, "><name>", "</name><value>");
+    build(timerFromXml, machine->stateNames, machine->stateCount, "><from>", "</from><to>");
+    build(timerToXml, machine->stateNames, machine->stateCount, "", "</to>");
+}
+
+bool isClientConnected(QIODevice* socket) {
+    if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        return tcp->state() == QAbstractSocket::ConnectedState;
+    }
+    if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket)) {
+        return local->state() == QLocalSocket::ConnectedState;
+    }
+    return false;
+}
+
+QString clientAddress(QIODevice* socket) {
+    if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        return QString("%1:%2").arg(tcp->peerAddress().toString()).arg(tcp->peerPort());
+    }
+    if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket)) {
+        return "local:" + local->serverName();
+    }
+    return QStringLiteral("unknown");
+}
+
+/**
+ * @brief Writes as much buffered data of a client as possible without blocking.
+ * @param socket Client socket.
+ */
+static void flushClient(QIODevice* socket) {
+    if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->flush();
+    } else if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->flush();
+    }
+}
+
+void disconnectClient(QIODevice* socket) {
+    if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->disconnectFromHost();
+    } else if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->disconnectFromServer();
+    }
+}
+
+/**
+ * @brief Closes a client connection immediately, discarding pending data.
+ * @param socket Client socket.
+ */
+static void abortClient(QIODevice* socket) {
+    if (QTcpSocket* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->abort();
+    } else if (QLocalSocket* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->abort();
+    }
+}
+
+QByteArray buildEvent(const QString& eventString) { return (eventString + "\n").toUtf8(); }
+
+QByteArray buildFrame(quint8 type, const QByteArray& payload) {
+    QByteArray data(5, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size() + 1), reinterpret_cast<uchar*>(data.data()));
+    data[4] = static_cast<char>(type);
+    return data + payload;
+}
+
+void tagInstance(QDomElement& element, int instance) {
+    if (instanceCount > 1) {
+        element.setAttribute("instance", instance);
+    }
+}
+
+/**
+ * @brief Appends text to an XML event, escaping markup characters.
+ * @param xml Event being built.
+ * @param text Element text.
+ */
+static void appendEscaped(QByteArray& xml, const QString& text) {
+    const QByteArray utf8 = text.toUtf8();
+    int start = 0;
+    for (int i = 0; i < utf8.size(); ++i) {
+        const char* entity = nullptr;
+        switch (utf8[i]) {
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '&': entity = "&amp;"; break;
+            case '"': entity = "&quot;"; break;
+            default: continue;
+        }
+        xml.append(utf8.constData() + start, i - start);
+        xml.append(entity);
+        start = i + 1;
+    }
+    xml.append(utf8.constData() + start, utf8.size() - start);
+}
+
+/**
+ * @brief Encodes a machine event as an XML line.
+ *
+ * The static parts come from the pre-serialized tables, only the instance attribute and the value are appended per
+ * event.
+ *
+ * @param event Event to encode.
+ * @return The XML event including the line terminator.
+ */
+static QByteArray encodeXml(const WireEvent& event) {
+    // Indexed by frame type, FRAME_STATE_CHANGE (0x02) .. FRAME_TIMER_EXPIRED (0x07)
+    static const char* const kEventHeads[] = {
+        nullptr,
+        nullptr,
+        "<event type=\"stateChange\"",
+        "<event type=\"output\"",
+        "<event type=\"input\"",
+        "<event type=\"variable\"",
+        "<event type=\"timerStart\"",
+        "<event type=\"timerExpired\"",
+    };
+    QByteArray xml;
+    xml.reserve(128 + event.value.size());
+    xml.append(kEventHeads[event.type]);
+    if (instanceCount > 1) {
+        xml.append(" instance=\"").append(QByteArray::number(event.instance)).append('"');
+    }
+    switch (event.type) {
+        case FRAME_STATE_CHANGE:
+            xml.append(stateChangeXml[event.id]);
+            break;
+        case FRAME_OUTPUT:
+        case FRAME_INPUT:
+        case FRAME_VARIABLE:
+            xml.append(event.type == FRAME_OUTPUT  ? outputXml[event.id]
+                       : event.type == FRAME_INPUT ? inputXml[event.id]
+                                                   : variableXml[event.id]);
+            appendEscaped(xml, event.value);
+            xml.append("</value></event>\n");
+            break;
+        case FRAME_TIMER_START:
+            xml.append(timerFromXml[event.id]).append(timerToXml[event.to]);
+            xml.append("<ms>").append(QByteArray::number(event.ms)).append("</ms></event>\n");
+            break;
+        case FRAME_TIMER_EXPIRED:
+            xml.append(timerFromXml[event.id]).append(timerToXml[event.to]).append("</event>\n");
+            break;
+    }
+    return xml;
+}
+
+/**
+ * @brief Encodes a machine event as a binary frame.
+ * @param event Event to encode.
+ * @return The frame ready to send.
+ */
+static QByteArray encodeBinary(const WireEvent& event) {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << static_cast<quint32>(event.instance) << static_cast<quint16>(event.id);
+    switch (event.type) {
+        case FRAME_OUTPUT:
+        case FRAME_INPUT:
+        case FRAME_VARIABLE:
+            out << event.value.toUtf8();
+            break;
+        case FRAME_TIMER_START:
+            out << static_cast<quint16>(event.to) << static_cast<quint32>(event.ms);
+            break;
+        case FRAME_TIMER_EXPIRED:
+            out << static_cast<quint16>(event.to);
+            break;
+    }
+    return buildFrame(event.type, payload);
+}
+
+QByteArray buildNamesFrame() {
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    auto writeNames = [&out](const char* const* names, int count) {
+        out << static_cast<quint16>(count);
+        for (int i = 0; i < count; ++i) {
+            out << QByteArray(names[i]);
+        }
+    };
+    writeNames(machine->stateNames, machine->stateCount);
+    writeNames(machine->inputNames, machine->inputCount);
+    writeNames(machine->outputNames, machine->outputCount);
+    writeNames(machine->variableNames, machine->variableCount);
+    return buildFrame(FRAME_NAMES, payload);
+}
+
+static QSharedMemory* sharedRing = nullptr;  // Segment of the event stream, null without --shm
+static char* sharedRingData = nullptr;       // First byte of the ring inside the segment
+static quint32 sharedRingCapacity = 0;       // Bytes of the ring
+
+bool openSharedRing(const QString& key, quint32 capacity) {
+    const QByteArray names = buildNamesFrame();
+    const int ringOffset = (static_cast<int>(sizeof(SharedRingHeader)) + names.size() + 7) & ~7;
+    sharedRing = new QSharedMemory(key, QCoreApplication::instance());
+    if (sharedRing->attach()) {
+        // Left behind by a process that crashed, detaching the last user removes it on Unix
+        sharedRing->detach();
+    }
+    if (!sharedRing->create(ringOffset + static_cast<int>(capacity))) {
+        log("Could not create shared memory segment '" + key + "': " + sharedRing->errorString());
+        delete sharedRing;
+        sharedRing = nullptr;
+        return false;
+    }
+    char* base = static_cast<char*>(sharedRing->data());
+    SharedRingHeader* header = new (base) SharedRingHeader;
+    header->magic = SHARED_RING_MAGIC;
+    header->version = SHARED_RING_VERSION;
+    header->capacity = capacity;
+    header->namesSize = static_cast<quint32>(names.size());
+    header->writePos.store(0, std::memory_order_relaxed);
+    header->reservePos.store(0, std::memory_order_relaxed);
+    std::memcpy(base + sizeof(SharedRingHeader), names.constData(), names.size());
+    sharedRingData = base + ringOffset;
+    sharedRingCapacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Appends a frame to the shared-memory event stream.
+ *
+ * Only the main thread publishes, so the ring has a single writer and needs no lock; readers see the frame once
+ * writePos is released. reservePos is raised before the bytes are copied, so readers can tell a torn copy.
+ *
+ * @param frame Binary frame.
+ */
+static void publishShared(const QByteArray& frame) {
+    if (!sharedRing || static_cast<quint32>(frame.size()) > sharedRingCapacity) {
+        return;
+    }
+    SharedRingHeader* header = static_cast<SharedRingHeader*>(sharedRing->data());
+    const quint64 pos = header->writePos.load(std::memory_order_relaxed);
+    const quint32 start = static_cast<quint32>(pos % sharedRingCapacity);
+    const quint32 first = qMin(static_cast<quint32>(frame.size()), sharedRingCapacity - start);
+    header->reservePos.store(pos + frame.size(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(sharedRingData + start, frame.constData(), first);
+    std::memcpy(sharedRingData, frame.constData() + first, frame.size() - first);
+    header->writePos.store(pos + frame.size(), std::memory_order_release);
+}
+
+static QTimer* flushTimer = nullptr;            // Flush point, at most flushLatencyMs after the first event
+constexpr int FLUSH_THRESHOLD = 64 * 1024;      // Buffered bytes that make a client flush early
+static quint64 slowClientsDisconnected = 0;     // Clients closed by POLICY_DISCONNECT
+
+/**
+ * @brief Gets the name of the slow-client policy as used on the command line and in status reports.
+ * @return "drop", "coalesce" or "disconnect".
+ */
+static QString slowClientPolicyName() {
+    switch (slowClientPolicy) {
+        case POLICY_DROP_OLDEST: return QStringLiteral("drop");
+        case POLICY_DISCONNECT: return QStringLiteral("disconnect");
+        default: return QStringLiteral("coalesce");
+    }
+}
+
+/**
+ * @brief Removes dropped and superseded messages from the front of a queue.
+ * @param queue Client queue.
+ */
+static void trimQueue(ClientQueue& queue) {
+    while (!queue.messages.empty() && queue.messages.front().data.isEmpty()) {
+        queue.messages.pop_front();
+        ++queue.firstSeq;
+    }
+}
+
+void flushWrites(QIODevice* socket) {
+    auto it = clientQueues.find(socket);
+    if (it == clientQueues.end() || it.value().messages.empty()) {
+        return;
+    }
+    ClientQueue& queue = it.value();
+    if (queue.closing || !isClientConnected(socket)) {
+        queue.messages.clear();
+        queue.latest.clear();
+        queue.bytes = 0;
+        return;
+    }
+    if (socket->bytesToWrite() >= clientQueueLimit) {
+        // Held back until bytesWritten reports progress
+        queue.congested = true;
+        return;
+    }
+    QByteArray batch;
+    batch.reserve(static_cast<int>(queue.bytes));
+    for (const ClientQueue::Message& message : queue.messages) {
+        if (!message.data.isEmpty()) {
+            batch.append(message.data);
+            ++queue.sent;
+        }
+    }
+    queue.firstSeq += queue.messages.size();
+    queue.messages.clear();
+    queue.latest.clear();
+    queue.bytes = 0;
+    queue.congested = false;
+    socket->write(batch);
+    flushClient(socket);
+}
+
+void flushWrites() {
+    for (auto it = clientQueues.begin(); it != clientQueues.end(); ++it) {
+        flushWrites(it.key());
+    }
+}
+
+/**
+ * @brief Applies the slow-client policy to a client whose queue and socket buffer exceed the limit.
+ * @param socket Client socket.
+ * @param queue Queue of the client.
+ */
+static void relieveClient(QIODevice* socket, ClientQueue& queue) {
+    if (slowClientPolicy == POLICY_DISCONNECT) {
+        queue.closing = true;
+        queue.dropped += queue.messages.size();
+        queue.messages.clear();
+        queue.latest.clear();
+        queue.bytes = 0;
+        ++slowClientsDisconnected;
+        log(COLOR_WARNING + "Disconnecting slow client " + clientAddress(socket) + ANSI_RESET);
+        // Aborting here would clean the socket up while a broadcast iterates the clients
+        QPointer<QIODevice> client(socket);
+        QTimer::singleShot(0, QCoreApplication::instance(), [client]() {
+            if (client) {
+                abortClient(client);
+            }
+        });
+        return;
+    }
+    // Drop the oldest events, replies and protocol messages are kept
+    for (ClientQueue::Message& message : queue.messages) {
+        if (queue.bytes + socket->bytesToWrite() <= clientQueueLimit) {
+            break;
+        }
+        if (message.key == KEY_CONTROL || message.data.isEmpty()) {
+            continue;
+        }
+        queue.bytes -= message.data.size();
+        message.data.clear();
+        ++queue.dropped;
+    }
+    trimQueue(queue);
+}
+
+void queueWrite(QIODevice* socket, const QByteArray& data, quint64 key) {
+    ClientQueue& queue = clientQueues[socket];
+    if (queue.closing) {
+        return;
+    }
+    const quint64 seq = queue.firstSeq + queue.messages.size();
+    if (key > KEY_CONTROL && queue.congested && slowClientPolicy == POLICY_COALESCE) {
+        // Only the latest value of a state, input, output or variable matters to a client that lags behind
+        auto previous = queue.latest.find(key);
+        if (previous != queue.latest.end() && previous.value() >= queue.firstSeq) {
+            ClientQueue::Message& superseded = queue.messages[previous.value() - queue.firstSeq];
+            if (!superseded.data.isEmpty()) {
+                queue.bytes -= superseded.data.size();
+                superseded.data.clear();
+                ++queue.coalesced;
+            }
+        }
+        queue.latest.insert(key, seq);
+    }
+    queue.messages.push_back(ClientQueue::Message{data, key});
+    queue.bytes += data.size();
+    trimQueue(queue);
+    if (queue.bytes + socket->bytesToWrite() > clientQueueLimit) {
+        relieveClient(socket, queue);
+        if (queue.closing) {
+            return;
+        }
+    }
+    if (queue.bytes >= FLUSH_THRESHOLD && !queue.congested) {
+        flushWrites(socket);
+        return;
+    }
+    if (!flushTimer) {
+        flushTimer = new QTimer(QCoreApplication::instance());
+        flushTimer->setSingleShot(true);
+        flushTimer->setTimerType(Qt::PreciseTimer);
+        QObject::connect(flushTimer, &QTimer::timeout, []() { flushWrites(); });
+    }
+    if (!flushTimer->isActive()) {
+        flushTimer->start(flushLatencyMs);
+    }
+}
+
+// Union of the event types any client subscribed to, read by the executor threads
+static std::atomic<quint32> wantedEventTypes{0};
+
+void updateWantedEvents() {
+    quint32 types = 0;
+    for (const ClientQueue& queue : clientQueues) {
+        types |= queue.subscription.types;
+    }
+    if (sharedRing) {
+        // The shared-memory stream carries every event
+        types = ~0u;
+    }
+    wantedEventTypes.store(types, std::memory_order_relaxed);
+}
+
+void watchClient(QIODevice* socket) {
+    clientQueues.insert(socket, ClientQueue());
+    updateWantedEvents();
+    QObject::connect(socket, &QIODevice::bytesWritten, [socket]() {
+        auto it = clientQueues.find(socket);
+        if (it != clientQueues.end() && it.value().congested && socket->bytesToWrite() < clientQueueLimit) {
+            flushWrites(socket);
+        }
+    });
+}
+
+static std::vector<WireEvent> conflatedEvents;  // Latest output/variable values of the current window, first-seen order
+static QHash<quint64, int> conflatedSlots;      // eventKey -> index in conflatedEvents
+static QTimer* conflationTimer = nullptr;       // Ends the conflation window
+static quint64 conflatedCount = 0;              // Output/variable events replaced by a newer value
+
+/**
+ * @brief Builds the backpressure counters of all clients for the status report.
+ * @return The clients element.
+ */
+static QString clientStatsXml() {
+    QString xml = QString("<clients policy=\"%1\" limit=\"%2\" disconnected=\"%3\" conflate=\"%4\" "
+                          "conflated=\"%5\">")
+                      .arg(slowClientPolicyName())
+                      .arg(clientQueueLimit)
+                      .arg(slowClientsDisconnected)
+                      .arg(conflationWindowMs)
+                      .arg(conflatedCount);
+    for (auto it = clientQueues.constBegin(); it != clientQueues.constEnd(); ++it) {
+        QIODevice* socket = it.key();
+        const ClientQueue& queue = it.value();
+        xml += QString("<client address=\"%1\" framing=\"%2\" queued=\"%3\" sent=\"%4\" dropped=\"%5\" "
+                       "coalesced=\"%6\"/>")
+                   .arg(clientAddress(socket).toHtmlEscaped())
+                   .arg(binaryClients.contains(socket) ? "binary" : "xml")
+                   .arg(queue.bytes + socket->bytesToWrite())
+                   .arg(queue.sent)
+                   .arg(queue.dropped)
+                   .arg(queue.coalesced);
+    }
+    return xml + "</clients>";
+}
+
+/**
+ * @brief Checks whether the caller runs on the main thread, which owns the client sockets.
+ * @return True on the main thread.
+ */
+static bool onMainThread() { return QThread::currentThread() == QCoreApplication::instance()->thread(); }
+
+// Socket work requested by an executor thread, handed to the main thread at the thread's flush point
+static thread_local std::vector<std::function<void()>> pendingMainCalls;
+
+// Socket work handed over by the executor threads, in handover order
+static QMutex mainCallsMutex;
+static std::vector<std::function<void()>> mainCalls;
+
+void postToMainThread(std::function<void()> call) { pendingMainCalls.push_back(std::move(call)); }
+
+void flushMainThreadCalls() {
+    if (pendingMainCalls.empty()) {
+        return;
+    }
+    bool wake = false;
+    {
+        QMutexLocker lock(&mainCallsMutex);
+        // A run is already scheduled while earlier calls are waiting
+        wake = mainCalls.empty();
+        for (std::function<void()>& call : pendingMainCalls) {
+            mainCalls.push_back(std::move(call));
+        }
+    }
+    pendingMainCalls.clear();
+    if (wake) {
+        QTimer::singleShot(0, QCoreApplication::instance(), []() { runMainThreadCalls(); });
+    }
+}
+
+void runMainThreadCalls() {
+    std::vector<std::function<void()>> calls;
+    {
+        QMutexLocker lock(&mainCallsMutex);
+        calls.swap(mainCalls);
+    }
+    for (const std::function<void()>& call : calls) {
+        call();
+    }
+}
+
+/**
+ * @brief Computes the key under which newer events replace older ones.
+ * @param event Machine event.
+ * @return One key per instance for state changes, per instance and name for value events, KEY_NONE for timers.
+ */
+static quint64 eventKey(const WireEvent& event) {
+    if (event.type == FRAME_TIMER_START || event.type == FRAME_TIMER_EXPIRED) {
+        return KEY_NONE;
+    }
+    const quint64 id = event.type == FRAME_STATE_CHANGE ? 0 : static_cast<quint64>(event.id);
+    return (static_cast<quint64>(event.type) << 56) | (static_cast<quint64>(event.instance) << 16) | id;
+}
+
+/**
+ * @brief Encodes a machine event and queues it for every subscribed client.
+ *
+ * Each encoding is built at most once and only if a subscribed client or the shared-memory stream uses it.
+ *
+ * @param event Event to send.
+ */
+static void deliverEvent(const WireEvent& event) {
+    QByteArray xml;
+    QByteArray binary;
+    const quint64 key = eventKey(event);
+    if (sharedRing) {
+        binary = encodeBinary(event);
+        publishShared(binary);
+    }
+    for (auto it = clientQueues.begin(); it != clientQueues.end(); ++it) {
+        QIODevice* clientSocket = it.key();
+        if (!isClientConnected(clientSocket) || !it.value().subscription.wants(event.type, event.instance, event.id)) {
+            continue;
+        }
+        if (binaryClients.contains(clientSocket)) {
+            if (binary.isEmpty()) {
+                binary = encodeBinary(event);
+            }
+            queueWrite(clientSocket, binary, key);
+        } else {
+            if (xml.isEmpty()) {
+                xml = encodeXml(event);
+            }
+            queueWrite(clientSocket, xml, key);
+        }
+    }
+}
+
+void flushConflatedEvents() {
+    std::vector<WireEvent> events;
+    events.swap(conflatedEvents);
+    conflatedSlots.clear();
+    for (const WireEvent& event : events) {
+        deliverEvent(event);
+    }
+}
+
+/**
+ * @brief Holds an output or variable event until the end of the conflation window.
+ *
+ * A newer value of the same output or variable of the same instance replaces the held one in place, so only the
+ * latest value of every name is sent once per window.
+ *
+ * @param event Output or variable event.
+ */
+static void conflateEvent(const WireEvent& event) {
+    const quint64 key = eventKey(event);
+    auto slot = conflatedSlots.find(key);
+    if (slot != conflatedSlots.end()) {
+        conflatedEvents[slot.value()] = event;
+        ++conflatedCount;
+        return;
+    }
+    conflatedSlots.insert(key, static_cast<int>(conflatedEvents.size()));
+    conflatedEvents.push_back(event);
+    if (!conflationTimer) {
+        conflationTimer = new QTimer(QCoreApplication::instance());
+        conflationTimer->setSingleShot(true);
+        conflationTimer->setTimerType(Qt::PreciseTimer);
+        QObject::connect(conflationTimer, &QTimer::timeout, []() { flushConflatedEvents(); });
+    }
+    if (!conflationTimer->isActive()) {
+        conflationTimer->start(conflationWindowMs);
+    }
+}
+
+void broadcastEvent(const WireEvent& event) {
+    if (!(wantedEventTypes.load(std::memory_order_relaxed) & (1u << event.type))) {
+        // Nobody subscribed, not even worth a trip to the main thread
+        return;
+    }
+    if (!onMainThread()) {
+        postToMainThread([event]() { broadcastEvent(event); });
+        return;
+    }
+    if (conflationWindowMs > 0 && (event.type == FRAME_OUTPUT || event.type == FRAME_VARIABLE)) {
+        conflateEvent(event);
+        return;
+    }
+    deliverEvent(event);
+}
+
+void writeEvent(QIODevice* socket, const QString& event) {
+    queueWrite(socket, binaryClients.contains(socket) ? buildFrame(FRAME_XML, event.toUtf8()) : buildEvent(event));
+}
+
+void sendToClient(QPointer<QIODevice> socket, const QString& event) {
+    if (!onMainThread()) {
+        postToMainThread([socket, event]() { sendToClient(socket, event); });
+        return;
+    }
+    if (socket && isClientConnected(socket)) {
+        writeEvent(socket, event);
+    }
+}
+
+void sendStatusToClient(QPointer<QIODevice> socket, const QString& status) {
+    if (!onMainThread()) {
+        postToMainThread([socket, status]() { sendStatusToClient(socket, status); });
+        return;
+    }
+    QString report = status;
+    const int end = report.lastIndexOf("</status>");
+    if (end >= 0) {
+        report.insert(end, clientStatsXml());
+    }
+    sendToClient(socket, report);
+}
+
+void sendError(int code, const QString& msg, QIODevice* socket) {
+    if (!socket) return;
+    if (binaryClients.contains(socket)) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out << static_cast<quint16>(code) << msg.toUtf8();
+        queueWrite(socket, buildFrame(FRAME_ERROR, payload));
+        return;
+    }
+    QString error = QString("<event type=\"error\"><code>%1</code><message>%2</message></event>")
+                        .arg(code)
+                        .arg(msg.toHtmlEscaped());
+    queueWrite(socket, buildEvent(error));
+}
+
+void broadcastShutdownEvent(const QString& message) {
+    const QString shutdownMsg = QString("<event type=\"shutdown\"><message>%1</message></event>").arg(message);
+    for (QIODevice* clientSocket : clientSockets) {
+        if (isClientConnected(clientSocket)) {
+            writeEvent(clientSocket, shutdownMsg);
+        }
+    }
+    publishShared(buildFrame(FRAME_XML, shutdownMsg.toUtf8()));
+    flushWrites();
+}
+
+/**
+ * @brief Maps a subscription name set of the previous machine onto the names of the current one.
+ * @param wanted Name set indexed by the previous machine, empty for all.
+ * @param oldNames Names of the previous machine.
+ * @param oldCount Number of previous names.
+ * @param newNames Names of the current machine.
+ * @param newCount Number of current names.
+ */
+static void remapNames(QVector<bool>& wanted, const char* const* oldNames, int oldCount, const char* const* newNames,
+                       int newCount) {
+    if (wanted.isEmpty()) {
+        return;
+    }
+    QSet<QByteArray> names;
+    for (int i = 0; i < oldCount; ++i) {
+        if (wanted.value(i)) {
+            names.insert(QByteArray(oldNames[i]));
+        }
+    }
+    QVector<bool> remapped(newCount, false);
+    for (int i = 0; i < newCount; ++i) {
+        remapped[i] = names.contains(QByteArray(newNames[i]));
+    }
+    wanted = remapped;
+}
+
+void announceMachineReload(const MachineDefinition& previous, const QString& source) {
+    const QByteArray names = buildNamesFrame();
+    const QString notice = QString("<event type=\"log\"><message>Machine logic reloaded from %1</message></event>")
+                               .arg(source.toHtmlEscaped());
+    for (auto it = clientQueues.begin(); it != clientQueues.end(); ++it) {
+        QIODevice* clientSocket = it.key();
+        ClientQueue& queue = it.value();
+        Subscription& subscription = queue.subscription;
+        remapNames(subscription.inputs, previous.inputNames, previous.inputCount, machine->inputNames,
+                   machine->inputCount);
+        remapNames(subscription.outputs, previous.outputNames, previous.outputCount, machine->outputNames,
+                   machine->outputCount);
+        remapNames(subscription.variables, previous.variableNames, previous.variableCount, machine->variableNames,
+                   machine->variableCount);
+        // The coalescing keys of the queued events hold indices of the previous machine
+        queue.latest.clear();
+        if (!isClientConnected(clientSocket)) {
+            continue;
+        }
+        if (binaryClients.contains(clientSocket)) {
+            queueWrite(clientSocket, names);
+        }
+        writeEvent(clientSocket, notice);
+    }
+    publishShared(names);
+    flushWrites();
+}
+
+void cleanupSocket(QIODevice* socket) {
+    if (!socket) {
+        return;
+    }
+    debugLazy("cleanupSocket: removing and deleting socket %1", reinterpret_cast<quintptr>(socket));
+    clientSockets.remove(socket);
+    awaitingPong.remove(socket);
+    binaryClients.remove(socket);
+    clientQueues.remove(socket);
+    updateWantedEvents();
+    if (pingTimers.contains(socket)) {
+        QTimer* t = pingTimers.take(socket);
+        if (t) {
+            t->stop();
+            t->deleteLater();
+        }
+    }
+    socket->deleteLater();
+}
+
+void closeAndCleanupAllSockets() {
+    flushConflatedEvents();
+    flushWrites();
+    auto socketsCopy = clientSockets;
+    for (QIODevice* socket : socketsCopy) {
+        cleanupSocket(socket);
+    }
+    clientSockets.clear();
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
+}
@@ -0,0 +1,348 @@
+/**
+ * @file WireProtocol.hpp
+ * @brief Client protocol of the FSM runtime: event encoding, per-client output queues and the shared-memory stream.
+ *
+ * Clients talk XML lines by default. After a <command type="binary"/> line the server answers with
+ * <event type="binary" version="1"/>, sends a FRAME_NAMES frame and then uses binary frames in both directions:
+ * [quint32 length][quint8 type][payload], big-endian, length counting type and payload. Names are sent as dense
+ * indices; strings are a quint32 length followed by UTF-8 bytes. A later FRAME_NAMES frame, sent when the machine
+ * logic was reloaded, replaces the table.
+ *
+ * Clients connect over TCP (QTcpSocket) or, when started with --local, over a local socket (QLocalSocket, a Unix
+ * domain socket). Both are handled as QIODevice.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QIODevice>
+#include <QtCore/QMap>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+#include "WireFormat.hpp"
+
+class QDomElement;
+class QTimer;
+struct MachineDefinition;
+
+// Error codes for TCP XML protocol
+enum FsmErrorCode {
+    ERR_UNKNOWN_INPUT = 21,
+    ERR_UNKNOWN_INSTANCE = 22,
+    ERR_UNKNOWN_SUBSCRIPTION = 23,
+    ERR_UNKNOWN_COMMAND = 10,
+    ERR_MALFORMED_XML = 11,
+    ERR_MALFORMED_FRAME = 12,
+    ERR_INTERNAL = 99,
+};
+
+/**
+ * @brief Machine event sent to clients, encoded per client in XML or binary form.
+ */
+struct WireEvent {
+    quint8 type;     // FRAME_STATE_CHANGE .. FRAME_TIMER_EXPIRED
+    int instance;    // Instance (instanceId) the event belongs to
+    int id;          // State, output, input or variable index; source state of timer events
+    int to;          // Target state of timer events
+    int ms;          // Delay of timerStart events
+    QString value;   // Value of output, input and variable events
+};
+
+/*
+ * Outgoing data is queued per client and written at flush points. A client whose socket does not drain
+ * (bytesToWrite() above clientQueueLimit) keeps its events in the queue; once queue and socket buffer together
+ * exceed the limit, the slow-client policy decides what happens to them.
+ */
+enum SlowClientPolicy { POLICY_DROP_OLDEST, POLICY_COALESCE, POLICY_DISCONNECT };
+
+constexpr quint64 KEY_NONE = 0;     // Event that is never coalesced, may be dropped
+constexpr quint64 KEY_CONTROL = 1;  // Reply or protocol message, never dropped or coalesced
+
+/**
+ * @brief Event filter of one client, set with the subscribe command.
+ *
+ * Event types are bits indexed by frame type. The name sets only restrict input, output and variable events, an
+ * empty set lets every name through.
+ */
+struct Subscription {
+    quint32 types = ~0u;      // Bit (1 << FRAME_x) per wanted event type
+    int instance = -1;        // Only events of this instance, -1 for all
+    QVector<bool> inputs;     // Wanted inputs, empty for all
+    QVector<bool> outputs;    // Wanted outputs, empty for all
+    QVector<bool> variables;  // Wanted variables, empty for all
+    bool byName = false;      // Whether the name sets apply
+
+    /**
+     * @brief Checks whether the client wants an event.
+     * @param type Frame type of the event.
+     * @param instance Instance the event belongs to.
+     * @param id Input, output or variable index of value events.
+     * @return True if the event has to be sent.
+     */
+    bool wants(quint8 type, int instance, int id) const {
+        if (!(types & (1u << type)) || (this->instance >= 0 && this->instance != instance)) {
+            return false;
+        }
+        if (!byName) {
+            return true;
+        }
+        switch (type) {
+            case FRAME_INPUT: return inputs.value(id);
+            case FRAME_OUTPUT: return outputs.value(id);
+            case FRAME_VARIABLE: return variables.value(id);
+            default: return true;
+        }
+    }
+};
+
+/**
+ * @brief Output queue, backpressure counters and subscription of one client.
+ */
+struct ClientQueue {
+    struct Message {
+        QByteArray data;  // Encoded message, empty once dropped or superseded
+        quint64 key;      // Coalescing key, KEY_NONE or KEY_CONTROL
+    };
+    std::deque<Message> messages;    // Messages waiting for the next flush point
+    quint64 firstSeq = 0;            // Sequence number of messages.front()
+    QHash<quint64, quint64> latest;  // Coalescing key -> sequence number of its queued message
+    qint64 bytes = 0;                // Bytes held in messages
+    bool congested = false;          // Socket did not drain, messages are held back
+    bool closing = false;            // Disconnected by the slow-client policy
+    quint64 sent = 0;                // Messages written to the socket
+    quint64 dropped = 0;             // Messages dropped because the client was too slow
+    quint64 coalesced = 0;           // Messages replaced by a newer value while held back
+    Subscription subscription;       // Events the client asked for
+};
+
+extern QSet<QIODevice *> clientSockets;               // TCP and local sockets of the connected clients
+extern QSet<QIODevice *> binaryClients;               // Clients that negotiated the binary framing
+extern QMap<QIODevice *, QTimer *> pingTimers;        // Tracks pingpong keepalive timers per client
+extern QSet<QIODevice *> awaitingPong;                // Tracks clients waiting for pong
+extern QHash<QIODevice *, ClientQueue> clientQueues;  // Output queues of the connected clients
+extern int flushLatencyMs;                            // Longest wait of an outgoing batch (--flush-latency)
+extern qint64 clientQueueLimit;                       // Outstanding bytes per client (--client-queue-limit)
+extern int conflationWindowMs;                        // Latest-value window of outputs/variables (--conflate)
+extern SlowClientPolicy slowClientPolicy;             // What happens to clients over the limit (--slow-client)
+
+/**
+ * @brief Builds the pre-serialized XML pieces of the events of the hosted machine.
+ *
+ * One piece per state, input, output and variable name, so an event is assembled by appending the instance
+ * attribute and the value instead of building a DOM.
+ */
+void prepareEventTemplates();
+
+/**
+ * @brief Checks whether a client socket is still connected.
+ * @param socket Client socket.
+ * @return True for a connected TCP or local socket.
+ */
+bool isClientConnected(QIODevice *socket);
+
+/**
+ * @brief Describes a client for logs and status reports.
+ * @param socket Client socket.
+ * @return "address:port" of a TCP client, "local:name" of a local client.
+ */
+QString clientAddress(QIODevice *socket);
+
+/**
+ * @brief Closes a client connection after its pending data was written.
+ * @param socket Client socket.
+ */
+void disconnectClient(QIODevice *socket);
+
+/**
+ * @brief Builds a QByteArray needed for the TCP communication.
+ * @param eventString The event as a QString (XML or plain text).
+ * @return QByteArray ready to send via TCP.
+ */
+QByteArray buildEvent(const QString &eventString);
+
+/**
+ * @brief Wraps a payload into a binary frame.
+ * @param type Frame type.
+ * @param payload Frame payload.
+ * @return The frame ready to send.
+ */
+QByteArray buildFrame(quint8 type, const QByteArray &payload);
+
+/**
+ * @brief Marks an event with the instance it belongs to.
+ *
+ * The attribute is only added when more than one instance is hosted, single instance programs keep the original
+ * protocol.
+ *
+ * @param element Event element.
+ * @param instance Instance (instanceId) the event belongs to.
+ */
+void tagInstance(QDomElement &element, int instance);
+
+/**
+ * @brief Builds the name table sent after switching a client to binary framing.
+ * @return The FRAME_NAMES frame.
+ */
+QByteArray buildNamesFrame();
+
+/**
+ * @brief Creates the shared-memory segment of the event stream (--shm).
+ *
+ * The segment holds a header, the FRAME_NAMES frame and then a ring to which every machine event is appended as a
+ * binary frame, for clients on the same machine.
+ *
+ * @param key Key of the segment, as passed to QSharedMemory by the readers.
+ * @param capacity Bytes of the ring.
+ * @return True if the segment was created.
+ */
+bool openSharedRing(const QString &key, quint32 capacity);
+
+/**
+ * @brief Writes the pending messages of one client to its socket, unless the socket is backed up.
+ * @param socket Client socket.
+ */
+void flushWrites(QIODevice *socket);
+
+/**
+ * @brief Writes the pending messages of all clients, one write per client.
+ */
+void flushWrites();
+
+/**
+ * @brief Queues data for a client until the next flush point.
+ *
+ * Everything a client receives goes through this queue, so the events of one state entry (state change, outputs,
+ * variable changes) leave in a single write. The flush point is the end of the current event loop iteration, or
+ * flushLatencyMs later if a latency bound was configured.
+ *
+ * @param socket Client socket.
+ * @param data Encoded message.
+ * @param key Coalescing key of a value event, KEY_NONE for other events or KEY_CONTROL for replies.
+ */
+void queueWrite(QIODevice *socket, const QByteArray &data, quint64 key = KEY_CONTROL);
+
+/**
+ * @brief Recomputes the union of the event types the clients subscribed to.
+ */
+void updateWantedEvents();
+
+/**
+ * @brief Starts tracking the output queue of a new client.
+ *
+ * Held back messages are written as soon as the socket reports that its buffer drained.
+ *
+ * @param socket Client socket.
+ */
+void watchClient(QIODevice *socket);
+
+/**
+ * @brief Defers socket work of an executor thread to the main thread.
+ *
+ * The calls are collected and posted together by flushMainThreadCalls(), which the shards run after every drained
+ * batch of tasks and every timer expiry.
+ *
+ * @param call Work to run on the main thread.
+ */
+void postToMainThread(std::function<void()> call);
+
+/**
+ * @brief Posts the socket work collected by the calling executor thread to the main thread in one event.
+ */
+void flushMainThreadCalls();
+
+/**
+ * @brief Runs the socket work the executor threads handed over so far, on the main thread.
+ *
+ * Normally called from the event posted by flushMainThreadCalls(); a reload calls it directly so no event of the
+ * previous machine is sent after the swap.
+ */
+void runMainThreadCalls();
+
+/**
+ * @brief Sends the values collected in the conflation window.
+ */
+void flushConflatedEvents();
+
+/**
+ * @brief Sends a machine event to every subscribed client.
+ *
+ * Calls from executor threads are forwarded to the main thread, events of one thread keep their order. With a
+ * conflation window (--conflate) output and variable events are reduced to the latest value per name and window;
+ * they may then arrive after state changes that happened later, which are never held back.
+ *
+ * @param event Event to send.
+ */
+void broadcastEvent(const WireEvent &event);
+
+/**
+ * @brief Writes an XML event to a client in the framing the client negotiated.
+ * @param socket Client socket.
+ * @param event The XML event as a QString.
+ */
+void writeEvent(QIODevice *socket, const QString &event);
+
+/**
+ * @brief Sends an XML event to one client.
+ *
+ * Calls from executor threads are forwarded to the main thread; the event is dropped if the client disconnected in
+ * the meantime.
+ *
+ * @param socket Client socket.
+ * @param event The XML event as a QString.
+ */
+void sendToClient(QPointer<QIODevice> socket, const QString &event);
+
+/**
+ * @brief Sends a status report to one client, completed with the client counters on the main thread.
+ * @param socket Client socket.
+ * @param status Status event built by the shard owning the instance.
+ */
+void sendStatusToClient(QPointer<QIODevice> socket, const QString &status);
+
+/**
+ * @brief Sends an error response to the client.
+ * @param code Error code.
+ * @param msg Error message.
+ * @param socket Client socket to send the error to.
+ */
+void sendError(int code, const QString &msg, QIODevice *socket);
+
+/**
+ * @brief Broadcasts a shutdown event to all connected clients.
+ * @param message Optional shutdown message.
+ */
+void broadcastShutdownEvent(const QString &message =
+                                "Server is shutting down. All client connections will be closed. Please save your "
+                                "work and reconnect later.");
+
+/**
+ * @brief Tells the clients that the machine logic was swapped by a reload.
+ *
+ * Name subscriptions are carried over by name, binary clients and the shared-memory stream get the new FRAME_NAMES
+ * table and XML clients a log event.
+ *
+ * @param previous The machine that was replaced, still valid during the call.
+ * @param source Where the new logic was loaded from.
+ */
+void announceMachineReload(const MachineDefinition &previous, const QString &source);
+
+/**
+ * @brief Forgets a client and deletes its socket.
+ * @param socket Client socket.
+ */
+void cleanupSocket(QIODevice *socket);
+
+/**
+ * @brief Sends the held back events and closes every client connection.
+ */
+void closeAndCleanupAllSockets();
@@ -0,0 +1,394 @@
+/**
+ * @file XmlMessageReader.hpp
+ * @brief Streaming reader for the one-line XML messages of the FSM client protocol.
+ *
+ * The header only depends on QtCore. It is compiled into GuiClient and into the FSM runtime library linked by every
+ * generated FSM program, so both ends of the protocol share one parser.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+#include <QtCore/QString>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief View of a piece of a message line, valid until the next line is read.
+ */
+struct XmlSlice {
+    const char *data = nullptr;
+    int size = 0;
+
+    /**
+     * @brief Check whether the slice refers to anything, an empty attribute is not null.
+     * @return True if the attribute or element was not present.
+     */
+    bool isNull() const { return data == nullptr; }
+
+    /**
+     * @brief Compare the raw slice with a string literal without allocating.
+     * @param text Null-terminated string to compare with.
+     * @return True if the contents are equal.
+     */
+    bool operator==(const char *text) const {
+        const size_t length = std::strlen(text);
+        return data && static_cast<size_t>(size) == length && std::memcmp(data, text, length) == 0;
+    }
+    bool operator!=(const char *text) const { return !(*this == text); }
+
+    /**
+     * @brief Check whether the slice contains an entity or character reference.
+     * @return True if toString() has to decode the contents.
+     */
+    bool isEscaped() const { return data && std::memchr(data, '&', static_cast<size_t>(size)) != nullptr; }
+
+    /**
+     * @brief Strip leading and trailing whitespace without copying.
+     * @return A view of the trimmed contents.
+     */
+    XmlSlice trimmed() const {
+        XmlSlice result = *this;
+        while (result.size > 0 && static_cast<unsigned char>(result.data[0]) <= ' ') {
+            ++result.data;
+            --result.size;
+        }
+        while (result.size > 0 && static_cast<unsigned char>(result.data[result.size - 1]) <= ' ') --result.size;
+        return result;
+    }
+
+    /**
+     * @brief Wrap the raw contents into a QByteArray without copying them.
+     * @return A QByteArray sharing the line buffer, valid as long as the slice.
+     */
+    QByteArray toRawData() const { return QByteArray::fromRawData(data, size); }
+
+    /**
+     * @brief Convert the slice to a QString, decoding XML entities.
+     * @return The decoded text.
+     */
+    QString toString() const {
+        if (!isEscaped()) {
+            return QString::fromUtf8(data, size);
+        }
+        QByteArray decoded;
+        decoded.reserve(size);
+        for (int i = 0; i < size; ++i) {
+            const char c = data[i];
+            if (c != '&') {
+                decoded.append(c);
+                continue;
+            }
+            const char *end = static_cast<const char *>(std::memchr(data + i, ';', static_cast<size_t>(size - i)));
+            if (!end) {
+                decoded.append(data + i, size - i);
+                break;
+            }
+            const QByteArray entity = QByteArray::fromRawData(data + i + 1, static_cast<int>(end - data) - i - 1);
+            if (entity == "lt") {
+                decoded.append('<');
+            } else if (entity == "gt") {
+                decoded.append('>');
+            } else if (entity == "amp") {
+                decoded.append('&');
+            } else if (entity == "quot") {
+                decoded.append('"');
+            } else if (entity == "apos") {
+                decoded.append('\'');
+            } else if (entity.startsWith('#')) {
+                bool ok = false;
+                const uint code = entity.startsWith("#x") ? entity.mid(2).toUInt(&ok, 16) : entity.mid(1).toUInt(&ok);
+                if (ok) {
+                    decoded.append(QString::fromUcs4(&code, 1).toUtf8());
+                }
+            } else {
+                decoded.append(data + i, static_cast<int>(end - data) - i + 1);
+            }
+            i = static_cast<int>(end - data);
+        }
+        return QString::fromUtf8(decoded);
+    }
+
+    /**
+     * @brief Convert the slice to an integer.
+     * @param ok Set to false if the slice is not a number.
+     * @return The number, 0 on failure.
+     */
+    int toInt(bool *ok = nullptr) const { return toRawData().toInt(ok); }
+};
+
+/**
+ * @brief One parsed protocol message: a root element with attributes and text-only children.
+ *
+ * Parsing does not allocate once the child list has grown to the largest message seen; the message stores views into
+ * the line it was parsed from. Messages with nested child
+ * elements (status reports, the FSM model) are recognised but their children are not split, isFlat() returns false
+ * and the caller falls back to a DOM parser for those rare messages.
+ */
+class XmlMessage {
+   public:
+    static constexpr int MAX_ATTRIBUTES = 8;
+
+    /**
+     * @brief Text-only child element of the root element.
+     */
+    struct Child {
+        XmlSlice tag;   // Element name
+        XmlSlice name;  // Value of its "name" attribute, null if missing
+        XmlSlice text;  // Element text
+    };
+
+    /**
+     * @brief Parse a single message.
+     * @param data Message text, a line without the terminator.
+     * @param size Length of the text in bytes.
+     * @return False if the text is not a well-formed message.
+     */
+    bool parse(const char *data, int size) {
+        m_attributeCount = 0;
+        m_children.clear();
+        m_flat = true;
+        m_tag = XmlSlice();
+        m_pos = data;
+        m_end = data + size;
+
+        skipSpace();
+        if (startsWith("<?")) {
+            const char *declarationEnd = find("?>");
+            if (!declarationEnd) return false;
+            m_pos = declarationEnd + 2;
+            skipSpace();
+        }
+        if (!consume('<')) return false;
+        m_tag = readName();
+        if (m_tag.size == 0) return false;
+        bool selfClosing = false;
+        if (!readAttributes(nullptr, selfClosing)) return false;
+        if (selfClosing) return trailingSpaceOnly();
+
+        while (true) {
+            skipSpace();
+            if (startsWith("</")) {
+                m_pos += 2;
+                if (!consumeName(m_tag) || !consume('>')) return false;
+                return trailingSpaceOnly();
+            }
+            if (!consume('<')) return false;
+            const XmlSlice childName = readName();
+            if (childName.size == 0) return false;
+            Child child{childName, XmlSlice(), XmlSlice()};
+            bool childClosed = false;
+            if (!readAttributes(&child, childClosed)) return false;
+            if (childClosed) {
+                child.text = XmlSlice{m_pos, 0};
+                m_children.push_back(child);
+                continue;
+            }
+            const char *textStart = m_pos;
+            while (m_pos < m_end && *m_pos != '<') ++m_pos;
+            if (startsWith("</")) {
+                child.text = XmlSlice{textStart, static_cast<int>(m_pos - textStart)};
+                m_pos += 2;
+                if (!consumeName(childName) || !consume('>')) return false;
+                m_children.push_back(child);
+                continue;
+            }
+            // Nested elements: only check that the root element is closed at the end of the line
+            m_flat = false;
+            return closesWith(m_tag);
+        }
+    }
+
+    /**
+     * @brief Name of the root element, e.g. "command" or "event".
+     */
+    XmlSlice tag() const { return m_tag; }
+
+    /**
+     * @brief Check whether all children of the root element were split.
+     * @return False for messages with nested elements.
+     */
+    bool isFlat() const { return m_flat; }
+
+    /**
+     * @brief Look up an attribute of the root element.
+     * @param name Attribute name.
+     * @return The raw attribute value, a null slice if it is missing.
+     */
+    XmlSlice attribute(const char *name) const {
+        for (int i = 0; i < m_attributeCount; ++i) {
+            if (m_attributes[i].name == name) return m_attributes[i].value;
+        }
+        return XmlSlice();
+    }
+
+    /**
+     * @brief Look up the text of a child element of the root element.
+     * @param name Element name.
+     * @return The raw element text, a null slice if it is missing.
+     */
+    XmlSlice child(const char *name) const {
+        for (const Child &child : m_children) {
+            if (child.tag == name) return child.text;
+        }
+        return XmlSlice();
+    }
+
+    /**
+     * @brief All text-only children of the root element, in document order.
+     */
+    const std::vector<Child> &children() const { return m_children; }
+
+   private:
+    struct Field {
+        XmlSlice name;
+        XmlSlice value;
+    };
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static bool isNameChar(char c) { return !isSpace(c) && c != '>' && c != '/' && c != '=' && c != '<'; }
+
+    void skipSpace() {
+        while (m_pos < m_end && isSpace(*m_pos)) ++m_pos;
+    }
+
+    bool startsWith(const char *text) const {
+        const size_t length = std::strlen(text);
+        return static_cast<size_t>(m_end - m_pos) >= length && std::memcmp(m_pos, text, length) == 0;
+    }
+
+    const char *find(const char *text) const {
+        const size_t length = std::strlen(text);
+        for (const char *p = m_pos; static_cast<size_t>(m_end - p) >= length; ++p) {
+            if (std::memcmp(p, text, length) == 0) return p;
+        }
+        return nullptr;
+    }
+
+    bool consume(char c) {
+        if (m_pos >= m_end || *m_pos != c) return false;
+        ++m_pos;
+        return true;
+    }
+
+    XmlSlice readName() {
+        const char *start = m_pos;
+        while (m_pos < m_end && isNameChar(*m_pos)) ++m_pos;
+        return XmlSlice{start, static_cast<int>(m_pos - start)};
+    }
+
+    bool consumeName(const XmlSlice &name) {
+        const XmlSlice closing = readName();
+        skipSpace();
+        return closing.size == name.size && std::memcmp(closing.data, name.data, static_cast<size_t>(name.size)) == 0;
+    }
+
+    /**
+     * @brief Read the attributes of a start tag up to and including its '>'.
+     * @param child Child whose "name" attribute is kept, or nullptr to store the attributes of the root element.
+     * @param selfClosing Set to true for "<tag/>".
+     * @return False on malformed input.
+     */
+    bool readAttributes(Child *child, bool &selfClosing) {
+        while (true) {
+            skipSpace();
+            if (consume('>')) return true;
+            if (startsWith("/>")) {
+                m_pos += 2;
+                selfClosing = true;
+                return true;
+            }
+            const XmlSlice name = readName();
+            skipSpace();
+            if (name.size == 0 || !consume('=')) return false;
+            skipSpace();
+            if (m_pos >= m_end || (*m_pos != '"' && *m_pos != '\'')) return false;
+            const char quote = *m_pos++;
+            const char *valueStart = m_pos;
+            while (m_pos < m_end && *m_pos != quote) ++m_pos;
+            if (m_pos >= m_end) return false;
+            const XmlSlice value{valueStart, static_cast<int>(m_pos - valueStart)};
+            ++m_pos;
+            if (child) {
+                if (name == "name") child->name = value;
+            } else if (m_attributeCount < MAX_ATTRIBUTES) {
+                m_attributes[m_attributeCount++] = Field{name, value};
+            }
+        }
+    }
+
+    bool trailingSpaceOnly() {
+        skipSpace();
+        return m_pos == m_end;
+    }
+
+    bool closesWith(const XmlSlice &tag) {
+        const char *end = m_end;
+        while (end > m_pos && isSpace(end[-1])) --end;
+        const int closingSize = tag.size + 3;
+        return end - m_pos >= closingSize && end[-1] == '>' && end[-closingSize] == '<' &&
+               end[-closingSize + 1] == '/' &&
+               std::memcmp(end - closingSize + 2, tag.data, static_cast<size_t>(tag.size)) == 0;
+    }
+
+    XmlSlice m_tag;
+    Field m_attributes[MAX_ATTRIBUTES];
+    std::vector<Child> m_children;
+    int m_attributeCount = 0;
+    bool m_flat = true;
+    const char *m_pos = nullptr;
+    const char *m_end = nullptr;
+};
+
+/**
+ * @brief Reads newline-terminated messages from a device into a reused buffer.
+ *
+ * Incomplete lines stay in the device until their terminator arrives, so a message split across several TCP reads
+ * is only handed out once it is complete. The buffer grows to the longest line seen and is then reused, reading a
+ * line does not allocate.
+ */
+class XmlLineReader {
+   public:
+    /**
+     * @brief Read the next complete line from a device.
+     * @param device Device to read from.
+     * @return False if no complete line is buffered in the device.
+     */
+    bool readLine(QIODevice *device) {
+        if (!device->canReadLine()) return false;
+        if (m_buffer.size() < 256) m_buffer.resize(256);
+        m_size = 0;
+        while (true) {
+            const qint64 read = device->readLine(m_buffer.data() + m_size, m_buffer.size() - m_size);
+            if (read <= 0) break;
+            m_size += static_cast<int>(read);
+            if (m_buffer[m_size - 1] == '\n') break;
+            m_buffer.resize(m_buffer.size() * 2);
+        }
+        while (m_size > 0 && (m_buffer[m_size - 1] == '\n' || m_buffer[m_size - 1] == '\r')) --m_size;
+        return true;
+    }
+
+    /**
+     * @brief Start of the last line read, without the terminator.
+     */
+    const char *data() const { return m_buffer.constData(); }
+
+    /**
+     * @brief Length of the last line read, without the terminator.
+     */
+    int size() const { return m_size; }
+
+    /**
+     * @brief The last line read as a view.
+     */
+    XmlSlice line() const { return XmlSlice{m_buffer.constData(), m_size}; }
+
+   private:
+    QByteArray m_buffer;
+    int m_size = 0;
+};
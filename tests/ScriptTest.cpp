@@ -0,0 +1,162 @@
+/**
+ * @file ScriptTest.cpp
+ * @brief Tests of the Script class, checking that interpreted code behaves like the compiled C++ would.
+ *
+ * @author xcsirim00
+ * @date 08-05-2025
+ */
+
+#include <QtTest/QtTest>
+#include <stdexcept>
+
+#include "backend/Script.hpp"
+
+class ScriptTest : public QObject {
+    Q_OBJECT
+
+   private:
+    /**
+     * @brief Compile and run a script, failing the test if it does not compile.
+     *
+     * @param source Code of the script.
+     * @param mode Whether the source is an expression or statements.
+     * @param variables Machine variables, named a, b, c, ... in order.
+     * @param result Result of the script, left invalid if it does not compile.
+     */
+    void run(const QString &source, Script::Mode mode, QVector<QVariant> &variables, QVariant &result) {
+        QStringList names;
+        for (int i = 0; i < variables.size(); ++i) {
+            names << QString(QChar('a' + i));
+        }
+        Script script;
+        QString error;
+        result = QVariant();
+        QVERIFY2(script.compile(source, names, mode, error), qPrintable(source + ": " + error));
+        result = script.run(variables);
+    }
+
+    void evaluate(const QString &source, QVariant &result) {
+        QVector<QVariant> none;
+        run(source, Script::Expression, none, result);
+    }
+
+    void execute(const QString &source, QVariant &result) {
+        QVector<QVariant> none;
+        run(source, Script::Statements, none, result);
+    }
+
+   private slots:
+    void initializers() {
+        QVariant result;
+        evaluate("false", result);
+        QCOMPARE(Script::coerce(result, Script::typeOf("bool")), QVariant(false));
+        evaluate("\"abc\"", result);
+        QCOMPARE(Script::coerce(result, Script::typeOf("QString")), QVariant(QString("abc")));
+        evaluate("2*1000", result);
+        QCOMPARE(Script::coerce(result, Script::typeOf("int")), QVariant(2000));
+        evaluate("1.5", result);
+        QCOMPARE(Script::coerce(result, Script::typeOf("int")), QVariant(1));
+    }
+
+    void uninitializedLocals() {
+        QVariant result;
+        execute("QString s; return s.isEmpty();", result);
+        QCOMPARE(result, QVariant(true));
+        execute("QString s; return s + \"x\";", result);
+        QCOMPARE(result.toString(), QString("x"));
+        execute("int n; return n;", result);
+        QCOMPARE(result, QVariant(0));
+        execute("bool f; return f;", result);
+        QCOMPARE(result, QVariant(false));
+    }
+
+    void stdString() {
+        QVariant result;
+        execute("std::string s = \"abc\"; return s;", result);
+        QCOMPARE(result.toString(), QString("abc"));
+        execute("const std::string s; return s.isEmpty();", result);
+        QCOMPARE(result, QVariant(true));
+    }
+
+    void integerAndDoubleArithmetic() {
+        QVariant result;
+        evaluate("7 / 2", result);
+        QCOMPARE(result.toInt(), 3);
+        evaluate("7 / 2.0", result);
+        QCOMPARE(result.toDouble(), 3.5);
+        evaluate("7 % 3", result);
+        QCOMPARE(result.toInt(), 1);
+        evaluate("-7 / 2", result);
+        QCOMPARE(result.toInt(), -3);
+        execute("int n = 7.9; return n;", result);
+        QCOMPARE(result.toInt(), 7);
+        execute("double d = 7; return d / 2;", result);
+        QCOMPARE(result.toDouble(), 3.5);
+        QVERIFY_EXCEPTION_THROWN(evaluate("1 / 0", result), std::runtime_error);
+    }
+
+    void shortCircuit() {
+        QVariant result;
+        evaluate("false && 1 / 0", result);
+        QCOMPARE(result, QVariant(false));
+        evaluate("true || 1 / 0", result);
+        QCOMPARE(result, QVariant(true));
+        evaluate("true ? 1 : 1 / 0", result);
+        QCOMPARE(result.toInt(), 1);
+
+        QVector<QVariant> variables = {0};
+        run("false && a++", Script::Expression, variables, result);
+        QCOMPARE(variables[0].toInt(), 0);
+        run("true && a++", Script::Expression, variables, result);
+        QCOMPARE(variables[0].toInt(), 1);
+    }
+
+    void incrementAndDecrement() {
+        QVariant result;
+        QVector<QVariant> variables = {1};
+        run("a++", Script::Expression, variables, result);
+        QCOMPARE(result.toInt(), 1);
+        QCOMPARE(variables[0].toInt(), 2);
+        run("++a", Script::Expression, variables, result);
+        QCOMPARE(result.toInt(), 3);
+        run("a--", Script::Expression, variables, result);
+        QCOMPARE(result.toInt(), 3);
+        run("--a", Script::Expression, variables, result);
+        QCOMPARE(result.toInt(), 1);
+        execute("int i = 5; i++; ++i; i--; return i;", result);
+        QCOMPARE(result.toInt(), 6);
+    }
+
+    void numberFormatting() {
+        QVariant result;
+        evaluate("QString::number(1.0 / 3)", result);
+        QCOMPARE(result.toString(), QString::number(1.0 / 3));
+        evaluate("QString::number(2.5e10)", result);
+        QCOMPARE(result.toString(), QString::number(2.5e10));
+        evaluate("QString::number(1234567)", result);
+        QCOMPARE(result.toString(), QString("1234567"));
+        evaluate("QString::number(true)", result);
+        QCOMPARE(result.toString(), QString("1"));
+    }
+
+    void writtenVariables() {
+        Script script;
+        QString error;
+        QVERIFY(script.compile("int x = b; a = x + 1; c++; if (b > 0) { d += 2; }", {"a", "b", "c", "d"},
+                               Script::Statements, error));
+        QCOMPARE(script.writtenVariables(), QVector<int>({0, 2, 3}));
+
+        QVERIFY(script.compile("a > b && c == 1", {"a", "b", "c"}, Script::Expression, error));
+        QVERIFY(script.writtenVariables().isEmpty());
+    }
+
+    void rejectsUnknownCode() {
+        Script script;
+        QString error;
+        QVERIFY(!script.compile("x + 1", {}, Script::Expression, error));
+        QVERIFY(!error.isEmpty());
+    }
+};
+
+QTEST_APPLESS_MAIN(ScriptTest)
+#include "ScriptTest.moc"